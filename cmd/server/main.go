@@ -1,6 +1,7 @@
 package main
 
 import (
+	"context"
 	"fmt"
 	"log"
 	"net"
@@ -9,11 +10,15 @@ import (
 	"os/signal"
 	"strconv"
 	"syscall"
+	"time"
 
 	"md2docx/internal/api"
 	"md2docx/internal/config"
 )
 
+// shutdownTimeout 关闭时等待进行中请求的最长时间
+const shutdownTimeout = 10 * time.Second
+
 // 版本信息，在构建时通过ldflags注入
 var (
 	Version   = "dev"
@@ -35,39 +40,70 @@ func main() {
 		log.Fatalf("加载配置失败: %v", err)
 	}
 
-	// 检查是否通过环境变量指定端口
-	if envPort := os.Getenv("SERVER_PORT"); envPort != "" {
-		if port, err := strconv.Atoi(envPort); err == nil && port > 0 {
-			cfg.ServerPort = port
+	// 前端启动多个后端进程时通过MD2DOCX_MAX_WORKERS分摊CPU
+	if envWorkers := os.Getenv("MD2DOCX_MAX_WORKERS"); envWorkers != "" {
+		if workers, err := strconv.Atoi(envWorkers); err == nil && workers > 0 {
+			cfg.WorkerLimit = workers
 		}
 	}
 
-	// 如果端口为0或被占用，动态分配端口
-	if cfg.ServerPort == 0 || !isPortAvailable(cfg.ServerPort) {
-		availablePort, err := findAvailablePort()
-		if err != nil {
-			log.Fatalf("无法找到可用端口: %v", err)
+	// 同一前端启动的多个后端通过MD2DOCX_INSTANCE区分，各自使用独立的缓存和历史耗时文件
+	if envInstance := os.Getenv("MD2DOCX_INSTANCE"); envInstance != "" {
+		if instance, err := strconv.Atoi(envInstance); err == nil && instance > 0 {
+			cfg.Instance = instance
 		}
-		cfg.ServerPort = availablePort
+	}
 
-		// 保存新端口到配置文件
-		if err := cfg.Save(); err != nil {
-			log.Printf("警告: 无法保存端口配置: %v", err)
-		} else {
-			log.Printf("端口配置已保存: %d", cfg.ServerPort)
+	// 前端通过MD2DOCX_SOCKET指定Unix域套接字时不占用TCP端口
+	socketPath := os.Getenv("MD2DOCX_SOCKET")
+
+	// 前端通过SERVER_PORT=0要求由系统分配端口，实际端口通过READY行告知，无需探测和保存
+	ephemeralPort := false
+
+	if socketPath == "" {
+		// 检查是否通过环境变量指定端口
+		if envPort := os.Getenv("SERVER_PORT"); envPort != "" {
+			if port, err := strconv.Atoi(envPort); err == nil && port >= 0 {
+				cfg.ServerPort = port
+				ephemeralPort = port == 0
+			}
 		}
-	} else {
-		// 即使端口可用，也保存配置文件以确保前端能读取
-		if err := cfg.Save(); err != nil {
-			log.Printf("警告: 无法保存端口配置: %v", err)
+
+		// 如果端口为0或被占用，动态分配端口
+		if ephemeralPort {
+			// 监听时由系统分配
+		} else if cfg.ServerPort == 0 || !isPortAvailable(cfg.ServerPort) {
+			availablePort, err := findAvailablePort()
+			if err != nil {
+				log.Fatalf("无法找到可用端口: %v", err)
+			}
+			cfg.ServerPort = availablePort
+
+			// 保存新端口到配置文件
+			if err := cfg.Save(); err != nil {
+				log.Printf("警告: 无法保存端口配置: %v", err)
+			} else {
+				log.Printf("端口配置已保存: %d", cfg.ServerPort)
+			}
 		} else {
-			log.Printf("端口配置已保存: %d", cfg.ServerPort)
+			// 即使端口可用，也保存配置文件以确保前端能读取
+			if err := cfg.Save(); err != nil {
+				log.Printf("警告: 无法保存端口配置: %v", err)
+			} else {
+				log.Printf("端口配置已保存: %d", cfg.ServerPort)
+			}
 		}
 	}
 
 	// 打印启动信息
 	fmt.Printf("=== Markdown转Word工具服务器 ===\n")
-	fmt.Printf("服务器端口: %d\n", cfg.ServerPort)
+	if socketPath != "" {
+		fmt.Printf("服务器套接字: %s\n", socketPath)
+	} else if ephemeralPort {
+		fmt.Printf("服务器端口: 由系统分配\n")
+	} else {
+		fmt.Printf("服务器端口: %d\n", cfg.ServerPort)
+	}
 	fmt.Printf("Pandoc路径: %s\n", cfg.PandocPath)
 	if cfg.TemplateFile != "" {
 		fmt.Printf("模板文件: %s\n", cfg.TemplateFile)
@@ -82,28 +118,50 @@ func main() {
 		fmt.Printf("Pandoc配置验证成功\n")
 	}
 
-	// 设置路由
-	mux := api.SetupRoutes(cfg)
+	listener, err := listen(cfg.ServerPort, socketPath)
+	if err != nil {
+		log.Fatalf("服务器启动失败: %v", err)
+	}
+
+	if addr, ok := listener.Addr().(*net.TCPAddr); ok {
+		cfg.ServerPort = addr.Port
+	}
+
+	// 设置路由（此后cfg作为配置快照发布，不再直接修改）
+	handler := api.New(cfg)
+	defer handler.Close()
+	mux := api.NewRouter(handler)
 
 	// 创建HTTP服务器
 	server := &http.Server{
-		Addr:    fmt.Sprintf(":%d", cfg.ServerPort),
 		Handler: mux,
 	}
 
+	baseURL := fmt.Sprintf("http://localhost:%d", cfg.ServerPort)
+	if socketPath != "" {
+		baseURL = "unix:" + socketPath
+	}
+
+	// 监听建立后立即通知前端，连接会在Serve开始前排队等待
+	fmt.Println(readyLine(listener))
+
 	// 启动服务器
 	go func() {
-		fmt.Printf("服务器启动成功，监听端口 %d\n", cfg.ServerPort)
+		fmt.Printf("服务器启动成功，监听地址 %s\n", listener.Addr())
 		fmt.Printf("API文档:\n")
-		fmt.Printf("  健康检查: GET  http://localhost:%d/api/health\n", cfg.ServerPort)
-		fmt.Printf("  获取配置: GET  http://localhost:%d/api/config\n", cfg.ServerPort)
-		fmt.Printf("  更新配置: POST http://localhost:%d/api/config\n", cfg.ServerPort)
-		fmt.Printf("  验证配置: POST http://localhost:%d/api/config/validate\n", cfg.ServerPort)
-		fmt.Printf("  单文件转换: POST http://localhost:%d/api/convert/single\n", cfg.ServerPort)
-		fmt.Printf("  批量转换: POST http://localhost:%d/api/convert/batch\n", cfg.ServerPort)
+		fmt.Printf("  健康检查: GET  %s/api/health\n", baseURL)
+		fmt.Printf("  获取配置: GET  %s/api/config\n", baseURL)
+		fmt.Printf("  更新配置: POST %s/api/config\n", baseURL)
+		fmt.Printf("  验证配置: POST %s/api/config/validate\n", baseURL)
+		fmt.Printf("  单文件转换: POST %s/api/convert/single\n", baseURL)
+		fmt.Printf("  批量转换: POST %s/api/convert/batch\n", baseURL)
+		fmt.Printf("  流式批量转换: POST %s/api/convert/batch/stream\n", baseURL)
+		fmt.Printf("  提交任务: POST %s/api/jobs\n", baseURL)
+		fmt.Printf("  任务状态: GET  %s/api/jobs/{id}\n", baseURL)
+		fmt.Printf("  取消任务: DELETE %s/api/jobs/{id}\n", baseURL)
 		fmt.Printf("按 Ctrl+C 停止服务器\n")
 
-		if err := server.ListenAndServe(); err != nil && err != http.ErrServerClosed {
+		if err := server.Serve(listener); err != nil && err != http.ErrServerClosed {
 			log.Fatalf("服务器启动失败: %v", err)
 		}
 	}()
@@ -111,13 +169,65 @@ func main() {
 	// 等待中断信号
 	quit := make(chan os.Signal, 1)
 	signal.Notify(quit, syscall.SIGINT, syscall.SIGTERM)
+
+	// 由前端启动时通过标准输入输出推送状态变化，前端退出（标准输入关闭）时随之退出
+	if os.Getenv("MD2DOCX_HEARTBEAT") == "1" {
+		go handler.ServeHeartbeat(os.Stdin, os.Stdout, func() {
+			quit <- syscall.SIGTERM
+		})
+	}
+
 	<-quit
 
 	fmt.Println("\n正在关闭服务器...")
-	if err := server.Close(); err != nil {
-		log.Printf("服务器关闭失败: %v", err)
-	} else {
-		fmt.Println("服务器已关闭")
+	handler.Drain()
+
+	// 等待进行中的请求完成，超时后强制关闭
+	ctx, cancel := context.WithTimeout(context.Background(), shutdownTimeout)
+	defer cancel()
+	if err := server.Shutdown(ctx); err != nil {
+		log.Printf("等待请求完成超时，强制关闭: %v", err)
+		server.Close()
+	}
+	fmt.Println("服务器已关闭")
+}
+
+// listen 创建监听器：指定套接字路径时监听Unix域套接字，否则监听TCP端口
+func listen(port int, socketPath string) (net.Listener, error) {
+	if socketPath == "" {
+		return net.Listen("tcp", fmt.Sprintf(":%d", port))
+	}
+
+	// 清理上次异常退出遗留的套接字文件，其他类型的文件不动
+	if info, err := os.Lstat(socketPath); err == nil {
+		if info.Mode()&os.ModeSocket == 0 {
+			return nil, fmt.Errorf("套接字路径已被占用: %s", socketPath)
+		}
+		if err := os.Remove(socketPath); err != nil {
+			return nil, fmt.Errorf("无法删除旧的套接字文件: %v", err)
+		}
+	}
+
+	listener, err := net.Listen("unix", socketPath)
+	if err != nil {
+		return nil, err
+	}
+	// 只允许当前用户连接
+	if err := os.Chmod(socketPath, 0600); err != nil {
+		listener.Close()
+		return nil, fmt.Errorf("无法设置套接字权限: %v", err)
+	}
+	return listener, nil
+}
+
+// readyLine 生成供前端解析的就绪行，格式为 "READY port=<端口> pid=<进程号>"，
+// 监听Unix域套接字时为 "READY socket=<路径> pid=<进程号>"
+func readyLine(listener net.Listener) string {
+	switch addr := listener.Addr().(type) {
+	case *net.TCPAddr:
+		return fmt.Sprintf("READY port=%d pid=%d", addr.Port, os.Getpid())
+	default:
+		return fmt.Sprintf("READY socket=%s pid=%d", addr.String(), os.Getpid())
 	}
 }
 
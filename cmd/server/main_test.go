@@ -0,0 +1,72 @@
+package main
+
+import (
+	"fmt"
+	"net"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+func TestListenEphemeralPortReady(t *testing.T) {
+	listener, err := listen(0, "")
+	if err != nil {
+		t.Fatalf("监听失败: %v", err)
+	}
+	defer listener.Close()
+
+	port := listener.Addr().(*net.TCPAddr).Port
+	if port == 0 {
+		t.Fatal("系统未分配端口")
+	}
+	want := fmt.Sprintf("READY port=%d pid=%d", port, os.Getpid())
+	if got := readyLine(listener); got != want {
+		t.Errorf("就绪行 = %q, 期望 %q", got, want)
+	}
+}
+
+func TestListenUnixSocket(t *testing.T) {
+	socketPath := filepath.Join(t.TempDir(), "server.sock")
+
+	// 遗留的套接字文件应被清理
+	stale, err := net.Listen("unix", socketPath)
+	if err != nil {
+		t.Skipf("不支持Unix域套接字: %v", err)
+	}
+	stale.(*net.UnixListener).SetUnlinkOnClose(false)
+	stale.Close()
+
+	listener, err := listen(0, socketPath)
+	if err != nil {
+		t.Fatalf("监听失败: %v", err)
+	}
+	defer listener.Close()
+
+	info, err := os.Stat(socketPath)
+	if err != nil {
+		t.Fatalf("套接字文件不存在: %v", err)
+	}
+	if perm := info.Mode().Perm(); perm != 0600 {
+		t.Errorf("套接字权限 = %o, 期望 600", perm)
+	}
+
+	want := fmt.Sprintf("READY socket=%s pid=%d", socketPath, os.Getpid())
+	if got := readyLine(listener); got != want {
+		t.Errorf("就绪行 = %q, 期望 %q", got, want)
+	}
+}
+
+func TestListenRefusesNonSocketPath(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "server.sock")
+	if err := os.WriteFile(path, []byte("data"), 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	if listener, err := listen(0, path); err == nil {
+		listener.Close()
+		t.Fatal("普通文件不应被当作套接字删除")
+	}
+	if _, err := os.Stat(path); err != nil {
+		t.Errorf("普通文件被删除: %v", err)
+	}
+}
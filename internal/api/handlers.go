@@ -1,30 +1,89 @@
 package api
 
 import (
+	"context"
 	"encoding/json"
+	"errors"
 	"fmt"
+	"io"
+	"mime"
 	"net/http"
+	"strconv"
 	"strings"
+	"sync"
+	"time"
 
 	"md2docx/internal/config"
 	"md2docx/internal/converter"
+	"md2docx/internal/jobs"
 	"md2docx/internal/models"
+	"md2docx/pkg/utils"
 )
 
 // Handler API处理器
 type Handler struct {
 	converter *converter.Converter
-	config    *config.Config
+	config    *config.Store // 与转换器共享的配置快照
+	jobs      *jobs.Manager
+	state     *stateTracker
 }
 
 // New 创建新的API处理器
 func New(cfg *config.Config) *Handler {
+	store := config.NewStore(cfg)
+	conv := converter.NewWithStore(store)
 	return &Handler{
-		converter: converter.New(cfg),
-		config:    cfg,
+		converter: conv,
+		config:    store,
+		jobs:      jobs.NewManager(conv),
+		state:     newStateTracker(store),
 	}
 }
 
+// track 统计进行中的转换请求，用于判断服务是否过载
+func (h *Handler) track(next http.HandlerFunc) http.HandlerFunc {
+	return func(w http.ResponseWriter, r *http.Request) {
+		h.state.begin()
+		defer h.state.end()
+		next(w, r)
+	}
+}
+
+// DeadlineHeader 请求的截止时间（Unix毫秒时间戳），超过后结果不再有人读取
+const DeadlineHeader = "X-Request-Deadline"
+
+// withDeadline 按请求头中的截止时间限制转换：已过期的请求直接拒绝，
+// 未过期的请求在截止时间到达时取消，排队中的文件退出队列，运行中的pandoc进程被结束
+func (h *Handler) withDeadline(next http.HandlerFunc) http.HandlerFunc {
+	return func(w http.ResponseWriter, r *http.Request) {
+		value := r.Header.Get(DeadlineHeader)
+		if value == "" {
+			next(w, r)
+			return
+		}
+
+		millis, err := strconv.ParseInt(value, 10, 64)
+		if err != nil || millis <= 0 {
+			h.sendErrorResponse(w, "截止时间格式错误", fmt.Errorf("%s 应为Unix毫秒时间戳: %q", DeadlineHeader, value), http.StatusBadRequest)
+			return
+		}
+		deadline := time.UnixMilli(millis)
+		if !time.Now().Before(deadline) {
+			h.sendErrorResponse(w, "请求已超过截止时间", fmt.Errorf("截止时间 %s 已过", deadline.Format(time.RFC3339Nano)), http.StatusGatewayTimeout)
+			return
+		}
+
+		ctx, cancel := context.WithDeadline(r.Context(), deadline)
+		defer cancel()
+		next(w, r.WithContext(ctx))
+	}
+}
+
+// Drain 标记服务正在关闭，通过心跳通知前端
+func (h *Handler) Drain() {
+	h.state.drain()
+}
+
 // ConvertSingle 单文件转换接口
 func (h *Handler) ConvertSingle(w http.ResponseWriter, r *http.Request) {
 	if r.Method != http.MethodPost {
@@ -39,7 +98,11 @@ func (h *Handler) ConvertSingle(w http.ResponseWriter, r *http.Request) {
 	}
 
 	// 执行转换
-	response, err := h.converter.ConvertSingle(&req)
+	// 客户端断开连接时取消转换
+	response, err := h.converter.ConvertSingleContext(r.Context(), &req)
+	if h.rejectIfBusy(w, err) {
+		return
+	}
 	if err != nil {
 		h.sendErrorResponse(w, "转换服务内部错误", err, http.StatusInternalServerError)
 		return
@@ -61,8 +124,12 @@ func (h *Handler) ConvertBatch(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	if h.rejectIfBusy(w, h.converter.CheckBulkAdmission()) {
+		return
+	}
+
 	// 执行批量转换
-	response, err := h.converter.ConvertBatch(&req)
+	response, err := h.converter.ConvertBatchContext(r.Context(), &req, nil)
 	if err != nil {
 		h.sendErrorResponse(w, "转换服务内部错误", err, http.StatusInternalServerError)
 		return
@@ -71,6 +138,215 @@ func (h *Handler) ConvertBatch(w http.ResponseWriter, r *http.Request) {
 	h.sendJSONResponse(w, response, http.StatusOK)
 }
 
+// ConvertBatchStream 流式批量转换接口
+// 响应为NDJSON：每完成一个文件输出一行item事件，全部结束后输出done事件
+func (h *Handler) ConvertBatchStream(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "只支持POST方法", http.StatusMethodNotAllowed)
+		return
+	}
+
+	var req models.BatchConversionRequest
+	if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+		h.sendErrorResponse(w, "请求参数解析失败", err, http.StatusBadRequest)
+		return
+	}
+
+	// 开始输出事件流之前完成准入判断，排队已满时仍可返回429
+	if h.rejectIfBusy(w, h.converter.CheckBulkAdmission()) {
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/x-ndjson")
+	w.Header().Set("Cache-Control", "no-cache")
+	w.WriteHeader(http.StatusOK)
+
+	// 多个工作协程会并发回调，写入时需要加锁
+	flusher, _ := w.(http.Flusher)
+	encoder := json.NewEncoder(w)
+	var mu sync.Mutex
+	sendEvent := func(event models.BatchStreamEvent) {
+		mu.Lock()
+		defer mu.Unlock()
+		encoder.Encode(event)
+		if flusher != nil {
+			flusher.Flush()
+		}
+	}
+
+	total := len(req.InputFiles)
+	response, err := h.converter.ConvertBatchContext(r.Context(), &req, func(index int, result models.ConversionResult) {
+		sendEvent(models.BatchStreamEvent{Event: "item", Index: index, Total: total, Result: &result})
+	})
+	if err != nil {
+		response = &models.ConversionResponse{
+			Success: false,
+			Message: "转换服务内部错误",
+			Error:   err.Error(),
+		}
+	}
+
+	sendEvent(models.BatchStreamEvent{Event: "done", Total: total, Response: response})
+}
+
+// docxContentType Word文档的MIME类型
+const docxContentType = "application/vnd.openxmlformats-officedocument.wordprocessingml.document"
+
+// maxStreamImageBytes 流式转换中上传图片的总大小上限
+const maxStreamImageBytes = 64 << 20
+
+// ConvertStream 流式转换接口，不经过文件系统
+//
+// 请求体为Markdown文本；需要图片时使用multipart/form-data：
+// 名为image的文件部分按文件名匹配文档中的图片引用，名为markdown的部分为文档内容，
+// 图片部分必须位于markdown部分之前，markdown之后的部分被忽略。
+// Markdown边读边送入pandoc标准输入，pandoc的标准输出直接作为docx响应返回。
+// 可选查询参数name指定下载文件名（不含扩展名）。
+func (h *Handler) ConvertStream(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "只支持POST方法", http.StatusMethodNotAllowed)
+		return
+	}
+
+	markdown := io.Reader(r.Body)
+	var images map[string]converter.StreamImage
+
+	if mediaType, _, _ := mime.ParseMediaType(r.Header.Get("Content-Type")); mediaType == "multipart/form-data" {
+		reader, err := r.MultipartReader()
+		if err != nil {
+			h.sendErrorResponse(w, "请求参数解析失败", err, http.StatusBadRequest)
+			return
+		}
+
+		markdown = nil
+		images = make(map[string]converter.StreamImage)
+		var imageBytes int64
+		for markdown == nil {
+			part, err := reader.NextPart()
+			if err == io.EOF {
+				break
+			}
+			if err != nil {
+				h.sendErrorResponse(w, "请求参数解析失败", err, http.StatusBadRequest)
+				return
+			}
+
+			switch part.FormName() {
+			case "markdown":
+				markdown = part
+			case "image":
+				data, err := io.ReadAll(io.LimitReader(part, maxStreamImageBytes-imageBytes+1))
+				if err != nil {
+					h.sendErrorResponse(w, "读取图片失败", err, http.StatusBadRequest)
+					return
+				}
+				imageBytes += int64(len(data))
+				if imageBytes > maxStreamImageBytes {
+					h.sendErrorResponse(w, "图片过大", fmt.Errorf("图片总大小超过%dMB", maxStreamImageBytes>>20), http.StatusRequestEntityTooLarge)
+					return
+				}
+				images[part.FileName()] = converter.StreamImage{
+					ContentType: converter.ImageContentType(part.FileName(), part.Header.Get("Content-Type")),
+					Data:        data,
+				}
+			}
+		}
+		if markdown == nil {
+			h.sendErrorResponse(w, "请求参数解析失败", fmt.Errorf("缺少markdown部分"), http.StatusBadRequest)
+			return
+		}
+	}
+
+	name := utils.SanitizeFileName(r.URL.Query().Get("name"))
+	if name == "" {
+		name = "document"
+	}
+
+	started := false
+	err := h.converter.ConvertStream(r.Context(), markdown, images, func() io.Writer {
+		started = true
+		w.Header().Set("Content-Type", docxContentType)
+		w.Header().Set("Content-Disposition", mime.FormatMediaType("attachment", map[string]string{"filename": name + ".docx"}))
+		w.WriteHeader(http.StatusOK)
+		return w
+	})
+	if err == nil {
+		return
+	}
+	if started {
+		// 响应已经开始，中断连接让客户端知道输出不完整
+		panic(http.ErrAbortHandler)
+	}
+	if h.rejectIfBusy(w, err) {
+		return
+	}
+
+	status := http.StatusInternalServerError
+	if r.Context().Err() == context.DeadlineExceeded {
+		status = http.StatusGatewayTimeout
+	}
+	h.sendErrorResponse(w, "转换失败", err, status)
+}
+
+// SubmitJob 提交异步批量转换任务接口
+func (h *Handler) SubmitJob(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "只支持POST方法", http.StatusMethodNotAllowed)
+		return
+	}
+
+	var req models.BatchConversionRequest
+	if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+		h.sendErrorResponse(w, "请求参数解析失败", err, http.StatusBadRequest)
+		return
+	}
+
+	status, err := h.jobs.Submit(&req)
+	if err != nil {
+		h.sendErrorResponse(w, "提交任务失败", err, http.StatusInternalServerError)
+		return
+	}
+
+	h.sendJSONResponse(w, status, http.StatusAccepted)
+}
+
+// GetJob 查询异步任务状态接口
+func (h *Handler) GetJob(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		http.Error(w, "只支持GET方法", http.StatusMethodNotAllowed)
+		return
+	}
+
+	status, ok := h.jobs.Get(jobIDFromPath(r.URL.Path))
+	if !ok {
+		h.sendErrorResponse(w, "任务不存在", fmt.Errorf("未找到任务: %s", jobIDFromPath(r.URL.Path)), http.StatusNotFound)
+		return
+	}
+
+	h.sendJSONResponse(w, status, http.StatusOK)
+}
+
+// CancelJob 取消异步任务接口
+func (h *Handler) CancelJob(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodDelete {
+		http.Error(w, "只支持DELETE方法", http.StatusMethodNotAllowed)
+		return
+	}
+
+	status, ok := h.jobs.Cancel(jobIDFromPath(r.URL.Path))
+	if !ok {
+		h.sendErrorResponse(w, "任务不存在", fmt.Errorf("未找到任务: %s", jobIDFromPath(r.URL.Path)), http.StatusNotFound)
+		return
+	}
+
+	h.sendJSONResponse(w, status, http.StatusOK)
+}
+
+// jobIDFromPath 从 /api/jobs/{id} 中提取任务ID
+func jobIDFromPath(path string) string {
+	return strings.Trim(strings.TrimPrefix(path, "/api/jobs/"), "/")
+}
+
 // GetConfig 获取配置接口
 func (h *Handler) GetConfig(w http.ResponseWriter, r *http.Request) {
 	if r.Method != http.MethodGet {
@@ -78,11 +354,12 @@ func (h *Handler) GetConfig(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	cfg := h.config.Load()
 	response := &models.ConfigResponse{
 		Success:      true,
 		Message:      "获取配置成功",
-		PandocPath:   h.config.PandocPath,
-		TemplateFile: h.config.TemplateFile,
+		PandocPath:   cfg.PandocPath,
+		TemplateFile: cfg.TemplateFile,
 	}
 
 	h.sendJSONResponse(w, response, http.StatusOK)
@@ -101,20 +378,24 @@ func (h *Handler) UpdateConfig(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	// 更新配置
-	if err := h.config.Update(req.PandocPath, req.TemplateFile); err != nil {
+	// 在副本上修改并发布，进行中的转换继续使用开始时的配置；验证失败时配置保持不变
+	cfg, err := h.config.Update(func(next *config.Config) error {
+		return next.Update(req.PandocPath, req.TemplateFile)
+	})
+	if err != nil {
 		h.sendErrorResponse(w, "配置更新失败", err, http.StatusBadRequest)
 		return
 	}
 
-	// 更新转换器配置
-	h.converter.UpdateConfig(h.config)
+	// 转换器与处理器共享配置，只需按新配置调整并发数等参数
+	h.converter.ConfigUpdated()
+	h.state.refreshPandoc()
 
 	response := &models.ConfigResponse{
 		Success:      true,
 		Message:      "配置更新成功",
-		PandocPath:   h.config.PandocPath,
-		TemplateFile: h.config.TemplateFile,
+		PandocPath:   cfg.PandocPath,
+		TemplateFile: cfg.TemplateFile,
 	}
 
 	h.sendJSONResponse(w, response, http.StatusOK)
@@ -127,27 +408,28 @@ func (h *Handler) ValidateConfig(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	cfg := h.config.Load()
 	response := &models.ConfigResponse{
 		Success:      true,
 		Message:      "",
-		PandocPath:   h.config.PandocPath,
-		TemplateFile: h.config.TemplateFile,
+		PandocPath:   cfg.PandocPath,
+		TemplateFile: cfg.TemplateFile,
 	}
 
 	var validationMessages []string
 	var hasErrors bool
 
 	// 验证Pandoc路径
-	if err := h.config.ValidatePandoc(); err != nil {
+	if pandoc, err := cfg.Pandoc(); err != nil {
 		hasErrors = true
 		validationMessages = append(validationMessages, fmt.Sprintf("❌ Pandoc路径验证失败: %v", err))
 	} else {
-		validationMessages = append(validationMessages, "✅ Pandoc路径验证成功")
+		validationMessages = append(validationMessages, fmt.Sprintf("✅ Pandoc路径验证成功 (版本 %s)", pandoc.Version))
 	}
 
 	// 验证模板文件（如果配置了模板文件）
-	if h.config.TemplateFile != "" {
-		if err := h.config.ValidateTemplate(); err != nil {
+	if cfg.TemplateFile != "" {
+		if err := cfg.ValidateTemplate(); err != nil {
 			hasErrors = true
 			validationMessages = append(validationMessages, fmt.Sprintf("❌ 模板文件验证失败: %v", err))
 		} else {
@@ -175,22 +457,49 @@ func (h *Handler) Health(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	state, _ := h.state.state()
 	response := map[string]interface{}{
 		"status":  "ok",
 		"message": "服务运行正常",
+		"state":   state,
 	}
 
 	// 检查Pandoc是否可用
-	if err := h.config.ValidatePandoc(); err != nil {
+	if pandoc, err := h.config.Load().Pandoc(); err != nil {
 		response["pandoc_status"] = "error"
 		response["pandoc_error"] = err.Error()
 	} else {
 		response["pandoc_status"] = "ok"
+		response["pandoc_version"] = pandoc.Version
+	}
+
+	// 各优先级通道的排队深度和等待时间
+	response["lanes"] = h.converter.LaneStats()
+
+	// 输出缓存命中统计
+	if stats := h.converter.CacheStats(); stats != nil {
+		response["output_cache"] = stats
 	}
 
 	h.sendJSONResponse(w, response, http.StatusOK)
 }
 
+// Close 释放处理器持有的后台资源
+func (h *Handler) Close() {
+	h.converter.Close()
+}
+
+// rejectIfBusy 转换队列已满时返回429和Retry-After，返回true表示已发送响应
+func (h *Handler) rejectIfBusy(w http.ResponseWriter, err error) bool {
+	var queueFull *converter.QueueFullError
+	if !errors.As(err, &queueFull) {
+		return false
+	}
+	w.Header().Set("Retry-After", strconv.Itoa(int(queueFull.RetryAfter/time.Second)))
+	h.sendErrorResponse(w, "服务器繁忙，请稍后重试", err, http.StatusTooManyRequests)
+	return true
+}
+
 // sendJSONResponse 发送JSON响应
 func (h *Handler) sendJSONResponse(w http.ResponseWriter, data interface{}, statusCode int) {
 	w.Header().Set("Content-Type", "application/json")
@@ -3,11 +3,19 @@ package api
 import (
 	"bytes"
 	"encoding/json"
+	"mime/multipart"
 	"net/http"
 	"net/http/httptest"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strconv"
+	"strings"
 	"testing"
+	"time"
 
 	"md2docx/internal/config"
+	"md2docx/internal/converter"
 	"md2docx/internal/models"
 )
 
@@ -21,7 +29,7 @@ func TestNew(t *testing.T) {
 		t.Fatal("创建API处理器失败")
 	}
 
-	if handler.config != cfg {
+	if handler.config.Load() != cfg {
 		t.Error("API处理器配置不匹配")
 	}
 }
@@ -281,3 +289,223 @@ func TestValidateConfig(t *testing.T) {
 		t.Error("期望配置验证失败，但成功了")
 	}
 }
+
+func TestJobEndpoints(t *testing.T) {
+	cfg := &config.Config{
+		PandocPath: "/usr/bin/pandoc",
+	}
+	mux := NewRouter(New(cfg))
+
+	// 提交任务
+	batchReq := models.BatchConversionRequest{
+		InputFiles: []string{"/nonexistent/test1.md"},
+	}
+	jsonData, err := json.Marshal(batchReq)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	rr := httptest.NewRecorder()
+	mux.ServeHTTP(rr, httptest.NewRequest("POST", "/api/jobs", bytes.NewBuffer(jsonData)))
+	if status := rr.Code; status != http.StatusAccepted {
+		t.Fatalf("期望状态码 %v, 实际 %v", http.StatusAccepted, status)
+	}
+
+	var submitted models.ConversionStatus
+	if err := json.Unmarshal(rr.Body.Bytes(), &submitted); err != nil {
+		t.Fatalf("解析响应失败: %v", err)
+	}
+
+	// 查询任务
+	rr = httptest.NewRecorder()
+	mux.ServeHTTP(rr, httptest.NewRequest("GET", "/api/jobs/"+submitted.ID, nil))
+	if status := rr.Code; status != http.StatusOK {
+		t.Errorf("期望状态码 %v, 实际 %v", http.StatusOK, status)
+	}
+
+	// 取消任务
+	rr = httptest.NewRecorder()
+	mux.ServeHTTP(rr, httptest.NewRequest("DELETE", "/api/jobs/"+submitted.ID, nil))
+	if status := rr.Code; status != http.StatusOK {
+		t.Errorf("期望状态码 %v, 实际 %v", http.StatusOK, status)
+	}
+
+	// 不存在的任务
+	rr = httptest.NewRecorder()
+	mux.ServeHTTP(rr, httptest.NewRequest("GET", "/api/jobs/missing", nil))
+	if status := rr.Code; status != http.StatusNotFound {
+		t.Errorf("期望状态码 %v, 实际 %v", http.StatusNotFound, status)
+	}
+}
+
+func TestConvertBatchStream(t *testing.T) {
+	cfg := &config.Config{
+		PandocPath: "/usr/bin/pandoc",
+	}
+	handler := New(cfg)
+
+	batchReq := models.BatchConversionRequest{
+		InputFiles: []string{"/nonexistent/test1.md", "/nonexistent/test2.md"},
+		OutputDir:  t.TempDir(),
+	}
+	jsonData, err := json.Marshal(batchReq)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	rr := httptest.NewRecorder()
+	handler.ConvertBatchStream(rr, httptest.NewRequest("POST", "/api/convert/batch/stream", bytes.NewBuffer(jsonData)))
+
+	if ct := rr.Header().Get("Content-Type"); ct != "application/x-ndjson" {
+		t.Errorf("期望Content-Type application/x-ndjson, 实际 %s", ct)
+	}
+
+	// 每个文件一行item事件，最后一行done事件
+	decoder := json.NewDecoder(rr.Body)
+	var events []models.BatchStreamEvent
+	for decoder.More() {
+		var event models.BatchStreamEvent
+		if err := decoder.Decode(&event); err != nil {
+			t.Fatalf("解析事件失败: %v", err)
+		}
+		events = append(events, event)
+	}
+
+	if len(events) != 3 {
+		t.Fatalf("期望3个事件, 实际 %d", len(events))
+	}
+	for _, event := range events[:2] {
+		if event.Event != "item" || event.Result == nil || event.Total != 2 {
+			t.Errorf("item事件不正确: %+v", event)
+		}
+	}
+	if last := events[2]; last.Event != "done" || last.Response == nil || len(last.Response.Results) != 2 {
+		t.Errorf("done事件不正确: %+v", last)
+	}
+}
+
+func TestRejectIfBusy(t *testing.T) {
+	handler := New(&config.Config{PandocPath: "/usr/bin/pandoc"})
+
+	rr := httptest.NewRecorder()
+	if handler.rejectIfBusy(rr, nil) {
+		t.Fatal("没有错误时不应拒绝请求")
+	}
+
+	err := &converter.QueueFullError{Lane: converter.LaneInteractive, Queued: 8, RetryAfter: 3 * time.Second}
+	if !handler.rejectIfBusy(rr, err) {
+		t.Fatal("排队已满时应拒绝请求")
+	}
+	if rr.Code != http.StatusTooManyRequests {
+		t.Errorf("期望状态码 %d, 实际 %d", http.StatusTooManyRequests, rr.Code)
+	}
+	if retryAfter := rr.Header().Get("Retry-After"); retryAfter != "3" {
+		t.Errorf("期望Retry-After 3, 实际 %q", retryAfter)
+	}
+}
+
+func TestWithDeadline(t *testing.T) {
+	handler := New(&config.Config{PandocPath: "/usr/bin/pandoc"})
+
+	var gotDeadline time.Time
+	var called bool
+	next := handler.withDeadline(func(w http.ResponseWriter, r *http.Request) {
+		called = true
+		gotDeadline, _ = r.Context().Deadline()
+		w.WriteHeader(http.StatusOK)
+	})
+
+	send := func(value string) *httptest.ResponseRecorder {
+		called, gotDeadline = false, time.Time{}
+		req := httptest.NewRequest("POST", "/api/convert/single", nil)
+		if value != "" {
+			req.Header.Set(DeadlineHeader, value)
+		}
+		rr := httptest.NewRecorder()
+		next(rr, req)
+		return rr
+	}
+
+	// 未指定截止时间时不限制
+	if rr := send(""); rr.Code != http.StatusOK || !called || !gotDeadline.IsZero() {
+		t.Errorf("未指定截止时间: code=%d called=%v deadline=%v", rr.Code, called, gotDeadline)
+	}
+
+	// 未来的截止时间设置到请求上下文
+	deadline := time.Now().Add(time.Minute).Truncate(time.Millisecond)
+	if rr := send(strconv.FormatInt(deadline.UnixMilli(), 10)); rr.Code != http.StatusOK || !gotDeadline.Equal(deadline) {
+		t.Errorf("期望上下文截止时间 %v, 实际 %v (code=%d)", deadline, gotDeadline, rr.Code)
+	}
+
+	// 已过期的请求不开始处理
+	past := time.Now().Add(-time.Second).UnixMilli()
+	if rr := send(strconv.FormatInt(past, 10)); rr.Code != http.StatusGatewayTimeout || called {
+		t.Errorf("过期请求: 期望 %d 且不处理, 实际 code=%d called=%v", http.StatusGatewayTimeout, rr.Code, called)
+	}
+
+	if rr := send("tomorrow"); rr.Code != http.StatusBadRequest || called {
+		t.Errorf("格式错误: 期望 %d, 实际 %d", http.StatusBadRequest, rr.Code)
+	}
+}
+
+func TestConvertStream(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	// 模拟pandoc：从标准输入转换时原样输出
+	tmpDir := t.TempDir()
+	fakePandoc := filepath.Join(tmpDir, "pandoc")
+	script := "#!/bin/sh\n" +
+		"if [ \"$1\" = \"--version\" ]; then echo 'pandoc 3.0'; exit 0; fi\n" +
+		"if [ \"$1\" = \"--help\" ]; then echo '  --embed-resources'; exit 0; fi\n" +
+		"if [ \"$1\" = \"--list-extensions=markdown\" ]; then echo '+smart'; exit 0; fi\n" +
+		"cat\n"
+	if err := os.WriteFile(fakePandoc, []byte(script), 0755); err != nil {
+		t.Fatal(err)
+	}
+	handler := New(&config.Config{PandocPath: fakePandoc})
+
+	// 纯Markdown请求体
+	rr := httptest.NewRecorder()
+	handler.ConvertStream(rr, httptest.NewRequest("POST", "/api/convert/stream?name=报告", strings.NewReader("# 标题\n")))
+	if rr.Code != http.StatusOK || rr.Body.String() != "# 标题\n" {
+		t.Fatalf("纯文本转换: code=%d body=%q", rr.Code, rr.Body.String())
+	}
+	if ct := rr.Header().Get("Content-Type"); ct != docxContentType {
+		t.Errorf("期望Content-Type %s, 实际 %s", docxContentType, ct)
+	}
+	if cd := rr.Header().Get("Content-Disposition"); !strings.Contains(cd, ".docx") {
+		t.Errorf("Content-Disposition缺少文件名: %s", cd)
+	}
+
+	// multipart：图片在前，Markdown在后
+	var body bytes.Buffer
+	writer := multipart.NewWriter(&body)
+	image, _ := writer.CreateFormFile("image", "figure.png")
+	image.Write([]byte("png"))
+	markdown, _ := writer.CreateFormField("markdown")
+	markdown.Write([]byte("![图](figure.png)\n"))
+	writer.Close()
+
+	req := httptest.NewRequest("POST", "/api/convert/stream", &body)
+	req.Header.Set("Content-Type", writer.FormDataContentType())
+	rr = httptest.NewRecorder()
+	handler.ConvertStream(rr, req)
+	if want := "![图](data:image/png;base64,cG5n)\n"; rr.Code != http.StatusOK || rr.Body.String() != want {
+		t.Errorf("multipart转换: code=%d body=%q, 期望 %q", rr.Code, rr.Body.String(), want)
+	}
+
+	// 缺少markdown部分
+	body.Reset()
+	writer = multipart.NewWriter(&body)
+	writer.WriteField("other", "x")
+	writer.Close()
+	req = httptest.NewRequest("POST", "/api/convert/stream", &body)
+	req.Header.Set("Content-Type", writer.FormDataContentType())
+	rr = httptest.NewRecorder()
+	handler.ConvertStream(rr, req)
+	if rr.Code != http.StatusBadRequest {
+		t.Errorf("缺少markdown部分: 期望 %d, 实际 %d", http.StatusBadRequest, rr.Code)
+	}
+}
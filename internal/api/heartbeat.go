@@ -0,0 +1,84 @@
+package api
+
+import (
+	"bufio"
+	"fmt"
+	"io"
+	"strings"
+)
+
+// ServeHeartbeat 通过标准输入输出与启动本服务的前端保持联系，阻塞到in关闭
+//
+// 服务端输出:
+//
+//	STATE <状态> [说明]       状态变化时主动推送，连接建立时先推送一次
+//	PONG <序号> <状态>        响应前端的 PING <序号>
+//
+// 前端只在需要确认服务存活时发送PING，空闲时双方都不产生任何流量。
+// 响应PING前重新检查Pandoc是否可用，状态因此变化时同样推送STATE。
+// in关闭（前端退出）后调用onClose。
+func (h *Handler) ServeHeartbeat(in io.Reader, out io.Writer, onClose func()) {
+	changed := make(chan struct{}, 1)
+	pongs := make(chan string, 8)
+	stop := make(chan struct{})
+	done := make(chan struct{})
+
+	// 所有输出由一个协程完成，订阅回调只做非阻塞通知，不会因管道写满阻塞请求
+	go func() {
+		defer close(done)
+		for {
+			select {
+			case <-changed:
+				state, detail := h.state.state()
+				writeHeartbeatLine(out, "STATE", state, detail)
+			case seq := <-pongs:
+				// 前端在发出转换请求时发送PING，此时重新检查Pandoc，
+				// 安装或删除Pandoc后不必重启服务或修改配置
+				h.state.refreshPandoc()
+				state, _ := h.state.state()
+				writeHeartbeatLine(out, "PONG", seq, state)
+			case <-stop:
+				return
+			}
+		}
+	}()
+
+	h.state.subscribe(func(string, string) {
+		select {
+		case changed <- struct{}{}:
+		default:
+		}
+	})
+
+	scanner := bufio.NewScanner(in)
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) == 0 || fields[0] != "PING" {
+			continue
+		}
+		seq := "0"
+		if len(fields) > 1 {
+			seq = fields[1]
+		}
+		select {
+		case pongs <- seq:
+		default:
+			// 前端连续发送大量PING时丢弃多余的
+		}
+	}
+
+	close(stop)
+	<-done
+	if onClose != nil {
+		onClose()
+	}
+}
+
+// writeHeartbeatLine 输出一行心跳消息，说明中的换行替换为空格
+func writeHeartbeatLine(out io.Writer, kind, value, detail string) {
+	line := kind + " " + value
+	if detail = strings.Join(strings.Fields(detail), " "); detail != "" {
+		line += " " + detail
+	}
+	fmt.Fprintln(out, line)
+}
@@ -0,0 +1,138 @@
+package api
+
+import (
+	"bufio"
+	"io"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strings"
+	"testing"
+	"time"
+
+	"md2docx/internal/config"
+)
+
+// readHeartbeatLine 读取一行心跳输出，超时视为失败
+func readHeartbeatLine(t *testing.T, lines <-chan string) string {
+	t.Helper()
+	select {
+	case line := <-lines:
+		return line
+	case <-time.After(time.Second):
+		t.Fatal("等待心跳输出超时")
+		return ""
+	}
+}
+
+func TestServeHeartbeat(t *testing.T) {
+	cfg := &config.Config{
+		PandocPath: "/nonexistent/pandoc",
+		MaxWorkers: 1,
+	}
+	handler := New(cfg)
+
+	inReader, inWriter := io.Pipe()
+	outReader, outWriter := io.Pipe()
+	closed := make(chan struct{})
+	go handler.ServeHeartbeat(inReader, outWriter, func() { close(closed) })
+
+	lines := make(chan string, 16)
+	go func() {
+		scanner := bufio.NewScanner(outReader)
+		for scanner.Scan() {
+			lines <- scanner.Text()
+		}
+	}()
+
+	// 连接建立时推送当前状态
+	if line := readHeartbeatLine(t, lines); !strings.HasPrefix(line, "STATE "+StatePandocMissing) {
+		t.Errorf("期望初始状态 %s, 实际 %q", StatePandocMissing, line)
+	}
+
+	// PING得到带状态的PONG
+	io.WriteString(inWriter, "PING 7\n")
+	if line := readHeartbeatLine(t, lines); line != "PONG 7 "+StatePandocMissing {
+		t.Errorf("期望 PONG 7 %s, 实际 %q", StatePandocMissing, line)
+	}
+
+	// 状态变化时主动推送
+	handler.Drain()
+	if line := readHeartbeatLine(t, lines); line != "STATE "+StateDraining {
+		t.Errorf("期望 STATE %s, 实际 %q", StateDraining, line)
+	}
+
+	// 标准输入关闭后回调onClose
+	inWriter.Close()
+	select {
+	case <-closed:
+	case <-time.After(time.Second):
+		t.Fatal("标准输入关闭后未调用onClose")
+	}
+}
+
+func TestStateTrackerOverloaded(t *testing.T) {
+	st := &stateTracker{cfg: config.NewStore(&config.Config{MaxWorkers: 1})}
+
+	var states []string
+	st.subscribe(func(state, detail string) { states = append(states, state) })
+
+	for i := 0; i <= overloadFactor; i++ {
+		st.begin()
+	}
+	if state, _ := st.state(); state != StateOverloaded {
+		t.Errorf("期望状态 %s, 实际 %s", StateOverloaded, state)
+	}
+
+	st.end()
+	if state, _ := st.state(); state != StateOK {
+		t.Errorf("期望状态 %s, 实际 %s", StateOK, state)
+	}
+
+	// 订阅时一次（空状态），变为ok、过载、恢复各一次，没有重复通知
+	want := []string{"", StateOK, StateOverloaded, StateOK}
+	if strings.Join(states, ",") != strings.Join(want, ",") {
+		t.Errorf("状态通知 = %v, 期望 %v", states, want)
+	}
+}
+
+func TestServeHeartbeatRefreshesPandoc(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	// 启动时Pandoc不存在，之后安装到配置的路径
+	fakePandoc := filepath.Join(t.TempDir(), "pandoc")
+	handler := New(&config.Config{PandocPath: fakePandoc, MaxWorkers: 1})
+
+	inReader, inWriter := io.Pipe()
+	outReader, outWriter := io.Pipe()
+	defer inWriter.Close()
+	go handler.ServeHeartbeat(inReader, outWriter, nil)
+
+	lines := make(chan string, 16)
+	go func() {
+		scanner := bufio.NewScanner(outReader)
+		for scanner.Scan() {
+			lines <- scanner.Text()
+		}
+	}()
+
+	if line := readHeartbeatLine(t, lines); !strings.HasPrefix(line, "STATE "+StatePandocMissing) {
+		t.Fatalf("期望初始状态 %s, 实际 %q", StatePandocMissing, line)
+	}
+
+	script := "#!/bin/sh\nif [ \"$1\" = \"--version\" ]; then echo 'pandoc 3.0'; fi\n"
+	if err := os.WriteFile(fakePandoc, []byte(script), 0755); err != nil {
+		t.Fatal(err)
+	}
+
+	// 响应PING前重新检查Pandoc，PONG带上新状态，随后推送状态变化
+	io.WriteString(inWriter, "PING 1\n")
+	if line := readHeartbeatLine(t, lines); line != "PONG 1 "+StateOK {
+		t.Errorf("期望 PONG 1 %s, 实际 %q", StateOK, line)
+	}
+	if line := readHeartbeatLine(t, lines); line != "STATE "+StateOK {
+		t.Errorf("期望 STATE %s, 实际 %q", StateOK, line)
+	}
+}
@@ -8,12 +8,20 @@ import (
 
 // SetupRoutes 设置路由
 func SetupRoutes(cfg *config.Config) *http.ServeMux {
-	handler := New(cfg)
+	return NewRouter(New(cfg))
+}
+
+// NewRouter 使用已创建的处理器设置路由
+func NewRouter(handler *Handler) *http.ServeMux {
 	mux := http.NewServeMux()
 
 	// API路由
-	mux.HandleFunc("/api/convert/single", corsMiddleware(handler.ConvertSingle))
-	mux.HandleFunc("/api/convert/batch", corsMiddleware(handler.ConvertBatch))
+	mux.HandleFunc("/api/convert/single", corsMiddleware(handler.track(handler.withDeadline(handler.ConvertSingle))))
+	mux.HandleFunc("/api/convert/batch", corsMiddleware(handler.track(handler.withDeadline(handler.ConvertBatch))))
+	mux.HandleFunc("/api/convert/stream", corsMiddleware(handler.track(handler.withDeadline(handler.ConvertStream))))
+	mux.HandleFunc("/api/convert/batch/stream", corsMiddleware(handler.track(handler.withDeadline(handler.ConvertBatchStream))))
+	mux.HandleFunc("/api/jobs", corsMiddleware(handler.SubmitJob))
+	mux.HandleFunc("/api/jobs/", corsMiddleware(jobHandler(handler)))
 	mux.HandleFunc("/api/config", corsMiddleware(configHandler(handler)))
 	mux.HandleFunc("/api/config/validate", corsMiddleware(handler.ValidateConfig))
 	mux.HandleFunc("/api/health", corsMiddleware(handler.Health))
@@ -38,13 +46,27 @@ func configHandler(h *Handler) http.HandlerFunc {
 	}
 }
 
+// jobHandler 任务处理器，根据HTTP方法分发
+func jobHandler(h *Handler) http.HandlerFunc {
+	return func(w http.ResponseWriter, r *http.Request) {
+		switch r.Method {
+		case http.MethodGet:
+			h.GetJob(w, r)
+		case http.MethodDelete:
+			h.CancelJob(w, r)
+		default:
+			http.Error(w, "不支持的HTTP方法", http.StatusMethodNotAllowed)
+		}
+	}
+}
+
 // corsMiddleware CORS中间件
 func corsMiddleware(next http.HandlerFunc) http.HandlerFunc {
 	return func(w http.ResponseWriter, r *http.Request) {
 		// 设置CORS头
 		w.Header().Set("Access-Control-Allow-Origin", "*")
 		w.Header().Set("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS")
-		w.Header().Set("Access-Control-Allow-Headers", "Content-Type, Authorization")
+		w.Header().Set("Access-Control-Allow-Headers", "Content-Type, Authorization, "+DeadlineHeader)
 
 		// 处理预检请求
 		if r.Method == http.MethodOptions {
@@ -0,0 +1,109 @@
+package api
+
+import (
+	"sync"
+
+	"md2docx/internal/config"
+)
+
+// 服务状态，变化时通过心跳通道推送给前端
+const (
+	StateOK            = "ok"             // 正常
+	StatePandocMissing = "pandoc_missing" // Pandoc不可用，转换会失败
+	StateOverloaded    = "overloaded"     // 进行中的转换请求过多
+	StateDraining      = "draining"       // 正在关闭，不再接受新请求
+)
+
+// overloadFactor 进行中的转换请求超过并发数的该倍数时视为过载
+const overloadFactor = 4
+
+// stateTracker 汇总服务状态，只在请求开始/结束、配置变化和收到PING时重新计算，空闲时不做任何事
+type stateTracker struct {
+	mu        sync.Mutex
+	cfg       *config.Store
+	inflight  int
+	pandocErr string
+	draining  bool
+	current   string
+	detail    string
+	listeners []func(state, detail string)
+}
+
+func newStateTracker(cfg *config.Store) *stateTracker {
+	st := &stateTracker{cfg: cfg}
+	st.refreshPandoc()
+	return st
+}
+
+// state 返回当前状态和说明
+func (st *stateTracker) state() (string, string) {
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	return st.current, st.detail
+}
+
+// subscribe 注册状态变化回调，注册时立即以当前状态调用一次
+func (st *stateTracker) subscribe(fn func(state, detail string)) {
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	st.listeners = append(st.listeners, fn)
+	fn(st.current, st.detail)
+}
+
+// begin 记录一个转换请求开始
+func (st *stateTracker) begin() {
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	st.inflight++
+	st.updateLocked()
+}
+
+// end 记录一个转换请求结束
+func (st *stateTracker) end() {
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	st.inflight--
+	st.updateLocked()
+}
+
+// refreshPandoc 重新检查Pandoc是否可用（使用配置中缓存的探测结果，只做stat）
+func (st *stateTracker) refreshPandoc() {
+	pandocErr := ""
+	if _, err := st.cfg.Load().Pandoc(); err != nil {
+		pandocErr = err.Error()
+	}
+
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	st.pandocErr = pandocErr
+	st.updateLocked()
+}
+
+// drain 标记服务正在关闭
+func (st *stateTracker) drain() {
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	st.draining = true
+	st.updateLocked()
+}
+
+// updateLocked 重新计算状态，发生变化时通知订阅者
+func (st *stateTracker) updateLocked() {
+	state, detail := StateOK, ""
+	switch {
+	case st.draining:
+		state = StateDraining
+	case st.pandocErr != "":
+		state, detail = StatePandocMissing, st.pandocErr
+	case st.inflight > overloadFactor*st.cfg.Load().Workers():
+		state = StateOverloaded
+	}
+
+	if state == st.current && detail == st.detail {
+		return
+	}
+	st.current, st.detail = state, detail
+	for _, fn := range st.listeners {
+		fn(state, detail)
+	}
+}
@@ -7,6 +7,8 @@ import (
 	"os/exec"
 	"os/user"
 	"path/filepath"
+	"runtime"
+	"strings"
 )
 
 // Config 应用配置
@@ -14,6 +16,32 @@ type Config struct {
 	PandocPath   string `json:"pandoc_path"`
 	TemplateFile string `json:"template_file"`
 	ServerPort   int    `json:"server_port"`
+	MaxWorkers   int    `json:"max_workers"` // 批量转换并发数，0表示使用CPU核心数
+	MaxQueue     int    `json:"max_queue"`   // 每个优先级通道最多排队的请求数，0表示并发数的4倍
+
+	// 启动时由前端指定的并发数上限（多个后端进程分摊CPU时使用），不保存到配置文件
+	WorkerLimit int `json:"-"`
+	// 启动时由前端指定的后端序号，大于0时输出缓存和历史耗时使用该进程独有的路径，不保存到配置文件
+	Instance int `json:"-"`
+
+	// 常驻pandoc server进程池（需要pandoc支持server模式，不支持时自动回退）
+	PandocServer            bool `json:"pandoc_server"`
+	PandocServerMaxJobs     int  `json:"pandoc_server_max_jobs"`      // 单个进程处理多少文档后回收，0表示默认值
+	PandocServerMaxMemoryMB int  `json:"pandoc_server_max_memory_mb"` // 单个进程内存上限，0表示默认值
+
+	// 输出缓存：输入内容未变化时直接复用上次生成的docx
+	OutputCache      bool   `json:"output_cache"`
+	OutputCacheMaxMB int    `json:"output_cache_max_mb"` // 缓存目录大小上限，0表示默认值
+	OutputCacheDir   string `json:"output_cache_dir"`    // 缓存目录，为空时使用配置目录下的cache
+
+	// 批量转换调度使用的历史耗时文件，为空时使用配置目录下的timings.json
+	TimingHistoryFile string `json:"timing_history_file,omitempty"`
+
+	// 图片优化：嵌入前把超出页面宽度所需分辨率的图片缩小，并重新压缩PNG和JPEG
+	ImageOptimize   bool    `json:"image_optimize"`
+	ImageDPI        int     `json:"image_dpi"`         // 目标分辨率，0表示默认值150
+	ImageQuality    int     `json:"image_quality"`     // JPEG压缩质量（1-100），0表示默认值85
+	PageWidthInches float64 `json:"page_width_inches"` // 图片最大显示宽度（英寸），0表示默认值6.5
 }
 
 // DefaultConfig 默认配置
@@ -21,6 +49,13 @@ var DefaultConfig = &Config{
 	PandocPath:   "",
 	TemplateFile: "",
 	ServerPort:   8080,
+	MaxWorkers:   0,
+}
+
+// Clone 返回配置的副本，用于在不影响已发布快照的前提下修改配置
+func (c *Config) Clone() *Config {
+	clone := *c
+	return &clone
 }
 
 // getConfigFilePath 获取配置文件路径
@@ -43,12 +78,18 @@ func getConfigFilePath() string {
 	return "config.json"
 }
 
+// DataDir 返回应用数据目录（与配置文件同目录），用于存放缓存等数据
+func DataDir() string {
+	return filepath.Dir(getConfigFilePath())
+}
+
 // Load 加载配置
 func Load() (*Config, error) {
 	config := &Config{
 		PandocPath:   DefaultConfig.PandocPath,
 		TemplateFile: DefaultConfig.TemplateFile,
 		ServerPort:   DefaultConfig.ServerPort,
+		MaxWorkers:   DefaultConfig.MaxWorkers,
 	}
 
 	configFilePath := getConfigFilePath()
@@ -76,6 +117,39 @@ func Load() (*Config, error) {
 		if fileConfig.ServerPort != 0 {
 			config.ServerPort = fileConfig.ServerPort
 		}
+		if fileConfig.MaxWorkers > 0 {
+			config.MaxWorkers = fileConfig.MaxWorkers
+		}
+		if fileConfig.MaxQueue > 0 {
+			config.MaxQueue = fileConfig.MaxQueue
+		}
+		config.PandocServer = fileConfig.PandocServer
+		if fileConfig.PandocServerMaxJobs > 0 {
+			config.PandocServerMaxJobs = fileConfig.PandocServerMaxJobs
+		}
+		if fileConfig.PandocServerMaxMemoryMB > 0 {
+			config.PandocServerMaxMemoryMB = fileConfig.PandocServerMaxMemoryMB
+		}
+		config.OutputCache = fileConfig.OutputCache
+		if fileConfig.OutputCacheMaxMB > 0 {
+			config.OutputCacheMaxMB = fileConfig.OutputCacheMaxMB
+		}
+		if fileConfig.OutputCacheDir != "" {
+			config.OutputCacheDir = fileConfig.OutputCacheDir
+		}
+		if fileConfig.TimingHistoryFile != "" {
+			config.TimingHistoryFile = fileConfig.TimingHistoryFile
+		}
+		config.ImageOptimize = fileConfig.ImageOptimize
+		if fileConfig.ImageDPI > 0 {
+			config.ImageDPI = fileConfig.ImageDPI
+		}
+		if fileConfig.ImageQuality > 0 && fileConfig.ImageQuality <= 100 {
+			config.ImageQuality = fileConfig.ImageQuality
+		}
+		if fileConfig.PageWidthInches > 0 {
+			config.PageWidthInches = fileConfig.PageWidthInches
+		}
 	}
 
 	// 如果没有配置Pandoc路径，尝试自动检测
@@ -110,56 +184,107 @@ func (c *Config) Save() error {
 
 // ValidatePandoc 验证Pandoc路径是否有效
 func (c *Config) ValidatePandoc() error {
+	_, err := c.Pandoc()
+	return err
+}
+
+// Pandoc 返回当前Pandoc的版本和能力信息
+// 探测结果按可执行文件的路径、修改时间和inode缓存，文件不变时不会重复执行pandoc
+// 配置可能是多个转换共享的快照，自动检测到的路径不写回配置，转换时使用PandocInfo.Path
+func (c *Config) Pandoc() (*PandocInfo, error) {
+	pandocPath := c.PandocPath
 	// 如果路径为空，尝试自动检测
-	if c.PandocPath == "" {
-		if pandocPath, err := findPandoc(); err == nil {
-			c.PandocPath = pandocPath
-		} else {
-			return fmt.Errorf("Pandoc路径未配置且无法自动检测: %v", err)
+	if pandocPath == "" {
+		detected, err := findPandoc()
+		if err != nil {
+			return nil, fmt.Errorf("Pandoc路径未配置且无法自动检测: %v", err)
 		}
+		pandocPath = detected
 	}
 
-	// 如果路径不是绝对路径（如"pandoc"），直接尝试执行
-	if c.PandocPath == "pandoc" || !filepath.IsAbs(c.PandocPath) {
-		cmd := exec.Command(c.PandocPath, "--version")
-		if err := cmd.Run(); err != nil {
-			return fmt.Errorf("Pandoc执行失败: %v", err)
-		}
-		return nil
+	return sharedPandocCache.get(pandocPath)
+}
+
+// Workers 返回批量转换实际使用的并发数
+func (c *Config) Workers() int {
+	workers := runtime.NumCPU()
+	if c.MaxWorkers > 0 {
+		workers = c.MaxWorkers
+	}
+	if c.WorkerLimit > 0 && c.WorkerLimit < workers {
+		workers = c.WorkerLimit
 	}
+	return workers
+}
 
-	// 检查绝对路径的文件是否存在
-	if _, err := os.Stat(c.PandocPath); os.IsNotExist(err) {
-		return fmt.Errorf("Pandoc可执行文件不存在: %s", c.PandocPath)
+// OutputCachePath 返回输出缓存目录
+// 同一前端启动的多个后端共用一个配置文件，序号大于0的后端在目录名后加上序号，
+// 各自独立记录和淘汰缓存，不会删除其他进程仍在使用的条目
+func (c *Config) OutputCachePath() string {
+	dir := c.OutputCacheDir
+	if dir == "" {
+		dir = filepath.Join(DataDir(), "cache")
 	}
+	if c.Instance > 0 {
+		dir = fmt.Sprintf("%s-%d", filepath.Clean(dir), c.Instance)
+	}
+	return dir
+}
 
-	// 尝试执行pandoc --version
-	cmd := exec.Command(c.PandocPath, "--version")
-	if err := cmd.Run(); err != nil {
-		return fmt.Errorf("Pandoc执行失败: %v", err)
+// TimingHistoryPath 返回历史耗时文件路径，序号大于0的后端在文件名后加上序号，避免相互覆盖
+func (c *Config) TimingHistoryPath() string {
+	path := c.TimingHistoryFile
+	if path == "" {
+		path = filepath.Join(DataDir(), "timings.json")
+	}
+	if c.Instance > 0 {
+		ext := filepath.Ext(path)
+		path = fmt.Sprintf("%s-%d%s", strings.TrimSuffix(path, ext), c.Instance, ext)
 	}
+	return path
+}
 
-	return nil
+// QueueLimit 返回每个优先级通道最多排队的请求数，超出时服务器返回429
+func (c *Config) QueueLimit() int {
+	if c.MaxQueue > 0 {
+		return c.MaxQueue
+	}
+	return 4 * c.Workers()
 }
 
-// ValidateTemplate 验证模板文件是否有效
-func (c *Config) ValidateTemplate() error {
-	if c.TemplateFile == "" {
-		return nil // 模板文件是可选的
+// TargetImageDPI 返回图片优化的目标分辨率
+func (c *Config) TargetImageDPI() int {
+	if c.ImageDPI > 0 {
+		return c.ImageDPI
 	}
+	return 150
+}
 
-	// 检查文件是否存在
-	if _, err := os.Stat(c.TemplateFile); os.IsNotExist(err) {
-		return fmt.Errorf("模板文件不存在: %s", c.TemplateFile)
+// JPEGQuality 返回重新压缩JPEG使用的质量
+func (c *Config) JPEGQuality() int {
+	if c.ImageQuality > 0 && c.ImageQuality <= 100 {
+		return c.ImageQuality
 	}
+	return 85
+}
 
-	// 检查文件扩展名
-	ext := filepath.Ext(c.TemplateFile)
-	if ext != ".docx" {
-		return fmt.Errorf("模板文件必须是.docx格式: %s", c.TemplateFile)
+// PageWidth 返回图片在文档中的最大显示宽度（英寸），默认值为Letter纸减去两侧1英寸页边距
+func (c *Config) PageWidth() float64 {
+	if c.PageWidthInches > 0 {
+		return c.PageWidthInches
 	}
+	return 6.5
+}
 
-	return nil
+// ValidateTemplate 验证模板文件是否有效
+// 验证结果由模板注册表缓存，模板文件不变时不会重复读取
+func (c *Config) ValidateTemplate() error {
+	if c.TemplateFile == "" {
+		return nil // 模板文件是可选的
+	}
+
+	_, err := LookupTemplate(c.TemplateFile)
+	return err
 }
 
 // findPandoc 在系统PATH中查找Pandoc
@@ -176,18 +301,24 @@ func findPandoc() (string, error) {
 	return "", fmt.Errorf("在系统PATH中未找到Pandoc")
 }
 
-// Update 更新配置
+// Update 更新配置，应在Store.Update中对副本调用，不要修改已发布的快照
 func (c *Config) Update(pandocPath, templateFile string) error {
-	if pandocPath != "" {
+	if pandocPath != "" && pandocPath != c.PandocPath {
 		c.PandocPath = pandocPath
+		// 路径变化时重新探测Pandoc能力
+		sharedPandocCache.invalidate(pandocPath)
 	}
 	// 允许设置空模板文件（清空模板）
 	c.TemplateFile = templateFile
 
-	// 验证Pandoc配置（必须有效）
-	if err := c.ValidatePandoc(); err != nil {
+	// 验证Pandoc配置（必须有效），自动检测到的路径一并保存
+	pandoc, err := c.Pandoc()
+	if err != nil {
 		return err
 	}
+	if c.PandocPath == "" {
+		c.PandocPath = pandoc.Path
+	}
 
 	// 模板文件验证：只有在非空时才验证，允许用户设置不存在的路径
 	// 实际使用时会在转换过程中再次验证
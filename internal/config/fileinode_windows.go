@@ -0,0 +1,10 @@
+//go:build windows
+
+package config
+
+import "os"
+
+// fileInode Windows下没有inode，仅依赖路径和修改时间
+func fileInode(info os.FileInfo) uint64 {
+	return 0
+}
@@ -0,0 +1,118 @@
+package config
+
+import (
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+	"sync"
+	"time"
+)
+
+// PandocInfo Pandoc可执行文件的探测结果
+type PandocInfo struct {
+	Path           string   `json:"path"`
+	Version        string   `json:"version"`
+	Extensions     []string `json:"extensions,omitempty"` // markdown读取器支持的扩展
+	EmbedResources bool     `json:"embed_resources"`      // 是否支持--embed-resources
+}
+
+// pandocKey 缓存键：路径、修改时间和inode共同标识一个可执行文件
+type pandocKey struct {
+	path  string
+	mtime time.Time
+	inode uint64
+}
+
+// pandocCache Pandoc能力缓存，同一个可执行文件只探测一次
+type pandocCache struct {
+	mu      sync.Mutex
+	entries map[string]*pandocCacheEntry
+}
+
+type pandocCacheEntry struct {
+	key  pandocKey
+	info *PandocInfo
+	err  error
+}
+
+// sharedPandocCache 进程内共享的Pandoc能力缓存
+var sharedPandocCache = &pandocCache{entries: make(map[string]*pandocCacheEntry)}
+
+// get 返回指定路径的Pandoc信息，文件未变化时直接使用缓存
+func (pc *pandocCache) get(pandocPath string) (*PandocInfo, error) {
+	key, err := statPandoc(pandocPath)
+	if err != nil {
+		return nil, err
+	}
+
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
+
+	if entry, ok := pc.entries[pandocPath]; ok && entry.key == key {
+		return entry.info, entry.err
+	}
+
+	info, err := probePandoc(key.path)
+	pc.entries[pandocPath] = &pandocCacheEntry{key: key, info: info, err: err}
+	return info, err
+}
+
+// invalidate 丢弃指定路径的缓存，下次访问时重新探测
+func (pc *pandocCache) invalidate(pandocPath string) {
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
+	delete(pc.entries, pandocPath)
+}
+
+// statPandoc 解析Pandoc路径并读取其文件标识
+func statPandoc(pandocPath string) (pandocKey, error) {
+	resolved := pandocPath
+	// 如果路径不是绝对路径（如"pandoc"），在PATH中查找
+	if !filepath.IsAbs(pandocPath) {
+		path, err := exec.LookPath(pandocPath)
+		if err != nil {
+			return pandocKey{}, fmt.Errorf("Pandoc执行失败: %v", err)
+		}
+		resolved = path
+	}
+
+	info, err := os.Stat(resolved)
+	if os.IsNotExist(err) {
+		return pandocKey{}, fmt.Errorf("Pandoc可执行文件不存在: %s", pandocPath)
+	} else if err != nil {
+		return pandocKey{}, fmt.Errorf("无法访问Pandoc可执行文件: %v", err)
+	}
+
+	return pandocKey{path: resolved, mtime: info.ModTime(), inode: fileInode(info)}, nil
+}
+
+// probePandoc 执行Pandoc获取版本和能力信息
+func probePandoc(pandocPath string) (*PandocInfo, error) {
+	output, err := exec.Command(pandocPath, "--version").Output()
+	if err != nil {
+		return nil, fmt.Errorf("Pandoc执行失败: %v", err)
+	}
+
+	info := &PandocInfo{Path: pandocPath}
+	if firstLine := strings.SplitN(string(output), "\n", 2)[0]; firstLine != "" {
+		info.Version = strings.TrimSpace(strings.TrimPrefix(firstLine, "pandoc"))
+	}
+
+	// 支持的markdown扩展（旧版本不支持该参数时忽略）
+	if output, err := exec.Command(pandocPath, "--list-extensions=markdown").Output(); err == nil {
+		for _, line := range strings.Split(string(output), "\n") {
+			if line = strings.TrimSpace(line); line != "" {
+				info.Extensions = append(info.Extensions, line)
+			}
+		}
+	}
+
+	// --embed-resources 从Pandoc 2.19开始提供，之前使用--self-contained
+	if output, err := exec.Command(pandocPath, "--help").Output(); err == nil {
+		info.EmbedResources = strings.Contains(string(output), "--embed-resources")
+	}
+
+	return info, nil
+}
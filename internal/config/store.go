@@ -0,0 +1,47 @@
+package config
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+// Store 配置快照的发布点
+// 已发布的Config视为只读：修改时复制一份，改好后整体替换指针。
+// 转换在开始时取得快照并一直使用到结束，读取不加锁，
+// 更新配置也不必等待进行中的转换，转换过程中不会读到改了一半的配置。
+type Store struct {
+	current atomic.Pointer[Config]
+	writeMu sync.Mutex // 串行化多个写入方的“复制-修改-发布”
+}
+
+// NewStore 以cfg作为初始快照创建配置发布点，之后不应再直接修改cfg
+func NewStore(cfg *Config) *Store {
+	s := &Store{}
+	s.current.Store(cfg)
+	return s
+}
+
+// Load 返回当前配置快照，调用方不得修改返回值
+func (s *Store) Load() *Config {
+	return s.current.Load()
+}
+
+// Publish 用cfg替换当前快照
+func (s *Store) Publish(cfg *Config) {
+	s.writeMu.Lock()
+	defer s.writeMu.Unlock()
+	s.current.Store(cfg)
+}
+
+// Update 复制当前快照并交给fn修改，fn成功后发布新快照；fn返回错误时当前快照保持不变
+func (s *Store) Update(fn func(cfg *Config) error) (*Config, error) {
+	s.writeMu.Lock()
+	defer s.writeMu.Unlock()
+
+	next := s.current.Load().Clone()
+	if err := fn(next); err != nil {
+		return s.current.Load(), err
+	}
+	s.current.Store(next)
+	return next, nil
+}
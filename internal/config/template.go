@@ -0,0 +1,192 @@
+package config
+
+import (
+	"archive/zip"
+	"bytes"
+	"crypto/sha256"
+	"encoding/base64"
+	"encoding/hex"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"strings"
+	"sync"
+	"time"
+)
+
+// TemplateInfo 已验证的参考模板
+type TemplateInfo struct {
+	Path        string // 绝对路径
+	Fingerprint string // 内容的SHA-256，内容相同的模板指纹相同
+	Size        int64
+	ModTime     time.Time
+	Data        []byte // 模板内容，调用方不得修改
+
+	encodeOnce sync.Once
+	encoded    string
+}
+
+// Base64 返回base64编码的模板内容（供pandoc server请求使用），只编码一次
+func (t *TemplateInfo) Base64() string {
+	t.encodeOnce.Do(func() {
+		t.encoded = base64.StdEncoding.EncodeToString(t.Data)
+	})
+	return t.encoded
+}
+
+// templateKey 不使用目录监视时，按大小、修改时间和inode判断模板是否变化
+type templateKey struct {
+	size  int64
+	mtime time.Time
+	inode uint64
+}
+
+type templateCacheEntry struct {
+	info    *TemplateInfo
+	key     templateKey
+	watched bool // 所在目录处于监视中，文件变化时条目会被删除，使用前不必stat
+}
+
+// templateCache 参考模板注册表，每个模板只读取、验证和计算指纹一次
+// Linux上通过inotify监视模板所在目录，文件变化时删除对应条目；
+// 其他平台、符号链接或无法监视时，每次使用前stat比较大小、修改时间和inode
+type templateCache struct {
+	mu         sync.Mutex
+	entries    map[string]*templateCacheEntry
+	generation uint64 // 每次收到变化通知时加1，读取期间模板有变化时不缓存读取结果
+
+	watcherOnce sync.Once
+	watcher     *templateWatcher // 为nil表示无法监视目录
+}
+
+// sharedTemplateCache 进程内共享的参考模板注册表
+var sharedTemplateCache = &templateCache{entries: make(map[string]*templateCacheEntry)}
+
+// LookupTemplate 返回指定路径的参考模板，模板无效时返回错误
+// 模板文件不变时直接使用缓存，不重新读取和验证
+func LookupTemplate(path string) (*TemplateInfo, error) {
+	return sharedTemplateCache.get(path)
+}
+
+// get 返回模板信息，必要时读取并验证
+func (tc *templateCache) get(path string) (*TemplateInfo, error) {
+	if !strings.EqualFold(filepath.Ext(path), ".docx") {
+		return nil, fmt.Errorf("模板文件必须是.docx格式: %s", path)
+	}
+	absPath, err := filepath.Abs(path)
+	if err != nil {
+		return nil, fmt.Errorf("无法解析模板文件路径: %v", err)
+	}
+
+	tc.watcherOnce.Do(func() {
+		tc.watcher, _ = newTemplateWatcher(tc.invalidate)
+	})
+
+	tc.mu.Lock()
+	entry := tc.entries[absPath]
+	generation := tc.generation
+	tc.mu.Unlock()
+
+	if entry != nil {
+		if entry.watched {
+			return entry.info, nil
+		}
+		if key, err := statTemplate(absPath); err == nil && key == entry.key {
+			return entry.info, nil
+		}
+	}
+
+	// 先开始监视再读取，读取之后的修改一定会收到通知
+	watched := tc.watcher != nil && !isSymlink(absPath) && tc.watcher.watch(filepath.Dir(absPath))
+	info, key, err := loadTemplate(absPath)
+	if err != nil {
+		// 无效的模板不缓存，修复后立即生效
+		return nil, err
+	}
+
+	tc.mu.Lock()
+	if tc.generation == generation {
+		tc.entries[absPath] = &templateCacheEntry{info: info, key: key, watched: watched}
+	}
+	tc.mu.Unlock()
+	return info, nil
+}
+
+// invalidate 收到目录变化通知时删除受影响的条目
+// name为空表示整个目录失效，dir也为空表示全部失效（如通知队列溢出）
+func (tc *templateCache) invalidate(dir, name string) {
+	tc.mu.Lock()
+	defer tc.mu.Unlock()
+
+	tc.generation++
+	for path := range tc.entries {
+		if dir == "" || (filepath.Dir(path) == dir && (name == "" || filepath.Base(path) == name)) {
+			delete(tc.entries, path)
+		}
+	}
+}
+
+// loadTemplate 读取模板并验证其为docx文件
+func loadTemplate(path string) (*TemplateInfo, templateKey, error) {
+	file, err := os.Open(path)
+	if os.IsNotExist(err) {
+		return nil, templateKey{}, fmt.Errorf("模板文件不存在: %s", path)
+	} else if err != nil {
+		return nil, templateKey{}, fmt.Errorf("无法读取模板文件: %v", err)
+	}
+	defer file.Close()
+
+	stat, err := file.Stat()
+	if err != nil {
+		return nil, templateKey{}, fmt.Errorf("无法读取模板文件: %v", err)
+	}
+	if stat.IsDir() {
+		return nil, templateKey{}, fmt.Errorf("模板文件路径是目录: %s", path)
+	}
+	data, err := io.ReadAll(file)
+	if err != nil {
+		return nil, templateKey{}, fmt.Errorf("无法读取模板文件: %v", err)
+	}
+
+	// docx是zip包，正文在word/document.xml中
+	archive, err := zip.NewReader(bytes.NewReader(data), int64(len(data)))
+	if err != nil {
+		return nil, templateKey{}, fmt.Errorf("模板文件不是有效的docx文件: %s", path)
+	}
+	hasDocument := false
+	for _, entry := range archive.File {
+		if entry.Name == "word/document.xml" {
+			hasDocument = true
+			break
+		}
+	}
+	if !hasDocument {
+		return nil, templateKey{}, fmt.Errorf("模板文件缺少word/document.xml，不是有效的docx文件: %s", path)
+	}
+
+	sum := sha256.Sum256(data)
+	info := &TemplateInfo{
+		Path:        path,
+		Fingerprint: hex.EncodeToString(sum[:]),
+		Size:        int64(len(data)),
+		ModTime:     stat.ModTime(),
+		Data:        data,
+	}
+	return info, templateKey{size: stat.Size(), mtime: stat.ModTime(), inode: fileInode(stat)}, nil
+}
+
+// statTemplate 读取模板文件的标识
+func statTemplate(path string) (templateKey, error) {
+	info, err := os.Stat(path)
+	if err != nil {
+		return templateKey{}, err
+	}
+	return templateKey{size: info.Size(), mtime: info.ModTime(), inode: fileInode(info)}, nil
+}
+
+// isSymlink 符号链接指向的文件变化时，监视链接所在目录收不到通知
+func isSymlink(path string) bool {
+	info, err := os.Lstat(path)
+	return err == nil && info.Mode()&os.ModeSymlink != 0
+}
@@ -0,0 +1,109 @@
+//go:build linux
+
+package config
+
+import (
+	"encoding/binary"
+	"os"
+	"strings"
+	"sync"
+	"syscall"
+)
+
+// templateWatchMask 模板所在目录中会使缓存失效的事件
+// 编辑器保存时常写入临时文件再改名覆盖，因此监视目录而不是文件本身
+const templateWatchMask = syscall.IN_MODIFY | syscall.IN_CLOSE_WRITE | syscall.IN_ATTRIB |
+	syscall.IN_CREATE | syscall.IN_DELETE | syscall.IN_MOVED_FROM | syscall.IN_MOVED_TO |
+	syscall.IN_DELETE_SELF | syscall.IN_MOVE_SELF
+
+// templateWatcher 通过inotify监视模板所在的目录
+type templateWatcher struct {
+	file     *os.File // 非阻塞的inotify描述符，由运行时轮询，关闭时读取协程退出
+	fd       int
+	onChange func(dir, name string)
+
+	mu      sync.Mutex
+	dirs    map[int32]string // 监视描述符 -> 目录
+	watched map[string]bool
+}
+
+// newTemplateWatcher 创建inotify实例，onChange在后台协程中调用
+func newTemplateWatcher(onChange func(dir, name string)) (*templateWatcher, error) {
+	fd, err := syscall.InotifyInit1(syscall.IN_CLOEXEC | syscall.IN_NONBLOCK)
+	if err != nil {
+		return nil, err
+	}
+	w := &templateWatcher{
+		file:     os.NewFile(uintptr(fd), "inotify"),
+		fd:       fd,
+		onChange: onChange,
+		dirs:     make(map[int32]string),
+		watched:  make(map[string]bool),
+	}
+	go w.run()
+	return w, nil
+}
+
+// watch 开始监视目录，无法监视（如超出inotify上限）时返回false
+func (w *templateWatcher) watch(dir string) bool {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if w.watched[dir] {
+		return true
+	}
+	wd, err := syscall.InotifyAddWatch(w.fd, dir, templateWatchMask)
+	if err != nil {
+		return false
+	}
+	w.dirs[int32(wd)] = dir
+	w.watched[dir] = true
+	return true
+}
+
+// run 读取并分发inotify事件
+func (w *templateWatcher) run() {
+	buf := make([]byte, 64*(syscall.SizeofInotifyEvent+syscall.NAME_MAX+1))
+	for {
+		n, err := w.file.Read(buf)
+		if err != nil {
+			return
+		}
+		for offset := 0; offset+syscall.SizeofInotifyEvent <= n; {
+			wd := int32(binary.NativeEndian.Uint32(buf[offset:]))
+			mask := binary.NativeEndian.Uint32(buf[offset+4:])
+			nameLen := int(binary.NativeEndian.Uint32(buf[offset+12:]))
+			start := offset + syscall.SizeofInotifyEvent
+			if start+nameLen > n {
+				break
+			}
+			name := strings.TrimRight(string(buf[start:start+nameLen]), "\x00")
+			offset = start + nameLen
+			w.handle(wd, mask, name)
+		}
+	}
+}
+
+// handle 处理单个事件
+func (w *templateWatcher) handle(wd int32, mask uint32, name string) {
+	// 事件队列溢出时可能丢失了通知，全部失效
+	if mask&syscall.IN_Q_OVERFLOW != 0 {
+		w.onChange("", "")
+		return
+	}
+
+	w.mu.Lock()
+	dir, ok := w.dirs[wd]
+	switch {
+	case mask&syscall.IN_IGNORED != 0:
+		// 监视已被移除（目录被删除或改名），下次使用模板时重新监视
+		delete(w.dirs, wd)
+		delete(w.watched, dir)
+	case mask&syscall.IN_MOVE_SELF != 0:
+		// 目录改名后原路径已不是该目录，移除监视，随后会收到IN_IGNORED
+		syscall.InotifyRmWatch(w.fd, uint32(wd))
+	}
+	w.mu.Unlock()
+	if ok {
+		w.onChange(dir, name)
+	}
+}
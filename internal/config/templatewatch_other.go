@@ -0,0 +1,16 @@
+//go:build !linux
+
+package config
+
+import "errors"
+
+// templateWatcher 非Linux平台不监视目录，模板使用前通过stat判断是否变化
+type templateWatcher struct{}
+
+func newTemplateWatcher(onChange func(dir, name string)) (*templateWatcher, error) {
+	return nil, errors.New("当前平台不支持监视模板目录")
+}
+
+func (w *templateWatcher) watch(dir string) bool {
+	return false
+}
@@ -0,0 +1,274 @@
+package converter
+
+import (
+	"context"
+	"fmt"
+	"math"
+	"sync"
+	"time"
+)
+
+// maxRetryAfter 建议客户端重试的最长等待时间
+const maxRetryAfter = time.Minute
+
+// QueueFullError 通道排队的请求已达上限，客户端应在RetryAfter之后重试
+type QueueFullError struct {
+	Lane       Lane
+	Queued     int
+	RetryAfter time.Duration
+}
+
+func (e *QueueFullError) Error() string {
+	return fmt.Sprintf("服务器繁忙：%s通道已有%d个请求排队，请%d秒后重试",
+		e.Lane, e.Queued, int(e.RetryAfter/time.Second))
+}
+
+// Lane 转换请求的优先级通道
+type Lane int
+
+const (
+	// LaneInteractive 交互式请求（单文件转换），优先获得空闲槽位，并保留一个槽位
+	LaneInteractive Lane = iota
+	// LaneBulk 批量请求，不能占用为交互式请求保留的槽位
+	LaneBulk
+	laneCount
+)
+
+// String 返回通道名称，用于统计输出
+func (l Lane) String() string {
+	if l == LaneInteractive {
+		return "interactive"
+	}
+	return "bulk"
+}
+
+// LaneStats 单个通道的排队统计
+type LaneStats struct {
+	Running   int     `json:"running"`     // 正在转换的文件数
+	Queued    int     `json:"queued"`      // 正在排队的文件数
+	Admitted  int64   `json:"admitted"`    // 累计获得槽位的文件数
+	Rejected  int64   `json:"rejected"`    // 因排队已满被拒绝的请求数
+	AvgWaitMs float64 `json:"avg_wait_ms"` // 平均排队时间
+	MaxWaitMs float64 `json:"max_wait_ms"` // 最长排队时间
+}
+
+// laneState 单个通道的等待队列和统计
+type laneState struct {
+	waiters   []*admissionWaiter // 先进先出
+	running   int
+	admitted  int64
+	rejected  int64
+	totalWait time.Duration
+	maxWait   time.Duration
+	avgHold   time.Duration // 占用槽位时间的滑动平均，用于估算重试等待时间
+}
+
+// admissionWaiter 排队中的请求，获得槽位时关闭ready
+type admissionWaiter struct {
+	ready    chan struct{}
+	enqueued time.Time
+	granted  bool
+	start    time.Time // 获得槽位的时间
+}
+
+// admission 所有转换共用的准入队列
+// 同时执行的pandoc转换不超过capacity个；槽位空闲时交互式通道先于批量通道获得，
+// 且批量通道最多使用capacity-1个槽位，批量转换进行中时单文件转换也不必排在整批之后。
+// 每个通道排队的请求不超过queueLimit个，超出时立即拒绝，由客户端稍后重试。
+type admission struct {
+	mu         sync.Mutex
+	capacity   int
+	queueLimit int
+	running    int
+	lanes      [laneCount]laneState
+}
+
+func newAdmission(capacity, queueLimit int) *admission {
+	a := &admission{}
+	a.resize(capacity, queueLimit)
+	return a
+}
+
+// resize 调整槽位数和排队上限，已在执行和排队的转换不受影响
+func (a *admission) resize(capacity, queueLimit int) {
+	if capacity < 1 {
+		capacity = 1
+	}
+	if queueLimit < 1 {
+		queueLimit = 1
+	}
+
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	a.capacity = capacity
+	a.queueLimit = queueLimit
+	a.dispatchLocked()
+}
+
+// acquire 在指定通道排队等待槽位，ctx结束时放弃排队并返回ctx的错误
+// 成功后必须调用返回的release释放槽位
+func (a *admission) acquire(ctx context.Context, lane Lane) (func(), error) {
+	return a.enqueue(ctx, lane, false)
+}
+
+// tryAcquire 与acquire相同，但通道排队已满时立即返回*QueueFullError
+func (a *admission) tryAcquire(ctx context.Context, lane Lane) (func(), error) {
+	return a.enqueue(ctx, lane, true)
+}
+
+// check 检查通道排队是否已满，不占用槽位
+// 用于批量请求开始前的准入判断，批量请求中的各个文件随后通过acquire排队
+func (a *admission) check(lane Lane) error {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	return a.checkLocked(lane)
+}
+
+func (a *admission) checkLocked(lane Lane) error {
+	state := &a.lanes[lane]
+	if len(state.waiters) < a.queueLimit {
+		return nil
+	}
+	state.rejected++
+	return &QueueFullError{Lane: lane, Queued: len(state.waiters), RetryAfter: a.retryAfterLocked(lane)}
+}
+
+func (a *admission) enqueue(ctx context.Context, lane Lane, bounded bool) (func(), error) {
+	a.mu.Lock()
+	if bounded {
+		if err := a.checkLocked(lane); err != nil {
+			a.mu.Unlock()
+			return nil, err
+		}
+	}
+	w := &admissionWaiter{ready: make(chan struct{}), enqueued: time.Now()}
+	a.lanes[lane].waiters = append(a.lanes[lane].waiters, w)
+	a.dispatchLocked()
+	a.mu.Unlock()
+
+	release := func() { a.release(lane, time.Since(w.start)) }
+
+	select {
+	case <-w.ready:
+		return release, nil
+	case <-ctx.Done():
+	}
+
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	if w.granted {
+		// 取消的同时已经获得槽位，直接归还
+		a.releaseLocked(lane, 0)
+		return nil, ctx.Err()
+	}
+	state := &a.lanes[lane]
+	for i, queued := range state.waiters {
+		if queued == w {
+			state.waiters = append(state.waiters[:i], state.waiters[i+1:]...)
+			break
+		}
+	}
+	return nil, ctx.Err()
+}
+
+// release 归还槽位，held为占用槽位的时间
+func (a *admission) release(lane Lane, held time.Duration) {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	a.releaseLocked(lane, held)
+}
+
+func (a *admission) releaseLocked(lane Lane, held time.Duration) {
+	state := &a.lanes[lane]
+	a.running--
+	state.running--
+	if held > 0 {
+		if state.avgHold == 0 {
+			state.avgHold = held
+		} else {
+			state.avgHold = (state.avgHold*4 + held) / 5
+		}
+	}
+	a.dispatchLocked()
+}
+
+// retryAfterLocked 估算排队中的请求全部开始所需的时间，至少1秒
+func (a *admission) retryAfterLocked(lane Lane) time.Duration {
+	state := &a.lanes[lane]
+	slots := a.limitLocked(lane)
+	if lane == LaneBulk {
+		slots -= a.lanes[LaneInteractive].running
+	}
+	if slots < 1 {
+		slots = 1
+	}
+	hold := state.avgHold
+	if hold <= 0 {
+		hold = time.Second
+	}
+
+	wait := time.Duration(float64(hold) * float64(len(state.waiters)) / float64(slots))
+	seconds := math.Ceil(wait.Seconds())
+	if seconds < 1 {
+		seconds = 1
+	}
+	if retry := time.Duration(seconds) * time.Second; retry < maxRetryAfter {
+		return retry
+	}
+	return maxRetryAfter
+}
+
+// dispatchLocked 把空闲槽位依次分配给交互式通道和批量通道的排队请求
+func (a *admission) dispatchLocked() {
+	for lane := Lane(0); lane < laneCount; lane++ {
+		state := &a.lanes[lane]
+		for len(state.waiters) > 0 && a.running < a.limitLocked(lane) {
+			w := state.waiters[0]
+			state.waiters = state.waiters[1:]
+
+			wait := time.Since(w.enqueued)
+			state.admitted++
+			state.totalWait += wait
+			if wait > state.maxWait {
+				state.maxWait = wait
+			}
+
+			a.running++
+			state.running++
+			w.granted = true
+			w.start = time.Now()
+			close(w.ready)
+		}
+	}
+}
+
+// limitLocked 通道可使用的槽位上限（包含其他通道占用的槽位）
+func (a *admission) limitLocked(lane Lane) int {
+	if lane == LaneBulk && a.capacity > 1 {
+		return a.capacity - 1
+	}
+	return a.capacity
+}
+
+// stats 返回各通道的排队统计
+func (a *admission) stats() map[string]LaneStats {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+
+	stats := make(map[string]LaneStats, laneCount)
+	for lane := Lane(0); lane < laneCount; lane++ {
+		state := &a.lanes[lane]
+		s := LaneStats{
+			Running:   state.running,
+			Queued:    len(state.waiters),
+			Admitted:  state.admitted,
+			Rejected:  state.rejected,
+			MaxWaitMs: float64(state.maxWait) / float64(time.Millisecond),
+		}
+		if state.admitted > 0 {
+			s.AvgWaitMs = float64(state.totalWait) / float64(state.admitted) / float64(time.Millisecond)
+		}
+		stats[lane.String()] = s
+	}
+	return stats
+}
@@ -1,35 +1,72 @@
 package converter
 
 import (
+	"context"
 	"fmt"
+	"log"
 	"os"
 	"os/exec"
 	"path/filepath"
 	"strings"
 	"sync"
+	"time"
 
 	"md2docx/internal/config"
 	"md2docx/internal/models"
 	"md2docx/pkg/utils"
 )
 
+// pandocWaitDelay 取消转换结束pandoc进程后，等待其输出管道关闭的最长时间
+const pandocWaitDelay = 500 * time.Millisecond
+
 // Converter 转换器
 type Converter struct {
-	config *config.Config
-	mu     sync.RWMutex
+	// 配置快照，每个转换请求开始时取得一份并使用到结束，更新配置不必等待进行中的转换
+	config *config.Store
+
+	// 常驻pandoc server进程池，首次使用时按当时的配置创建
+	serverMu          sync.Mutex
+	server            *pandocServerPool
+	serverConfig      *config.Config // 创建进程池时的配置快照
+	serverUnavailable bool           // 当前pandoc不支持server模式
+
+	// 输出缓存，首次使用时按当时的配置创建
+	cacheMu          sync.Mutex
+	cache            *outputCache
+	cacheConfig      *config.Config // 创建缓存时的配置快照
+	cacheUnavailable bool
+
+	// 历史转换耗时，首次调度批量转换时读取
+	historyMu sync.Mutex
+	history   *timingHistory
+
+	// 单文件转换与批量转换共用的准入队列
+	admission *admission
 }
 
 // New 创建新的转换器
 func New(cfg *config.Config) *Converter {
+	return NewWithStore(config.NewStore(cfg))
+}
+
+// NewWithStore 创建与调用方共享配置发布点的转换器
+// 调用方通过store发布新配置后应调用ConfigUpdated
+func NewWithStore(store *config.Store) *Converter {
+	cfg := store.Load()
 	return &Converter{
-		config: cfg,
+		config:    store,
+		admission: newAdmission(cfg.Workers(), cfg.QueueLimit()),
 	}
 }
 
 // ConvertSingle 转换单个文件
 func (c *Converter) ConvertSingle(req *models.ConversionRequest) (*models.ConversionResponse, error) {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
+	return c.ConvertSingleContext(context.Background(), req)
+}
+
+// ConvertSingleContext 转换单个文件，ctx取消或超过截止时间时停止排队并结束正在运行的pandoc进程
+func (c *Converter) ConvertSingleContext(ctx context.Context, req *models.ConversionRequest) (*models.ConversionResponse, error) {
+	cfg := c.config.Load()
 
 	// 验证输入文件
 	if err := utils.ValidateInputFile(req.InputFile); err != nil {
@@ -56,8 +93,27 @@ func (c *Converter) ConvertSingle(req *models.ConversionRequest) (*models.Conver
 		}, nil
 	}
 
+	// 在交互式通道排队，不必等待进行中的批量转换；排队已满时返回*QueueFullError
+	release, err := c.admission.tryAcquire(ctx, LaneInteractive)
+	if _, busy := err.(*QueueFullError); busy {
+		return nil, err
+	}
+	if err != nil {
+		return &models.ConversionResponse{
+			Success: false,
+			Error:   interruptedMessage(ctx),
+		}, nil
+	}
+	defer release()
+
 	// 执行转换
-	if err := c.convertFile(req.InputFile, outputPath, req.TemplateFile); err != nil {
+	if err := c.convertFile(ctx, cfg, req.InputFile, outputPath, req.TemplateFile); err != nil {
+		if ctx.Err() != nil {
+			return &models.ConversionResponse{
+				Success: false,
+				Error:   interruptedMessage(ctx),
+			}, nil
+		}
 		return &models.ConversionResponse{
 			Success: false,
 			Error:   fmt.Sprintf("转换失败: %v", err),
@@ -73,8 +129,16 @@ func (c *Converter) ConvertSingle(req *models.ConversionRequest) (*models.Conver
 
 // ConvertBatch 批量转换文件
 func (c *Converter) ConvertBatch(req *models.BatchConversionRequest) (*models.ConversionResponse, error) {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
+	return c.ConvertBatchContext(context.Background(), req, nil)
+}
+
+// ConvertBatchContext 批量转换文件，支持取消和逐个文件的进度回调
+// ctx取消或超过截止时间后不再开始新的文件，正在运行的pandoc进程被结束，
+// 这些文件标记为已取消（超时则为失败）；
+// onResult在每个文件完成时调用，可能被多个工作协程并发调用
+// 整批文件使用开始时的配置快照，转换期间更新配置只影响之后的请求
+func (c *Converter) ConvertBatchContext(ctx context.Context, req *models.BatchConversionRequest, onResult func(index int, result models.ConversionResult)) (*models.ConversionResponse, error) {
+	cfg := c.config.Load()
 
 	if len(req.InputFiles) == 0 {
 		return &models.ConversionResponse{
@@ -91,42 +155,103 @@ func (c *Converter) ConvertBatch(req *models.BatchConversionRequest) (*models.Co
 		}, nil
 	}
 
-	var results []models.ConversionResult
-	var successCount int
-
-	// 逐个处理文件
-	for _, inputFile := range req.InputFiles {
-		result := models.ConversionResult{
-			InputFile: inputFile,
-			Success:   false,
+	// 多模板转换：模板无效或输出会相互覆盖时整批拒绝
+	if len(req.Templates) > 0 {
+		if err := validateTemplateOutputs(req); err != nil {
+			return &models.ConversionResponse{
+				Success: false,
+				Error:   err.Error(),
+			}, nil
 		}
+	}
+
+	// 使用有界工作池并行处理，结果按输入顺序写入
+	results := make([]models.ConversionResult, len(req.InputFiles))
+	workers := cfg.Workers()
+	if workers > len(req.InputFiles) {
+		workers = len(req.InputFiles)
+	}
+
+	// 同一批文件通常共用图片，目录列表只读取一次，同一张图片只优化一次；
+	// 多模板转换时每个文档只解析一次
+	shared := newBatchResources(cfg)
+	defer shared.close()
+
+	// 按请求指定的顺序开始各个文件
+	schedule := c.scheduleBatch(req, shared.images)
+
+	jobs := make(chan int)
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for index := range jobs {
+				// 在批量通道排队，与其他批量任务共享槽位并让出交互式请求
+				release, err := c.admission.acquire(ctx, LaneBulk)
+				if err != nil {
+					results[index] = interruptedResult(ctx, req.InputFiles[index])
+					if onResult != nil {
+						onResult(index, results[index])
+					}
+					continue
+				}
+
+				start := time.Now()
+				if len(req.Templates) > 0 {
+					results[index] = c.convertBatchItemTemplates(ctx, cfg, shared, req.InputFiles[index], req)
+				} else {
+					results[index] = c.convertBatchItem(ctx, cfg, shared, req.InputFiles[index], req.OutputDir, req.TemplateFile, req.Incremental)
+				}
+				release()
+				if schedule.history != nil && results[index].Status == models.StatusCompleted {
+					schedule.history.record(req.InputFiles[index], schedule.costs[index], time.Since(start))
+				}
+				if onResult != nil {
+					onResult(index, results[index])
+				}
+			}
+		}()
+	}
 
-		// 验证输入文件
-		if err := utils.ValidateInputFile(inputFile); err != nil {
-			result.Error = err.Error()
-			results = append(results, result)
-			continue
+	dispatched := 0
+dispatch:
+	for _, index := range schedule.order {
+		select {
+		case jobs <- index:
+			dispatched++
+		case <-ctx.Done():
+			break dispatch
 		}
+	}
+	close(jobs)
+	wg.Wait()
 
-		// 确定输出路径
-		outputPath, err := utils.DetermineOutputPath(inputFile, req.OutputDir, "")
-		if err != nil {
-			result.Error = fmt.Sprintf("确定输出路径失败: %v", err)
-			results = append(results, result)
-			continue
+	if schedule.history != nil {
+		if err := schedule.history.save(); err != nil {
+			log.Printf("保存历史转换耗时失败: %v", err)
 		}
+	}
 
-		// 执行转换
-		if err := c.convertFile(inputFile, outputPath, req.TemplateFile); err != nil {
-			result.Error = fmt.Sprintf("转换失败: %v", err)
-			results = append(results, result)
-			continue
+	// 取消后尚未开始的文件
+	for _, index := range schedule.order[dispatched:] {
+		results[index] = interruptedResult(ctx, req.InputFiles[index])
+		if onResult != nil {
+			onResult(index, results[index])
 		}
+	}
 
-		result.Success = true
-		result.OutputFile = outputPath
-		results = append(results, result)
-		successCount++
+	var successCount, skippedCount, cancelledCount int
+	for _, result := range results {
+		if result.Success {
+			successCount++
+		}
+		switch result.Status {
+		case models.StatusSkipped:
+			skippedCount++
+		case models.StatusCancelled:
+			cancelledCount++
+		}
 	}
 
 	// 构建响应
@@ -144,14 +269,167 @@ func (c *Converter) ConvertBatch(req *models.BatchConversionRequest) (*models.Co
 		response.Error = "批量转换失败"
 	}
 
+	if skippedCount > 0 {
+		response.Message += fmt.Sprintf("（其中%d个文件已是最新，未重新转换）", skippedCount)
+	}
+	if cancelledCount > 0 {
+		response.Message += fmt.Sprintf("，%d个文件已取消", cancelledCount)
+	}
+
 	return response, nil
 }
 
+// interruptedResult 因取消或超过截止时间而未完成的文件的结果
+// 超时的文件视为失败，客户端主动取消的文件标记为已取消
+func interruptedResult(ctx context.Context, inputFile string) models.ConversionResult {
+	status := models.StatusCancelled
+	if ctx.Err() == context.DeadlineExceeded {
+		status = models.StatusFailed
+	}
+	return models.ConversionResult{
+		InputFile: inputFile,
+		Status:    status,
+		Error:     interruptedMessage(ctx),
+	}
+}
+
+// interruptedMessage 转换被中断的原因
+func interruptedMessage(ctx context.Context) string {
+	if ctx.Err() == context.DeadlineExceeded {
+		return "已超过请求的截止时间，转换已停止"
+	}
+	return "转换已取消"
+}
+
+// convertBatchItem 转换批量请求中的单个文件
+// incremental为true时，输出比输入、模板和引用的图片都新的文件直接跳过
+func (c *Converter) convertBatchItem(ctx context.Context, cfg *config.Config, shared *batchResources, inputFile, outputDir, templateFile string, incremental bool) models.ConversionResult {
+	result := models.ConversionResult{
+		InputFile: inputFile,
+		Success:   false,
+		Status:    models.StatusFailed,
+	}
+
+	// 验证输入文件
+	if err := utils.ValidateInputFile(inputFile); err != nil {
+		result.Error = err.Error()
+		return result
+	}
+
+	// 确定输出路径
+	outputPath, err := utils.DetermineOutputPath(inputFile, outputDir, "")
+	if err != nil {
+		result.Error = fmt.Sprintf("确定输出路径失败: %v", err)
+		return result
+	}
+
+	// 增量模式：依赖均未变化时跳过，按上次记录的依赖清单判断，不读取和扫描文档
+	if incremental && isUpToDate(cfg, inputFile, outputPath, templateFile) {
+		result.Success = true
+		result.Status = models.StatusSkipped
+		result.OutputFile = outputPath
+		return result
+	}
+
+	plan, err := c.planConversion(cfg, shared, inputFile, outputPath, templateFile)
+	if err != nil {
+		result.Error = fmt.Sprintf("转换失败: %v", err)
+		return result
+	}
+
+	// 执行转换
+	if err := c.executePlan(ctx, plan); err != nil {
+		if ctx.Err() != nil {
+			return interruptedResult(ctx, inputFile)
+		}
+		result.Error = fmt.Sprintf("转换失败: %v", err)
+		return result
+	}
+
+	// 记录本次转换的依赖，供下次增量转换判断
+	if incremental {
+		if err := writeManifest(plan); err != nil {
+			log.Printf("写入依赖清单失败: %v", err)
+		}
+	}
+
+	result.Success = true
+	result.Status = models.StatusCompleted
+	result.OutputFile = outputPath
+	return result
+}
+
+// conversionPlan 单个文件的转换参数
+type conversionPlan struct {
+	cfg          *config.Config // 请求开始时的配置快照
+	pandoc       *config.PandocInfo
+	inputFile    string
+	outputFile   string
+	referenceDoc string               // 实际使用的参考模板，为空表示不使用模板
+	template     *config.TemplateInfo // referenceDoc验证后的内容和指纹
+	markdown     []byte               // 规划时读取的输入内容
+	images       *imageScan           // 引用的本地图片
+	optimizer    *imageOptimizer      // 未启用图片优化时为nil
+	ast          *astCache            // 非nil时从解析好的AST写出docx（多模板转换）
+	args         []string             // pandoc参数
+}
+
+// batchResources 批量转换中各文件共用的资源
+type batchResources struct {
+	images    *imageResolver
+	optimizer *imageOptimizer // 未启用图片优化时为nil
+	asts      *astCache       // 多模板转换时已解析文档的AST
+}
+
+func newBatchResources(cfg *config.Config) *batchResources {
+	return &batchResources{
+		images:    newImageResolver(),
+		optimizer: newImageOptimizer(cfg),
+		asts:      newASTCache(),
+	}
+}
+
+// close 删除本批转换产生的临时文件
+func (r *batchResources) close() {
+	if r.optimizer != nil {
+		r.optimizer.close()
+	}
+	r.asts.close()
+}
+
 // convertFile 执行单个文件的转换
-func (c *Converter) convertFile(inputFile, outputFile, templateFile string) error {
-	// 验证Pandoc配置
-	if err := c.config.ValidatePandoc(); err != nil {
-		return fmt.Errorf("Pandoc配置无效: %v", err)
+func (c *Converter) convertFile(ctx context.Context, cfg *config.Config, inputFile, outputFile, templateFile string) error {
+	shared := newBatchResources(cfg)
+	defer shared.close()
+
+	plan, err := c.planConversion(cfg, shared, inputFile, outputFile, templateFile)
+	if err != nil {
+		return err
+	}
+	return c.executePlan(ctx, plan)
+}
+
+// planConversion 确定单个文件的pandoc参数
+// shared是批量转换中各文件共用的资源，单文件转换时为该文件单独创建
+func (c *Converter) planConversion(cfg *config.Config, shared *batchResources, inputFile, outputFile, templateFile string) (*conversionPlan, error) {
+	// 验证Pandoc配置（使用缓存的探测结果，不会每个文件都执行pandoc --version）
+	pandoc, err := cfg.Pandoc()
+	if err != nil {
+		return nil, fmt.Errorf("Pandoc配置无效: %v", err)
+	}
+
+	// 确定参考模板文件（模板由注册表验证并缓存，文件不变时不再读取），无效的模板不使用
+	if templateFile == "" {
+		templateFile = cfg.TemplateFile
+	}
+	var referenceDoc string
+	var template *config.TemplateInfo
+	if templateFile != "" {
+		if template, err = config.LookupTemplate(templateFile); err == nil {
+			referenceDoc = templateFile
+		} else {
+			log.Printf("忽略无效的参考模板: %v", err)
+		}
 	}
 
 	// 构建Pandoc命令
@@ -161,66 +439,301 @@ func (c *Converter) convertFile(inputFile, outputFile, templateFile string) erro
 		"-f", "markdown",
 		"-t", "docx",
 		"--standalone",
-		"--embed-resources", // 将图片等资源嵌入到输出文件中
-	}
-
-	// 添加资源路径参数，让pandoc能够找到相对路径的图片
-	// 获取输入文件的目录作为资源根目录
-	inputDir := filepath.Dir(inputFile)
-	if inputDir != "." && inputDir != "" {
-		// 添加输入文件目录和常见的图片目录到资源路径
-		resourcePaths := []string{
-			inputDir,                           // 输入文件所在目录
-			filepath.Join(inputDir, "images"),  // images子目录
-			filepath.Join(inputDir, "figures"), // figures子目录
-			filepath.Join(inputDir, "pics"),    // pics子目录
-			filepath.Join(inputDir, "assets"),  // assets子目录
-		}
-
-		// 检查哪些路径实际存在
-		var existingPaths []string
-		for _, path := range resourcePaths {
-			if _, err := os.Stat(path); err == nil {
-				existingPaths = append(existingPaths, path)
+	}
+
+	// 将图片等资源嵌入到输出文件中（旧版本Pandoc使用--self-contained）
+	if pandoc.EmbedResources {
+		args = append(args, "--embed-resources")
+	} else {
+		args = append(args, "--self-contained")
+	}
+
+	// 转换前解析引用的图片，资源路径只包含图片实际所在的目录；
+	// 找不到的图片只记录警告，由pandoc按原来的方式处理
+	markdown, err := os.ReadFile(inputFile)
+	if err != nil {
+		return nil, fmt.Errorf("读取输入文件失败: %v", err)
+	}
+	images := shared.images.scan(markdown, filepath.Dir(inputFile))
+	images.warnMissing(inputFile)
+	if len(images.resourcePaths) > 0 {
+		args = append(args, "--resource-path", strings.Join(images.resourcePaths, string(os.PathListSeparator)))
+	}
+
+	// 添加模板参数
+	if referenceDoc != "" {
+		args = append(args, "--reference-doc", referenceDoc)
+	}
+
+	return &conversionPlan{
+		cfg:          cfg,
+		pandoc:       pandoc,
+		inputFile:    inputFile,
+		outputFile:   outputFile,
+		referenceDoc: referenceDoc,
+		template:     template,
+		markdown:     markdown,
+		images:       images,
+		optimizer:    shared.optimizer,
+		args:         args,
+	}, nil
+}
+
+// executePlan 按转换参数生成输出文件
+// 输出先写到同目录下的临时文件，完成后改名，读取方不会看到写了一半的docx，
+// 转换失败或取消时也不会破坏已有的输出文件
+func (c *Converter) executePlan(ctx context.Context, plan *conversionPlan) error {
+	tempFile, err := utils.CreateTempOutput(plan.outputFile)
+	if err != nil {
+		return fmt.Errorf("无法创建输出文件: %v", err)
+	}
+	committed := false
+	defer func() {
+		if !committed {
+			os.Remove(tempFile)
+		}
+	}()
+
+	// 输入内容未变化时直接使用缓存的输出（缓存键不包含输入和输出路径）
+	var cacheKey string
+	cache := c.outputCache(plan.cfg)
+	if cache != nil {
+		if key, err := outputCacheKey(plan); err == nil {
+			if cache.restore(key, tempFile) {
+				if err := utils.CommitOutput(tempFile, plan.outputFile); err != nil {
+					return fmt.Errorf("写入输出文件失败: %v", err)
+				}
+				committed = true
+				return nil
 			}
+			cacheKey = key
 		}
+	}
+
+	// plan.args[2]是输出路径，改为临时文件
+	args := append([]string(nil), plan.args...)
+	args[2] = tempFile
 
-		// 如果有存在的路径，添加到pandoc参数中
-		if len(existingPaths) > 0 {
-			resourcePathArg := strings.Join(existingPaths, string(os.PathListSeparator))
-			args = append(args, "--resource-path", resourcePathArg)
+	// 多模板转换时从共用的AST写出，不再重新解析Markdown
+	if plan.ast != nil {
+		astFile, err := plan.ast.get(ctx, plan)
+		if err != nil {
+			return err
 		}
+		args = astArgs(args, astFile, filepath.Dir(plan.inputFile))
 	}
 
-	// 如果指定了模板文件，添加模板参数
-	if templateFile != "" {
-		if err := utils.ValidateInputFile(templateFile); err == nil {
-			args = append(args, "--reference-doc", templateFile)
+	// 优化后的图片放在单独的目录中，加在资源路径最前面
+	if plan.optimizer != nil {
+		imageDir, err := plan.optimizer.prepare(plan.images)
+		if err != nil {
+			log.Printf("准备优化后的图片失败，使用原图: %v", err)
 		}
-	} else if c.config.TemplateFile != "" {
-		if err := c.config.ValidateTemplate(); err == nil {
-			args = append(args, "--reference-doc", c.config.TemplateFile)
+		if imageDir != "" {
+			defer os.RemoveAll(imageDir)
+			args = prependResourcePath(args, imageDir, filepath.Dir(plan.inputFile))
+		}
+	}
+	if err := c.runPandoc(ctx, plan, tempFile, args); err != nil {
+		return err
+	}
+
+	// 验证输出文件是否生成（临时文件预先创建，未写入内容即视为未生成）
+	if info, err := os.Stat(tempFile); err != nil || info.Size() == 0 {
+		return fmt.Errorf("输出文件未生成: %s", plan.outputFile)
+	}
+
+	if cacheKey != "" {
+		if err := cache.store(cacheKey, tempFile); err != nil {
+			log.Printf("写入输出缓存失败: %v", err)
+		}
+	}
+
+	if err := utils.CommitOutput(tempFile, plan.outputFile); err != nil {
+		return fmt.Errorf("写入输出文件失败: %v", err)
+	}
+	committed = true
+	return nil
+}
+
+// prependResourcePath 把dir加在资源路径最前面
+// 原来没有指定资源路径时，pandoc默认在输入目录（即工作目录）中查找，保留该目录
+func prependResourcePath(args []string, dir, inputDir string) []string {
+	separator := string(os.PathListSeparator)
+	for i := 0; i+1 < len(args); i++ {
+		if args[i] == "--resource-path" {
+			args[i+1] = dir + separator + args[i+1]
+			return args
+		}
+	}
+	return append(args, "--resource-path", dir+separator+inputDir)
+}
+
+// runPandoc 执行转换：优先交给常驻pandoc server进程，失败或不支持时启动新进程
+// ctx取消时立即结束正在运行的pandoc进程
+func (c *Converter) runPandoc(ctx context.Context, plan *conversionPlan, outputFile string, args []string) error {
+	// 从AST写出时直接执行pandoc，pandoc server会重新解析Markdown
+	if server := c.pandocServer(plan.cfg, plan.pandoc); server != nil && plan.ast == nil {
+		err := server.convert(ctx, plan.markdown, outputFile, plan.template)
+		if err == nil {
+			return nil
+		}
+		if ctx.Err() != nil {
+			return ctx.Err()
+		}
+		if err != errServerUnsupported {
+			log.Printf("pandoc server转换失败，回退到常规方式: %v", err)
 		}
 	}
 
 	// 执行Pandoc命令
-	cmd := exec.Command(c.config.PandocPath, args...)
+	cmd := exec.CommandContext(ctx, plan.pandoc.Path, args...)
+	cmd.WaitDelay = pandocWaitDelay
 	output, err := cmd.CombinedOutput()
+	if ctx.Err() != nil {
+		return ctx.Err()
+	}
 	if err != nil {
 		return fmt.Errorf("Pandoc执行失败: %v, 输出: %s", err, string(output))
 	}
 
-	// 验证输出文件是否生成
-	if !utils.FileExists(outputFile) {
-		return fmt.Errorf("输出文件未生成: %s", outputFile)
+	return nil
+}
+
+// outputCache 返回按cfg创建的输出缓存，未启用或无法创建时返回nil
+// 配置更新后才结束的旧请求不再使用缓存，避免按旧配置重建
+func (c *Converter) outputCache(cfg *config.Config) *outputCache {
+	if !cfg.OutputCache {
+		return nil
 	}
 
-	return nil
+	c.cacheMu.Lock()
+	defer c.cacheMu.Unlock()
+
+	if c.cacheConfig != cfg {
+		if cfg != c.config.Load() {
+			return nil
+		}
+		c.cache = nil
+		c.cacheConfig = cfg
+		c.cacheUnavailable = false
+	}
+
+	if c.cache == nil && !c.cacheUnavailable {
+		cache, err := newOutputCache(cfg.OutputCachePath(), cfg.OutputCacheMaxMB)
+		if err != nil {
+			log.Printf("输出缓存不可用: %v", err)
+			c.cacheUnavailable = true
+			return nil
+		}
+		c.cache = cache
+	}
+	return c.cache
+}
+
+// timingHistory 返回历史转换耗时，首次使用时从文件读取
+func (c *Converter) timingHistory() *timingHistory {
+	c.historyMu.Lock()
+	defer c.historyMu.Unlock()
+
+	if c.history == nil {
+		c.history = loadTimingHistory(c.config.Load().TimingHistoryPath())
+	}
+	return c.history
+}
+
+// CacheStats 返回输出缓存统计信息，未启用缓存时返回nil
+func (c *Converter) CacheStats() *CacheStats {
+	cache := c.outputCache(c.config.Load())
+	if cache == nil {
+		return nil
+	}
+	stats := cache.snapshot()
+	return &stats
+}
+
+// CheckBulkAdmission 检查批量通道能否接受新的批量请求，排队已满时返回*QueueFullError
+func (c *Converter) CheckBulkAdmission() error {
+	return c.admission.check(LaneBulk)
+}
+
+// LaneStats 返回各优先级通道的排队统计
+func (c *Converter) LaneStats() map[string]LaneStats {
+	return c.admission.stats()
 }
 
-// UpdateConfig 更新配置
+// pandocServer 返回按cfg创建的常驻pandoc server进程池，未启用或不可用时返回nil
+// 配置更新后才结束的旧请求直接启动pandoc进程，不会按旧配置重建进程池
+func (c *Converter) pandocServer(cfg *config.Config, pandoc *config.PandocInfo) *pandocServerPool {
+	if !cfg.PandocServer {
+		return nil
+	}
+
+	c.serverMu.Lock()
+	defer c.serverMu.Unlock()
+
+	if c.serverConfig != cfg {
+		if cfg != c.config.Load() {
+			return nil
+		}
+		if c.server != nil {
+			c.server.drain()
+			c.server = nil
+		}
+		c.serverConfig = cfg
+		c.serverUnavailable = false
+	}
+
+	if c.server == nil && !c.serverUnavailable {
+		pool, err := newPandocServerPool(pandoc.Path, cfg.Workers(),
+			cfg.PandocServerMaxJobs, cfg.PandocServerMaxMemoryMB)
+		if err != nil {
+			log.Printf("%v，使用常规方式转换", err)
+			c.serverUnavailable = true
+			return nil
+		}
+		c.server = pool
+	}
+	return c.server
+}
+
+// retireStaleServer 配置更新后停止按旧配置创建的进程池
+// 正在转换的进程完成当前文档后才退出，不影响进行中的请求
+func (c *Converter) retireStaleServer() {
+	c.serverMu.Lock()
+	defer c.serverMu.Unlock()
+
+	if c.server != nil && c.serverConfig != c.config.Load() {
+		c.server.drain()
+		c.server = nil
+		c.serverConfig = nil
+		c.serverUnavailable = false
+	}
+}
+
+// UpdateConfig 发布新配置，进行中的转换继续使用开始时的配置
 func (c *Converter) UpdateConfig(cfg *config.Config) {
-	c.mu.Lock()
-	defer c.mu.Unlock()
-	c.config = cfg
+	c.config.Publish(cfg)
+	c.ConfigUpdated()
+}
+
+// ConfigUpdated 按最新发布的配置调整并发数和排队上限，不等待进行中的转换
+// 进程池在后台按需停止，输出缓存在下一次使用时按新配置重建
+func (c *Converter) ConfigUpdated() {
+	cfg := c.config.Load()
+	c.admission.resize(cfg.Workers(), cfg.QueueLimit())
+	go c.retireStaleServer()
+}
+
+// Close 释放转换器持有的后台进程
+func (c *Converter) Close() {
+	c.serverMu.Lock()
+	defer c.serverMu.Unlock()
+
+	if c.server != nil {
+		c.server.close()
+		c.server = nil
+	}
+	c.serverConfig = nil
+	c.serverUnavailable = false
 }
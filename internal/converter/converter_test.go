@@ -1,8 +1,25 @@
 package converter
 
 import (
+	"archive/zip"
+	"bytes"
+	"context"
+	"fmt"
+	"image"
+	"image/color"
+	"image/jpeg"
+	"image/png"
+	"io"
+	"net/http"
+	"net/http/httptest"
 	"os"
+	"os/exec"
+	"path/filepath"
+	"runtime"
+	"strings"
+	"sync"
 	"testing"
+	"time"
 
 	"md2docx/internal/config"
 	"md2docx/internal/models"
@@ -18,7 +35,7 @@ func TestNew(t *testing.T) {
 		t.Fatal("创建转换器失败")
 	}
 
-	if converter.config != cfg {
+	if converter.config.Load() != cfg {
 		t.Error("转换器配置不匹配")
 	}
 }
@@ -181,6 +198,1189 @@ func TestConvertBatch_ValidInput(t *testing.T) {
 	}
 }
 
+func TestConvertBatch_ParallelPreservesOrder(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	// 假pandoc：文件名包含slow的文档耗时较长，其余立即完成
+	fakePandoc := createFakePandoc(t, tmpDir)
+
+	var inputFiles []string
+	for i := 0; i < 6; i++ {
+		name := fmt.Sprintf("doc%d.md", i)
+		if i == 0 {
+			name = "slow.md"
+		}
+		path := filepath.Join(tmpDir, name)
+		if err := os.WriteFile(path, []byte("# 标题\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		inputFiles = append(inputFiles, path)
+	}
+
+	cfg := &config.Config{
+		PandocPath: fakePandoc,
+		MaxWorkers: 2,
+	}
+	converter := New(cfg)
+
+	start := time.Now()
+	resp, err := converter.ConvertBatch(&models.BatchConversionRequest{
+		InputFiles: inputFiles,
+		OutputDir:  filepath.Join(tmpDir, "out"),
+	})
+	if err != nil {
+		t.Fatalf("批量转换时发生错误: %v", err)
+	}
+
+	if len(resp.Results) != len(inputFiles) {
+		t.Fatalf("期望结果数量 %d, 实际 %d", len(inputFiles), len(resp.Results))
+	}
+	for i, result := range resp.Results {
+		if result.InputFile != inputFiles[i] {
+			t.Errorf("结果顺序错误: 位置%d 期望 %s, 实际 %s", i, inputFiles[i], result.InputFile)
+		}
+		if !result.Success {
+			t.Errorf("文件 %s 转换失败: %s", result.InputFile, result.Error)
+		}
+	}
+
+	// 慢文档不应阻塞其他文档：总耗时应接近单个慢文档的耗时
+	if elapsed := time.Since(start); elapsed > 3*time.Second {
+		t.Errorf("批量转换耗时过长: %v", elapsed)
+	}
+}
+
+func TestConvertBatch_ProbesPandocOnce(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+
+	var inputFiles []string
+	for i := 0; i < 5; i++ {
+		path := filepath.Join(tmpDir, fmt.Sprintf("doc%d.md", i))
+		if err := os.WriteFile(path, []byte("# 标题\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		inputFiles = append(inputFiles, path)
+	}
+
+	converter := New(&config.Config{PandocPath: fakePandoc})
+	for round := 0; round < 2; round++ {
+		resp, err := converter.ConvertBatch(&models.BatchConversionRequest{InputFiles: inputFiles})
+		if err != nil || !resp.Success {
+			t.Fatalf("批量转换失败: %v %+v", err, resp)
+		}
+	}
+
+	// 10次转换只应探测一次pandoc --version
+	data, err := os.ReadFile(filepath.Join(tmpDir, "probe.log"))
+	if err != nil {
+		t.Fatalf("读取探测记录失败: %v", err)
+	}
+	if probes := len(data); probes != 1 {
+		t.Errorf("期望探测pandoc 1次, 实际 %d次", probes)
+	}
+}
+
+func TestConvertSingle_PandocServerFallback(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	// 假pandoc不支持server模式，应自动回退到启动新进程
+	fakePandoc := createFakePandoc(t, tmpDir)
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(inputFile, []byte("# 标题\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	converter := New(&config.Config{PandocPath: fakePandoc, PandocServer: true})
+	defer converter.Close()
+
+	resp, err := converter.ConvertSingle(&models.ConversionRequest{InputFile: inputFile})
+	if err != nil || !resp.Success {
+		t.Fatalf("回退转换失败: %v %+v", err, resp)
+	}
+	if !converter.serverUnavailable {
+		t.Error("期望标记server模式不可用")
+	}
+}
+
+func TestPandocServerPool_DrainDuringConvert(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要sleep命令模拟pandoc server进程")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	// 用HTTP测试服务器代替pandoc server，进程只用于回收
+	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		io.Copy(io.Discard, r.Body)
+		w.Write([]byte("docx"))
+	}))
+	defer server.Close()
+
+	cmd := exec.Command("sleep", "30")
+	if err := cmd.Start(); err != nil {
+		t.Fatalf("启动进程失败: %v", err)
+	}
+	worker := &pandocServerWorker{cmd: cmd, url: server.URL, done: make(chan struct{})}
+	go func() {
+		cmd.Wait()
+		close(worker.done)
+	}()
+
+	pool := &pandocServerPool{
+		size:      1,
+		started:   1,
+		maxJobs:   1000,
+		maxMemory: 1 << 40,
+		client:    server.Client(),
+		idle:      make(chan *pandocServerWorker, 1),
+		workers:   map[*pandocServerWorker]struct{}{worker: {}},
+	}
+	pool.idle <- worker
+
+	// 配置变化时进程池被drain，正在发起的转换应返回错误而不是崩溃
+	var wg sync.WaitGroup
+	for i := 0; i < 4; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			output := filepath.Join(tmpDir, fmt.Sprintf("out-%d.docx", i))
+			for j := 0; j < 50; j++ {
+				pool.convert(context.Background(), []byte("# 标题\n"), output, nil)
+			}
+		}(i)
+	}
+	time.Sleep(10 * time.Millisecond)
+	pool.drain()
+	wg.Wait()
+
+	if err := pool.convert(context.Background(), []byte("# 标题\n"), filepath.Join(tmpDir, "late.docx"), nil); err == nil {
+		t.Error("进程池关闭后期望返回错误")
+	}
+	pool.mu.Lock()
+	defer pool.mu.Unlock()
+	if len(pool.workers) != 0 {
+		t.Errorf("关闭后仍记录 %d 个进程", len(pool.workers))
+	}
+}
+
+func TestConvertSingle_OutputCache(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	imagePath := filepath.Join(tmpDir, "pic.png")
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(imagePath, []byte("png-v1"), 0644); err != nil {
+		t.Fatalf("写入图片失败: %v", err)
+	}
+	if err := os.WriteFile(inputFile, []byte("# 标题\n\n![图](pic.png)\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	converter := New(&config.Config{
+		PandocPath:     fakePandoc,
+		OutputCache:    true,
+		OutputCacheDir: filepath.Join(tmpDir, "cache"),
+	})
+	convert := func() {
+		req := &models.ConversionRequest{InputFile: inputFile, OutputDir: filepath.Join(tmpDir, "out")}
+		if resp, err := converter.ConvertSingle(req); err != nil || !resp.Success {
+			t.Fatalf("转换失败: %v %+v", err, resp)
+		}
+	}
+	conversions := func() int {
+		data, _ := os.ReadFile(filepath.Join(tmpDir, "convert.log"))
+		return len(data)
+	}
+
+	// 第二次转换命中缓存，不执行pandoc
+	convert()
+	convert()
+	if n := conversions(); n != 1 {
+		t.Errorf("期望执行pandoc 1次, 实际 %d次", n)
+	}
+
+	// 引用的图片变化后缓存失效
+	if err := os.WriteFile(imagePath, []byte("png-v2"), 0644); err != nil {
+		t.Fatalf("写入图片失败: %v", err)
+	}
+	convert()
+	if n := conversions(); n != 2 {
+		t.Errorf("期望执行pandoc 2次, 实际 %d次", n)
+	}
+
+	stats := converter.CacheStats()
+	if stats == nil || stats.Hits != 1 || stats.Misses != 2 || stats.Entries != 2 {
+		t.Errorf("缓存统计不正确: %+v", stats)
+	}
+}
+
+func TestConvertSingle_OutputCacheInstance(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(inputFile, []byte("# 标题\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	// 进程池中的后端使用各自的缓存目录和历史耗时文件
+	cacheDir := filepath.Join(tmpDir, "cache")
+	cfg := &config.Config{
+		PandocPath:        fakePandoc,
+		OutputCache:       true,
+		OutputCacheDir:    cacheDir,
+		TimingHistoryFile: filepath.Join(tmpDir, "timings.json"),
+		Instance:          2,
+	}
+	if path := cfg.TimingHistoryPath(); path != filepath.Join(tmpDir, "timings-2.json") {
+		t.Errorf("历史耗时文件 = %s", path)
+	}
+
+	converter := New(cfg)
+	defer converter.Close()
+	req := &models.ConversionRequest{InputFile: inputFile, OutputDir: filepath.Join(tmpDir, "out")}
+	if resp, err := converter.ConvertSingle(req); err != nil || !resp.Success {
+		t.Fatalf("转换失败: %v %+v", err, resp)
+	}
+
+	entries, err := os.ReadDir(cacheDir + "-2")
+	if err != nil || len(entries) != 1 {
+		t.Errorf("期望缓存写入 %s-2: %v %d", cacheDir, err, len(entries))
+	}
+	if _, err := os.Stat(cacheDir); !os.IsNotExist(err) {
+		t.Errorf("不应使用共享的缓存目录: %v", err)
+	}
+}
+
+func TestOutputCache_Eviction(t *testing.T) {
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	cache, err := newOutputCache(filepath.Join(tmpDir, "cache"), 1)
+	if err != nil {
+		t.Fatalf("创建缓存失败: %v", err)
+	}
+
+	// 每个文件600KB，上限1MB时只能保留一个
+	output := filepath.Join(tmpDir, "out.docx")
+	if err := os.WriteFile(output, make([]byte, 600*1024), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+	for _, key := range []string{"first", "second"} {
+		if err := cache.store(key, output); err != nil {
+			t.Fatalf("写入缓存失败: %v", err)
+		}
+	}
+
+	if cache.restore("first", output) {
+		t.Error("最早的条目应已被淘汰")
+	}
+	if !cache.restore("second", output) {
+		t.Error("最新的条目应仍在缓存中")
+	}
+	if stats := cache.snapshot(); stats.Evictions != 1 || stats.Entries != 1 {
+		t.Errorf("缓存统计不正确: %+v", stats)
+	}
+}
+
+func TestConvertBatch_Incremental(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	imagePath := filepath.Join(tmpDir, "pic.png")
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(imagePath, []byte("png"), 0644); err != nil {
+		t.Fatalf("写入图片失败: %v", err)
+	}
+	if err := os.WriteFile(inputFile, []byte("![图](pic.png)\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	converter := New(&config.Config{PandocPath: fakePandoc})
+	convert := func() models.ConversionResult {
+		resp, err := converter.ConvertBatch(&models.BatchConversionRequest{
+			InputFiles:  []string{inputFile},
+			OutputDir:   filepath.Join(tmpDir, "out"),
+			Incremental: true,
+		})
+		if err != nil || len(resp.Results) != 1 {
+			t.Fatalf("批量转换失败: %v %+v", err, resp)
+		}
+		return resp.Results[0]
+	}
+
+	if result := convert(); result.Status != models.StatusCompleted {
+		t.Errorf("首次转换期望状态 %s, 实际 %s", models.StatusCompleted, result.Status)
+	}
+	if result := convert(); result.Status != models.StatusSkipped || !result.Success {
+		t.Errorf("输出已是最新时期望状态 %s, 实际 %+v", models.StatusSkipped, result)
+	}
+
+	// 图片比输出新时需要重新转换
+	future := time.Now().Add(time.Hour)
+	if err := os.Chtimes(imagePath, future, future); err != nil {
+		t.Fatalf("修改图片时间失败: %v", err)
+	}
+	if result := convert(); result.Status != models.StatusCompleted {
+		t.Errorf("图片更新后期望状态 %s, 实际 %s", models.StatusCompleted, result.Status)
+	}
+
+	// 图片被删除时重新转换（由pandoc处理缺少的图片），而不是失败
+	if err := os.Remove(imagePath); err != nil {
+		t.Fatalf("删除图片失败: %v", err)
+	}
+	if result := convert(); result.Status != models.StatusCompleted || !result.Success {
+		t.Errorf("图片删除后期望状态 %s, 实际 %+v", models.StatusCompleted, result)
+	}
+}
+
+func TestConvertBatch_Order(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+
+	// 代价依次递增：纯文本、带表格、带图片的大文档
+	small := filepath.Join(tmpDir, "small.md")
+	table := filepath.Join(tmpDir, "table.md")
+	large := filepath.Join(tmpDir, "large.md")
+	image := filepath.Join(tmpDir, "figure.png")
+	files := map[string]string{
+		small: "# 标题\n",
+		table: "| a | b |\n|---|---|\n| 1 | 2 |\n",
+		large: strings.Repeat("正文段落。\n\n", 2000) + "![图](figure.png)\n",
+		image: strings.Repeat("x", 512*1024),
+	}
+	for path, content := range files {
+		if err := os.WriteFile(path, []byte(content), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+	}
+
+	inputFiles := []string{table, small, large}
+
+	for _, tc := range []struct {
+		order string
+		want  []string
+	}{
+		{models.OrderInput, []string{table, small, large}},
+		{models.OrderLongestFirst, []string{large, table, small}},
+		{models.OrderShortestFirst, []string{small, table, large}},
+	} {
+		// 每种顺序使用独立的历史记录，避免上一轮的实际耗时影响估算
+		historyFile := filepath.Join(tmpDir, "timings-"+tc.order+".json")
+		converter := New(&config.Config{PandocPath: fakePandoc, MaxWorkers: 1, TimingHistoryFile: historyFile})
+
+		os.Remove(filepath.Join(tmpDir, "order.log"))
+		resp, err := converter.ConvertBatch(&models.BatchConversionRequest{
+			InputFiles: inputFiles,
+			OutputDir:  filepath.Join(tmpDir, "out"),
+			Order:      tc.order,
+		})
+		if err != nil || !resp.Success {
+			t.Fatalf("批量转换失败: %v %+v", err, resp)
+		}
+
+		// 结果仍按输入顺序返回
+		for i, result := range resp.Results {
+			if result.InputFile != inputFiles[i] {
+				t.Errorf("%q: 结果顺序错误: 位置%d 期望 %s, 实际 %s", tc.order, i, inputFiles[i], result.InputFile)
+			}
+		}
+
+		data, err := os.ReadFile(filepath.Join(tmpDir, "order.log"))
+		if err != nil {
+			t.Fatalf("读取转换顺序失败: %v", err)
+		}
+		if got := strings.Fields(string(data)); strings.Join(got, ",") != strings.Join(tc.want, ",") {
+			t.Errorf("%q: 转换顺序 = %v, 期望 %v", tc.order, got, tc.want)
+		}
+	}
+
+	// 调度过的批量转换记录了每个文件的实际耗时
+	history := loadTimingHistory(filepath.Join(tmpDir, "timings-"+models.OrderLongestFirst+".json"))
+	for _, path := range inputFiles {
+		if _, ok := history.entries[path]; !ok {
+			t.Errorf("历史耗时中缺少 %s", path)
+		}
+	}
+}
+
+func TestAdmission_Lanes(t *testing.T) {
+	a := newAdmission(2, 8)
+	ctx := context.Background()
+
+	// 批量通道最多占用一个槽位，第二个批量请求排队
+	releaseBulk, err := a.acquire(ctx, LaneBulk)
+	if err != nil {
+		t.Fatalf("获取批量槽位失败: %v", err)
+	}
+	bulkAdmitted := make(chan func())
+	go func() {
+		release, _ := a.acquire(ctx, LaneBulk)
+		bulkAdmitted <- release
+	}()
+
+	// 保留的槽位立即分给交互式请求
+	releaseInteractive, err := a.acquire(ctx, LaneInteractive)
+	if err != nil {
+		t.Fatalf("获取交互式槽位失败: %v", err)
+	}
+
+	// 槽位占满后交互式请求也排队，且先于批量请求获得空闲槽位
+	interactiveAdmitted := make(chan func())
+	go func() {
+		release, _ := a.acquire(ctx, LaneInteractive)
+		interactiveAdmitted <- release
+	}()
+	for a.stats()[LaneInteractive.String()].Queued != 1 {
+		time.Sleep(time.Millisecond)
+	}
+	if stats := a.stats()[LaneBulk.String()]; stats.Queued != 1 || stats.Running != 1 {
+		t.Errorf("批量通道统计 = %+v, 期望排队1个、执行1个", stats)
+	}
+
+	releaseBulk()
+	select {
+	case release := <-interactiveAdmitted:
+		release()
+	case <-bulkAdmitted:
+		t.Fatal("批量请求先于交互式请求获得槽位")
+	case <-time.After(time.Second):
+		t.Fatal("交互式请求未获得槽位")
+	}
+	releaseInteractive()
+
+	select {
+	case release := <-bulkAdmitted:
+		release()
+	case <-time.After(time.Second):
+		t.Fatal("批量请求未获得槽位")
+	}
+
+	// 排队时取消返回ctx的错误，不占用槽位
+	releaseBulk, _ = a.acquire(ctx, LaneBulk)
+	cancelCtx, cancel := context.WithCancel(ctx)
+	cancel()
+	if _, err := a.acquire(cancelCtx, LaneBulk); err != context.Canceled {
+		t.Errorf("期望 context.Canceled, 实际 %v", err)
+	}
+	releaseBulk()
+
+	stats := a.stats()
+	if stats[LaneBulk.String()].Admitted != 3 || stats[LaneInteractive.String()].Admitted != 2 {
+		t.Errorf("累计获得槽位数错误: %+v", stats)
+	}
+	if stats[LaneBulk.String()].Running != 0 || stats[LaneBulk.String()].Queued != 0 {
+		t.Errorf("释放后批量通道仍有占用: %+v", stats[LaneBulk.String()])
+	}
+}
+
+func TestAdmission_QueueLimit(t *testing.T) {
+	a := newAdmission(1, 1)
+	ctx := context.Background()
+
+	release, err := a.tryAcquire(ctx, LaneInteractive)
+	if err != nil {
+		t.Fatalf("获取槽位失败: %v", err)
+	}
+
+	// 第一个排队的请求被接受
+	waitCtx, cancel := context.WithCancel(ctx)
+	queued := make(chan error)
+	go func() {
+		_, err := a.tryAcquire(waitCtx, LaneInteractive)
+		queued <- err
+	}()
+	for a.stats()[LaneInteractive.String()].Queued != 1 {
+		time.Sleep(time.Millisecond)
+	}
+
+	// 排队已满，立即拒绝并给出重试时间
+	_, err = a.tryAcquire(ctx, LaneInteractive)
+	queueFull, ok := err.(*QueueFullError)
+	if !ok {
+		t.Fatalf("期望 *QueueFullError, 实际 %v", err)
+	}
+	if queueFull.RetryAfter < time.Second || queueFull.RetryAfter > maxRetryAfter {
+		t.Errorf("重试时间超出范围: %v", queueFull.RetryAfter)
+	}
+	if err := a.check(LaneBulk); err != nil {
+		t.Errorf("批量通道未满时不应拒绝: %v", err)
+	}
+
+	cancel()
+	if err := <-queued; err != context.Canceled {
+		t.Errorf("期望 context.Canceled, 实际 %v", err)
+	}
+	release()
+
+	if stats := a.stats()[LaneInteractive.String()]; stats.Rejected != 1 || stats.Queued != 0 || stats.Running != 0 {
+		t.Errorf("交互式通道统计错误: %+v", stats)
+	}
+}
+
+func TestConvertSingle_NotBlockedByBatch(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	converter := New(&config.Config{PandocPath: fakePandoc, MaxWorkers: 2})
+
+	var inputFiles []string
+	for i := 0; i < 2; i++ {
+		path := filepath.Join(tmpDir, fmt.Sprintf("slow%d.md", i))
+		if err := os.WriteFile(path, []byte("# 慢文档\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		inputFiles = append(inputFiles, path)
+	}
+	single := filepath.Join(tmpDir, "single.md")
+	if err := os.WriteFile(single, []byte("# 单个文档\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	batchDone := make(chan struct{})
+	go func() {
+		defer close(batchDone)
+		converter.ConvertBatch(&models.BatchConversionRequest{
+			InputFiles: inputFiles,
+			OutputDir:  filepath.Join(tmpDir, "batch"),
+		})
+	}()
+	for converter.LaneStats()[LaneBulk.String()].Running == 0 {
+		time.Sleep(time.Millisecond)
+	}
+
+	// 批量转换占用的槽位之外保留了一个，单文件转换无需等待
+	start := time.Now()
+	resp, err := converter.ConvertSingle(&models.ConversionRequest{
+		InputFile: single,
+		OutputDir: filepath.Join(tmpDir, "single"),
+	})
+	if err != nil || !resp.Success {
+		t.Fatalf("单文件转换失败: %v %+v", err, resp)
+	}
+	if elapsed := time.Since(start); elapsed > 800*time.Millisecond {
+		t.Errorf("单文件转换等待了批量转换: 耗时 %v", elapsed)
+	}
+
+	<-batchDone
+	stats := converter.LaneStats()
+	if stats[LaneBulk.String()].Admitted != 2 || stats[LaneInteractive.String()].Admitted != 1 {
+		t.Errorf("通道统计错误: %+v", stats)
+	}
+}
+
+func TestConvertSingleContext_Cancel(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	converter := New(&config.Config{PandocPath: createFakePandoc(t, tmpDir)})
+	inputFile := filepath.Join(tmpDir, "hang.md")
+	if err := os.WriteFile(inputFile, []byte("# 卡住的文档\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	time.AfterFunc(200*time.Millisecond, cancel)
+
+	// 取消后立即结束pandoc进程，而不是等它运行完
+	start := time.Now()
+	resp, err := converter.ConvertSingleContext(ctx, &models.ConversionRequest{
+		InputFile: inputFile,
+		OutputDir: filepath.Join(tmpDir, "out"),
+	})
+	if err != nil {
+		t.Fatalf("转换返回错误: %v", err)
+	}
+	if resp.Success || resp.Error != "转换已取消" {
+		t.Errorf("期望转换已取消, 实际 %+v", resp)
+	}
+	if elapsed := time.Since(start); elapsed > 5*time.Second {
+		t.Errorf("取消后仍等待了pandoc: 耗时 %v", elapsed)
+	}
+	if stats := converter.LaneStats()[LaneInteractive.String()]; stats.Running != 0 {
+		t.Errorf("取消后未释放槽位: %+v", stats)
+	}
+}
+
+func TestConvertSingle_AtomicOutput(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	converter := New(&config.Config{PandocPath: createFakePandoc(t, tmpDir)})
+	outputDir := filepath.Join(tmpDir, "out")
+	if err := os.MkdirAll(outputDir, 0755); err != nil {
+		t.Fatalf("创建目录失败: %v", err)
+	}
+	for _, name := range []string{"hang.md", "ok.md"} {
+		if err := os.WriteFile(filepath.Join(tmpDir, name), []byte("# 文档\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+	}
+	previous := filepath.Join(outputDir, "hang.docx")
+	if err := os.WriteFile(previous, []byte("old"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	// 转换中途取消时，上一次的输出保持不变
+	ctx, cancel := context.WithTimeout(context.Background(), 200*time.Millisecond)
+	defer cancel()
+	resp, err := converter.ConvertSingleContext(ctx, &models.ConversionRequest{
+		InputFile: filepath.Join(tmpDir, "hang.md"),
+		OutputDir: outputDir,
+	})
+	if err != nil || resp.Success {
+		t.Fatalf("期望转换失败, 实际 %+v, %v", resp, err)
+	}
+	if data, _ := os.ReadFile(previous); string(data) != "old" {
+		t.Errorf("取消的转换覆盖了已有输出: %q", data)
+	}
+
+	resp, err = converter.ConvertSingle(&models.ConversionRequest{
+		InputFile: filepath.Join(tmpDir, "ok.md"),
+		OutputDir: outputDir,
+	})
+	if err != nil || !resp.Success {
+		t.Fatalf("转换失败: %+v, %v", resp, err)
+	}
+	if data, _ := os.ReadFile(resp.OutputFile); string(data) != "docx\n" {
+		t.Errorf("输出内容不正确: %q", data)
+	}
+
+	// 成功和失败后都不应留下临时文件或写入探测文件
+	entries, err := os.ReadDir(outputDir)
+	if err != nil {
+		t.Fatalf("读取目录失败: %v", err)
+	}
+	for _, entry := range entries {
+		if name := entry.Name(); name != "hang.docx" && name != "ok.docx" {
+			t.Errorf("输出目录中残留文件: %s", name)
+		}
+	}
+}
+
+func TestConvertBatchContext_Deadline(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	converter := New(&config.Config{PandocPath: createFakePandoc(t, tmpDir), MaxWorkers: 2})
+	inputFiles := []string{filepath.Join(tmpDir, "doc.md"), filepath.Join(tmpDir, "hang.md")}
+	for _, path := range inputFiles {
+		if err := os.WriteFile(path, []byte("# 文档\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+	}
+
+	// 截止时间到达时结束卡住的pandoc，超时的文件视为失败
+	ctx, cancel := context.WithTimeout(context.Background(), 300*time.Millisecond)
+	defer cancel()
+	start := time.Now()
+	resp, err := converter.ConvertBatchContext(ctx, &models.BatchConversionRequest{
+		InputFiles: inputFiles,
+		OutputDir:  filepath.Join(tmpDir, "out"),
+	}, nil)
+	if err != nil {
+		t.Fatalf("批量转换返回错误: %v", err)
+	}
+	if elapsed := time.Since(start); elapsed > 5*time.Second {
+		t.Errorf("超过截止时间后仍等待了pandoc: 耗时 %v", elapsed)
+	}
+	if result := resp.Results[0]; result.Status != models.StatusCompleted {
+		t.Errorf("截止时间前完成的文件状态 = %s, 期望 %s", result.Status, models.StatusCompleted)
+	}
+	if result := resp.Results[1]; result.Status != models.StatusFailed || result.Error != "已超过请求的截止时间，转换已停止" {
+		t.Errorf("超时文件的结果不正确: %+v", result)
+	}
+}
+
+func TestConvertStream(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	converter := New(&config.Config{PandocPath: createFakePandoc(t, tmpDir)})
+	images := map[string]StreamImage{
+		"figure.png": {ContentType: "image/png", Data: []byte("png")},
+	}
+
+	// 上传的图片按文件名替换为data URI，未上传的引用保持不变
+	markdown := "# 标题\n![图](images/figure.png)\n![远程](missing.png)\n<img src=\"figure.png\">"
+	var out strings.Builder
+	started := false
+	err := converter.ConvertStream(context.Background(), strings.NewReader(markdown), images, func() io.Writer {
+		started = true
+		return &out
+	})
+	if err != nil {
+		t.Fatalf("流式转换失败: %v", err)
+	}
+	want := "# 标题\n![图](data:image/png;base64,cG5n)\n![远程](missing.png)\n<img src=\"data:image/png;base64,cG5n\">"
+	if !started || out.String() != want {
+		t.Errorf("输出 = %q, 期望 %q", out.String(), want)
+	}
+
+	// pandoc失败时不开始输出，返回包含错误输出的错误
+	started = false
+	err = converter.ConvertStream(context.Background(), strings.NewReader("FAIL"), nil, func() io.Writer {
+		started = true
+		return io.Discard
+	})
+	if err == nil || started || !strings.Contains(err.Error(), "bad input") {
+		t.Errorf("期望失败且不开始输出, 实际 err=%v started=%v", err, started)
+	}
+
+	// 没有创建任何临时文件或输出文件
+	entries, _ := os.ReadDir(tmpDir)
+	for _, entry := range entries {
+		if entry.Name() != "pandoc" && !strings.HasSuffix(entry.Name(), ".log") {
+			t.Errorf("流式转换留下了文件: %s", entry.Name())
+		}
+	}
+}
+
+func TestImageReferences(t *testing.T) {
+	markdown := "![行内](a.png \"标题\")\n" +
+		"![引用式][Fig One]\n" +
+		"![fig two]\n" +
+		"<img alt=\"x\" src=\"c.png\">\n" +
+		"![远程](https://example.com/d.png)\n" +
+		"`![行内代码](code.png)`\n" +
+		"```\n![代码块](fenced.png)\n```\n" +
+		"\n    ![缩进代码](indented.png)\n\n" +
+		"<!-- ![旧图](old.png)\n![旧图二](old2.png) -->\n" +
+		"\\![转义](escaped.png)\n" +
+		"\\\\![转义的反斜杠](f.png)\n" +
+		"![下划线](my\\_pic.png)\n" +
+		"\n- 列表项\n\n    ![列表内容](g.png)\n" +
+		"\n[fig one]: b.png\n[Fig Two]: <images/e.png> \"说明\"\n"
+
+	got := imageReferences([]byte(markdown))
+	want := []string{"a.png", "f.png", "my_pic.png", "g.png", "c.png", "b.png", "images/e.png"}
+	if strings.Join(got, ",") != strings.Join(want, ",") {
+		t.Errorf("期望 %v, 实际 %v", want, got)
+	}
+}
+
+func TestImageResolver_Scan(t *testing.T) {
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	for _, dir := range []string{"images", "figures", "assets"} {
+		if err := os.Mkdir(filepath.Join(tmpDir, dir), 0755); err != nil {
+			t.Fatalf("创建目录失败: %v", err)
+		}
+	}
+	if err := os.WriteFile(filepath.Join(tmpDir, "images", "a.png"), []byte("png"), 0644); err != nil {
+		t.Fatalf("写入图片失败: %v", err)
+	}
+	if err := os.WriteFile(filepath.Join(tmpDir, "my pic.png"), []byte("png"), 0644); err != nil {
+		t.Fatalf("写入图片失败: %v", err)
+	}
+
+	resolver := newImageResolver()
+	scan := resolver.scan([]byte("![a](a.png)\n![b](my%20pic.png)\n![c](missing.png)\n"), tmpDir)
+
+	want := []string{filepath.Join(tmpDir, "images", "a.png"), filepath.Join(tmpDir, "my pic.png")}
+	if strings.Join(scan.images, ",") != strings.Join(want, ",") {
+		t.Errorf("期望图片 %v, 实际 %v", want, scan.images)
+	}
+	// 只包含图片实际所在的目录，没有图片的figures和assets不在其中
+	wantPaths := []string{tmpDir, filepath.Join(tmpDir, "images")}
+	if strings.Join(scan.resourcePaths, ",") != strings.Join(wantPaths, ",") {
+		t.Errorf("期望资源路径 %v, 实际 %v", wantPaths, scan.resourcePaths)
+	}
+	if len(scan.missing) != 1 || scan.missing[0] != "missing.png" {
+		t.Errorf("期望报告缺少missing.png, 实际 %v", scan.missing)
+	}
+
+	// 没有图片的文档不需要资源路径
+	if scan := resolver.scan([]byte("# 标题\n"), tmpDir); len(scan.resourcePaths) != 0 {
+		t.Errorf("期望没有资源路径, 实际 %v", scan.resourcePaths)
+	}
+}
+
+func TestConvertSingle_MissingImage(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(inputFile, []byte("![图](figures/missing.png)\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	// 找不到的图片只记录警告，仍由pandoc转换（pandoc以图片说明代替）
+	converter := New(&config.Config{PandocPath: fakePandoc})
+	resp, err := converter.ConvertSingle(&models.ConversionRequest{InputFile: inputFile})
+	if err != nil || !resp.Success {
+		t.Fatalf("缺少图片时期望照常转换, 实际 %v %+v", err, resp)
+	}
+	if _, err := os.Stat(filepath.Join(tmpDir, "convert.log")); err != nil {
+		t.Error("缺少图片时应执行pandoc")
+	}
+}
+
+// 辅助函数：生成带渐变的测试图片
+func createTestImage(width, height int) *image.RGBA {
+	img := image.NewRGBA(image.Rect(0, 0, width, height))
+	for y := 0; y < height; y++ {
+		for x := 0; x < width; x++ {
+			img.Set(x, y, color.RGBA{uint8(x), uint8(y), uint8(x + y), 255})
+		}
+	}
+	return img
+}
+
+func TestOptimizeImage_PNG(t *testing.T) {
+	var buf bytes.Buffer
+	if err := png.Encode(&buf, createTestImage(1000, 500)); err != nil {
+		t.Fatalf("编码图片失败: %v", err)
+	}
+
+	// 1000像素按96 DPI超出6.5英寸页宽，缩小到6.5英寸×50 DPI
+	output, ok := optimizeImage(buf.Bytes(), 50, 85, 6.5)
+	if !ok {
+		t.Fatal("期望缩小图片")
+	}
+	cfg, format, err := image.DecodeConfig(bytes.NewReader(output))
+	if err != nil || format != "png" || cfg.Width != 325 || cfg.Height != 163 {
+		t.Fatalf("期望325x163的PNG, 实际 %s %dx%d (%v)", format, cfg.Width, cfg.Height, err)
+	}
+	// 写入新的分辨率，pandoc计算出的显示宽度仍为6.5英寸
+	if dpi := pngDPI(output); dpi < 49.9 || dpi > 50.1 {
+		t.Errorf("期望分辨率50 DPI, 实际 %v", dpi)
+	}
+
+	// 不超出目标分辨率且重新压缩没有变小时使用原图
+	buf.Reset()
+	if err := (&png.Encoder{CompressionLevel: png.BestCompression}).Encode(&buf, createTestImage(100, 50)); err != nil {
+		t.Fatalf("编码图片失败: %v", err)
+	}
+	if _, ok := optimizeImage(buf.Bytes(), 100, 85, 6.5); ok {
+		t.Error("小图片不应被替换")
+	}
+}
+
+func TestOptimizeImage_JPEG(t *testing.T) {
+	var buf bytes.Buffer
+	if err := jpeg.Encode(&buf, createTestImage(1200, 600), &jpeg.Options{Quality: 100}); err != nil {
+		t.Fatalf("编码图片失败: %v", err)
+	}
+	// 300 DPI时显示宽度为4英寸，按150 DPI缩小到600像素
+	source := setJPEGDPI(buf.Bytes(), 300)
+	if dpi := jpegDPI(source); dpi != 300 {
+		t.Fatalf("期望读取到300 DPI, 实际 %v", dpi)
+	}
+
+	output, ok := optimizeImage(source, 150, 80, 6.5)
+	if !ok {
+		t.Fatal("期望缩小图片")
+	}
+	cfg, format, err := image.DecodeConfig(bytes.NewReader(output))
+	if err != nil || format != "jpeg" || cfg.Width != 600 || cfg.Height != 300 {
+		t.Fatalf("期望600x300的JPEG, 实际 %s %dx%d (%v)", format, cfg.Width, cfg.Height, err)
+	}
+	if dpi := jpegDPI(output); dpi != 150 {
+		t.Errorf("期望分辨率150 DPI, 实际 %v", dpi)
+	}
+	if len(output) >= len(source) {
+		t.Errorf("期望输出变小: %d >= %d", len(output), len(source))
+	}
+}
+
+func TestImageOptimizer_SharedImage(t *testing.T) {
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	var buf bytes.Buffer
+	if err := png.Encode(&buf, createTestImage(1000, 500)); err != nil {
+		t.Fatalf("编码图片失败: %v", err)
+	}
+	// 内容相同的两张图片只处理一次
+	for _, name := range []string{"a.png", "b.png"} {
+		if err := os.WriteFile(filepath.Join(tmpDir, name), buf.Bytes(), 0644); err != nil {
+			t.Fatalf("写入图片失败: %v", err)
+		}
+	}
+
+	optimizer := newImageOptimizer(&config.Config{ImageOptimize: true, ImageDPI: 50})
+	resolver := newImageResolver()
+	var dirs []string
+	for _, markdown := range []string{"![a](a.png)\n", "![b](b.png)\n![a](a.png)\n"} {
+		dir, err := optimizer.prepare(resolver.scan([]byte(markdown), tmpDir))
+		if err != nil || dir == "" {
+			t.Fatalf("准备图片失败: %q %v", dir, err)
+		}
+		dirs = append(dirs, dir)
+	}
+
+	if len(optimizer.entries) != 1 {
+		t.Errorf("期望只处理1张图片, 实际 %d", len(optimizer.entries))
+	}
+	for _, path := range []string{filepath.Join(dirs[0], "a.png"), filepath.Join(dirs[1], "a.png"), filepath.Join(dirs[1], "b.png")} {
+		data, err := os.ReadFile(path)
+		if err != nil {
+			t.Fatalf("读取优化后的图片失败: %v", err)
+		}
+		if cfg, _, err := image.DecodeConfig(bytes.NewReader(data)); err != nil || cfg.Width != 325 {
+			t.Errorf("%s 未被缩小: %+v %v", path, cfg, err)
+		}
+	}
+
+	// 资源路径中优化后的目录排在最前面
+	args := prependResourcePath([]string{"in.md", "--resource-path", tmpDir}, dirs[0], tmpDir)
+	if want := dirs[0] + string(os.PathListSeparator) + tmpDir; args[2] != want {
+		t.Errorf("期望资源路径 %s, 实际 %s", want, args[2])
+	}
+
+	optimizer.close()
+	if _, err := os.Stat(dirs[0]); !os.IsNotExist(err) {
+		t.Error("关闭后应删除临时目录")
+	}
+}
+
+// 辅助函数：创建最小的docx模板
+func createTestTemplate(t *testing.T, path, body string) {
+	var buf bytes.Buffer
+	archive := zip.NewWriter(&buf)
+	w, err := archive.Create("word/document.xml")
+	if err != nil {
+		t.Fatalf("创建模板失败: %v", err)
+	}
+	io.WriteString(w, body)
+	if err := archive.Close(); err != nil {
+		t.Fatalf("创建模板失败: %v", err)
+	}
+	// 先写临时文件再改名，与编辑器保存文件的方式相同
+	if err := os.WriteFile(path+".tmp", buf.Bytes(), 0644); err != nil {
+		t.Fatalf("写入模板失败: %v", err)
+	}
+	if err := os.Rename(path+".tmp", path); err != nil {
+		t.Fatalf("写入模板失败: %v", err)
+	}
+}
+
+func TestLookupTemplate(t *testing.T) {
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	templatePath := filepath.Join(tmpDir, "reference.docx")
+	createTestTemplate(t, templatePath, "v1")
+
+	first, err := config.LookupTemplate(templatePath)
+	if err != nil {
+		t.Fatalf("验证模板失败: %v", err)
+	}
+	// 文件不变时使用注册表中的结果
+	if again, err := config.LookupTemplate(templatePath); err != nil || again != first {
+		t.Errorf("期望复用已验证的模板, 实际 %p %p %v", again, first, err)
+	}
+
+	// 文件变化后重新读取（inotify通知是异步的，稍等片刻）
+	createTestTemplate(t, templatePath, "v2")
+	deadline := time.Now().Add(2 * time.Second)
+	for {
+		current, err := config.LookupTemplate(templatePath)
+		if err != nil {
+			t.Fatalf("验证模板失败: %v", err)
+		}
+		if current.Fingerprint != first.Fingerprint {
+			break
+		}
+		if time.Now().After(deadline) {
+			t.Fatal("模板修改后未重新读取")
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+
+	// 无效的模板
+	invalid := filepath.Join(tmpDir, "invalid.docx")
+	if err := os.WriteFile(invalid, []byte("not a zip"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+	for _, path := range []string{invalid, filepath.Join(tmpDir, "missing.docx"), filepath.Join(tmpDir, "reference.dotx")} {
+		if _, err := config.LookupTemplate(path); err == nil {
+			t.Errorf("期望 %s 验证失败", path)
+		}
+	}
+}
+
+func TestPlanConversion_RequestTemplate(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	templatePath := filepath.Join(tmpDir, "corporate.docx")
+	createTestTemplate(t, templatePath, "corporate")
+	inputFile := filepath.Join(tmpDir, "doc.md")
+	if err := os.WriteFile(inputFile, []byte("# 标题\n"), 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+
+	cfg := &config.Config{PandocPath: createFakePandoc(t, tmpDir)}
+	converter := New(cfg)
+	plan, err := converter.planConversion(cfg, newBatchResources(cfg), inputFile, filepath.Join(tmpDir, "doc.docx"), templatePath)
+	if err != nil {
+		t.Fatalf("规划转换失败: %v", err)
+	}
+	if plan.template == nil || plan.referenceDoc != templatePath {
+		t.Fatalf("请求指定的模板未被使用: %+v", plan)
+	}
+	if !strings.Contains(strings.Join(plan.args, " "), "--reference-doc "+templatePath) {
+		t.Errorf("参数中缺少--reference-doc: %v", plan.args)
+	}
+}
+
+func TestConvertBatch_MultipleTemplates(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	fakePandoc := createFakePandoc(t, tmpDir)
+	acme := filepath.Join(tmpDir, "acme.docx")
+	globex := filepath.Join(tmpDir, "globex.docx")
+	createTestTemplate(t, acme, "acme")
+	createTestTemplate(t, globex, "globex")
+
+	var inputFiles []string
+	for _, name := range []string{"one.md", "two.md"} {
+		path := filepath.Join(tmpDir, name)
+		if err := os.WriteFile(path, []byte("# "+name+"\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		inputFiles = append(inputFiles, path)
+	}
+
+	outputDir := filepath.Join(tmpDir, "out")
+	converter := New(&config.Config{PandocPath: fakePandoc})
+	resp, err := converter.ConvertBatch(&models.BatchConversionRequest{
+		InputFiles: inputFiles,
+		OutputDir:  outputDir,
+		Templates: []models.TemplateOutput{
+			{TemplateFile: acme},
+			{TemplateFile: globex, OutputName: "{name}_external", OutputDir: filepath.Join(outputDir, "external")},
+		},
+	})
+	if err != nil || !resp.Success {
+		t.Fatalf("批量转换失败: %v %+v", err, resp)
+	}
+
+	for i, name := range []string{"one", "two"} {
+		want := []string{
+			filepath.Join(outputDir, name+"-acme.docx"),
+			filepath.Join(outputDir, "external", name+"_external.docx"),
+		}
+		result := resp.Results[i]
+		if result.Status != models.StatusCompleted || strings.Join(result.OutputFiles, ",") != strings.Join(want, ",") {
+			t.Errorf("期望输出 %v, 实际 %+v", want, result)
+		}
+		for _, path := range want {
+			if _, err := os.Stat(path); err != nil {
+				t.Errorf("输出文件未生成: %s", path)
+			}
+		}
+	}
+
+	// 每个文档解析一次（输入为.md），每个模板写出一次（输入为AST）
+	data, err := os.ReadFile(filepath.Join(tmpDir, "order.log"))
+	if err != nil {
+		t.Fatalf("读取调用记录失败: %v", err)
+	}
+	parses, writes := 0, 0
+	for _, line := range strings.Split(strings.TrimSpace(string(data)), "\n") {
+		switch filepath.Ext(line) {
+		case ".md":
+			parses++
+		case ".json":
+			writes++
+		}
+	}
+	if parses != 2 || writes != 4 {
+		t.Errorf("期望解析2次、写出4次, 实际解析%d次、写出%d次", parses, writes)
+	}
+
+	// 输出会相互覆盖的模板整批拒绝
+	resp, err = converter.ConvertBatch(&models.BatchConversionRequest{
+		InputFiles: inputFiles,
+		OutputDir:  outputDir,
+		Templates: []models.TemplateOutput{
+			{TemplateFile: acme, OutputName: "{name}"},
+			{TemplateFile: globex, OutputName: "{name}"},
+		},
+	})
+	if err != nil || resp.Success || !strings.Contains(resp.Error, "输出文件名相同") {
+		t.Errorf("期望拒绝重名的输出, 实际 %+v %v", resp, err)
+	}
+}
+
 func TestUpdateConfig(t *testing.T) {
 	cfg1 := &config.Config{
 		PandocPath: "/usr/bin/pandoc",
@@ -194,11 +1394,64 @@ func TestUpdateConfig(t *testing.T) {
 
 	converter.UpdateConfig(cfg2)
 
-	if converter.config != cfg2 {
+	if converter.config.Load() != cfg2 {
 		t.Error("更新配置失败")
 	}
 }
 
+func TestUpdateConfig_DuringBatch(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := createTestOutputDir(t)
+	defer os.RemoveAll(tmpDir)
+
+	converter := New(&config.Config{PandocPath: createFakePandoc(t, tmpDir), MaxWorkers: 2})
+	var inputFiles []string
+	for _, name := range []string{"slow1.md", "slow2.md", "slow3.md"} {
+		path := filepath.Join(tmpDir, name)
+		if err := os.WriteFile(path, []byte("# 慢文档\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		inputFiles = append(inputFiles, path)
+	}
+
+	done := make(chan *models.ConversionResponse)
+	go func() {
+		resp, _ := converter.ConvertBatch(&models.BatchConversionRequest{
+			InputFiles: inputFiles,
+			OutputDir:  filepath.Join(tmpDir, "out"),
+		})
+		done <- resp
+	}()
+	time.Sleep(200 * time.Millisecond)
+
+	// 批量转换进行中更新配置不应等待整批完成
+	start := time.Now()
+	converter.UpdateConfig(&config.Config{PandocPath: "/nonexistent/pandoc", MaxWorkers: 1})
+	if elapsed := time.Since(start); elapsed > 100*time.Millisecond {
+		t.Errorf("更新配置等待了进行中的批量转换: 耗时 %v", elapsed)
+	}
+
+	// 已开始的批量转换继续使用开始时的配置
+	resp := <-done
+	if resp == nil || !resp.Success {
+		t.Fatalf("批量转换失败: %+v", resp)
+	}
+	for _, result := range resp.Results {
+		if result.Status != models.StatusCompleted {
+			t.Errorf("文件未按原配置完成: %+v", result)
+		}
+	}
+
+	// 之后的请求使用新配置
+	resp, err := converter.ConvertSingle(&models.ConversionRequest{InputFile: inputFiles[0]})
+	if err != nil || resp.Success {
+		t.Errorf("期望使用新配置后转换失败, 实际 %+v, %v", resp, err)
+	}
+}
+
 // 辅助函数：创建测试用的Markdown文件
 func createTestMarkdownFile(t *testing.T, content string) string {
 	tmpFile, err := os.CreateTemp("", "test*.md")
@@ -222,3 +1475,25 @@ func createTestOutputDir(t *testing.T) string {
 	}
 	return tmpDir
 }
+
+// 辅助函数：在目录中创建模拟pandoc的shell脚本
+// 每次执行--version都会在probe.log追加一个字符，每次转换在convert.log追加一个字符；
+// 文件名包含slow的文档会延迟1秒，包含hang的文档会延迟30秒；
+// 从标准输入转换（流式转换）时原样输出读到的内容，内容包含FAIL时失败
+func createFakePandoc(t *testing.T, dir string) string {
+	fakePandoc := filepath.Join(dir, "pandoc")
+	script := "#!/bin/sh\n" +
+		"if [ \"$1\" = \"--version\" ]; then printf x >> \"" + filepath.Join(dir, "probe.log") + "\"; echo 'pandoc 3.0'; exit 0; fi\n" +
+		"if [ \"$1\" = \"--help\" ]; then echo '  --embed-resources'; exit 0; fi\n" +
+		"if [ \"$1\" = \"--list-extensions=markdown\" ]; then echo '+smart'; exit 0; fi\n" +
+		"if [ \"$1\" = \"server\" ]; then echo 'server mode not supported' >&2; exit 1; fi\n" +
+		"if [ \"$1\" = \"-f\" ]; then input=$(cat); case \"$input\" in *FAIL*) echo 'bad input' >&2; exit 1 ;; esac; printf '%s' \"$input\"; exit 0; fi\n" +
+		"case \"$1\" in *slow*) sleep 1 ;; *hang*) sleep 30 ;; esac\n" +
+		"printf x >> \"" + filepath.Join(dir, "convert.log") + "\"\n" +
+		"echo \"$1\" >> \"" + filepath.Join(dir, "order.log") + "\"\n" +
+		"echo docx > \"$3\"\n"
+	if err := os.WriteFile(fakePandoc, []byte(script), 0755); err != nil {
+		t.Fatalf("创建假pandoc失败: %v", err)
+	}
+	return fakePandoc
+}
@@ -0,0 +1,434 @@
+package converter
+
+import (
+	"bytes"
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/hex"
+	"fmt"
+	"hash/crc32"
+	"image"
+	"image/draw"
+	"image/jpeg"
+	"image/png"
+	"log"
+	"math"
+	"os"
+	"path/filepath"
+	"sync"
+
+	"md2docx/internal/config"
+)
+
+// maxOptimizePixels 超过该像素数的图片不处理，避免解码时占用过多内存
+const maxOptimizePixels = 100 * 1000 * 1000
+
+// imageOptimizer 嵌入前缩小并重新压缩文档引用的图片
+// 处理结果按图片内容的哈希缓存，同一批量请求中多个文档引用的同一张图片只处理一次；
+// 处理结果和各文档的图片目录都在临时目录中，批量转换结束时删除
+type imageOptimizer struct {
+	dpi       int
+	quality   int
+	pageWidth float64
+
+	mu      sync.Mutex
+	dir     string                     // 临时目录，首次需要时创建
+	entries map[string]*optimizedImage // 内容哈希 -> 处理结果
+}
+
+// optimizedImage 单张图片的处理结果
+type optimizedImage struct {
+	done chan struct{} // 处理完成后关闭
+	path string        // 处理后的文件，为空表示使用原图
+}
+
+// newImageOptimizer 按配置创建图片优化器，未启用图片优化时返回nil
+func newImageOptimizer(cfg *config.Config) *imageOptimizer {
+	if !cfg.ImageOptimize {
+		return nil
+	}
+	return &imageOptimizer{
+		dpi:       cfg.TargetImageDPI(),
+		quality:   cfg.JPEGQuality(),
+		pageWidth: cfg.PageWidth(),
+		entries:   make(map[string]*optimizedImage),
+	}
+}
+
+// settings 影响处理结果的参数，计入输出缓存键
+func (o *imageOptimizer) settings() string {
+	return fmt.Sprintf("dpi=%d quality=%d width=%g", o.dpi, o.quality, o.pageWidth)
+}
+
+// prepare 为单个文档准备图片目录，其中按引用的相对路径放置处理后的图片
+// 该目录放在资源路径最前面时pandoc优先使用其中的图片，文档本身不需要修改；
+// 没有需要替换的图片时返回空字符串，目录由调用方在转换结束后删除
+func (o *imageOptimizer) prepare(images *imageScan) (string, error) {
+	var docDir string
+	placed := make(map[string]bool)
+	for i, name := range images.names {
+		// 绝对路径的引用无法通过资源路径替换
+		if name == "" || placed[name] || !filepath.IsLocal(name) {
+			continue
+		}
+		optimized := o.optimize(images.images[i])
+		if optimized == "" {
+			continue
+		}
+
+		if docDir == "" {
+			dir, err := o.tempDir()
+			if err != nil {
+				return "", err
+			}
+			if docDir, err = os.MkdirTemp(dir, "doc-"); err != nil {
+				return "", err
+			}
+		}
+		target := filepath.Join(docDir, name)
+		if err := os.MkdirAll(filepath.Dir(target), 0755); err != nil {
+			os.RemoveAll(docDir)
+			return "", err
+		}
+		// 不支持硬链接时复制
+		if err := os.Link(optimized, target); err != nil {
+			if err := copyFile(optimized, target); err != nil {
+				os.RemoveAll(docDir)
+				return "", err
+			}
+		}
+		placed[name] = true
+	}
+	return docDir, nil
+}
+
+// optimize 返回图片处理后的文件，原图已足够小或无法处理时返回空字符串
+func (o *imageOptimizer) optimize(path string) string {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return ""
+	}
+	sum := sha256.Sum256(data)
+	key := hex.EncodeToString(sum[:])
+
+	// 其他文档正在处理同一张图片时等待其结果
+	o.mu.Lock()
+	entry, ok := o.entries[key]
+	if !ok {
+		entry = &optimizedImage{done: make(chan struct{})}
+		o.entries[key] = entry
+	}
+	o.mu.Unlock()
+	if ok {
+		<-entry.done
+		return entry.path
+	}
+	defer close(entry.done)
+
+	output, ok := optimizeImage(data, o.dpi, o.quality, o.pageWidth)
+	if !ok {
+		return ""
+	}
+	dir, err := o.tempDir()
+	if err != nil {
+		log.Printf("创建图片优化目录失败: %v", err)
+		return ""
+	}
+	target := filepath.Join(dir, key)
+	if err := os.WriteFile(target, output, 0644); err != nil {
+		log.Printf("写入优化后的图片失败: %v", err)
+		return ""
+	}
+	entry.path = target
+	return target
+}
+
+// tempDir 返回存放处理结果的临时目录，首次调用时创建
+func (o *imageOptimizer) tempDir() (string, error) {
+	o.mu.Lock()
+	defer o.mu.Unlock()
+	if o.dir == "" {
+		dir, err := os.MkdirTemp("", "md2docx-images-")
+		if err != nil {
+			return "", err
+		}
+		o.dir = dir
+	}
+	return o.dir, nil
+}
+
+// close 删除所有处理结果
+func (o *imageOptimizer) close() {
+	o.mu.Lock()
+	defer o.mu.Unlock()
+	if o.dir != "" {
+		os.RemoveAll(o.dir)
+		o.dir = ""
+	}
+	o.entries = make(map[string]*optimizedImage)
+}
+
+// optimizeImage 缩小并重新压缩PNG或JPEG图片
+// 宽度超过显示宽度乘以目标分辨率的图片按比例缩小，并写入新的分辨率，
+// 使pandoc计算出的显示尺寸保持不变；结果没有变小时返回false，继续使用原图
+func optimizeImage(data []byte, dpi, quality int, pageWidth float64) ([]byte, bool) {
+	cfg, format, err := image.DecodeConfig(bytes.NewReader(data))
+	if err != nil || cfg.Width <= 0 || cfg.Height <= 0 || cfg.Width*cfg.Height > maxOptimizePixels {
+		return nil, false
+	}
+
+	var sourceDPI float64
+	switch format {
+	case "png":
+		sourceDPI = pngDPI(data)
+	case "jpeg":
+		// 重新编码会丢失EXIF，带旋转标记的照片会以错误的方向显示
+		if jpegOrientation(data) > 1 {
+			return nil, false
+		}
+		sourceDPI = jpegDPI(data)
+	default:
+		return nil, false
+	}
+
+	// 没有分辨率信息时pandoc按96 DPI计算图片尺寸，超出页面宽度的图片缩小到页面宽度显示
+	assumedDPI := sourceDPI
+	if assumedDPI <= 0 {
+		assumedDPI = 96
+	}
+	displayWidth := min(float64(cfg.Width)/assumedDPI, pageWidth)
+	maxWidth := max(1, int(math.Ceil(displayWidth*float64(dpi))))
+
+	img, _, err := image.Decode(bytes.NewReader(data))
+	if err != nil {
+		return nil, false
+	}
+	// CMYK的JPEG重新编码时颜色不可靠
+	if _, cmyk := img.(*image.CMYK); cmyk {
+		return nil, false
+	}
+
+	outputDPI := sourceDPI
+	scaled := cfg.Width > maxWidth
+	if scaled {
+		height := max(1, int(math.Round(float64(cfg.Height)*float64(maxWidth)/float64(cfg.Width))))
+		img = downscale(img, maxWidth, height)
+		outputDPI = float64(maxWidth) / displayWidth
+	}
+
+	var buf bytes.Buffer
+	var output []byte
+	if format == "png" {
+		encoder := png.Encoder{CompressionLevel: png.BestCompression}
+		if err := encoder.Encode(&buf, img); err != nil {
+			return nil, false
+		}
+		output = setPNGDPI(buf.Bytes(), outputDPI)
+	} else {
+		if err := jpeg.Encode(&buf, img, &jpeg.Options{Quality: quality}); err != nil {
+			return nil, false
+		}
+		output = setJPEGDPI(buf.Bytes(), outputDPI)
+	}
+
+	if !scaled && len(output) >= len(data) {
+		return nil, false
+	}
+	return output, true
+}
+
+// downscale 按区域平均把图片缩小到指定尺寸
+// 在预乘alpha的RGBA上求平均，透明像素的颜色不会渗入边缘
+func downscale(src image.Image, width, height int) *image.RGBA {
+	bounds := src.Bounds()
+	rgba, ok := src.(*image.RGBA)
+	if !ok {
+		rgba = image.NewRGBA(image.Rect(0, 0, bounds.Dx(), bounds.Dy()))
+		draw.Draw(rgba, rgba.Bounds(), src, bounds.Min, draw.Src)
+	}
+	origin := rgba.Rect.Min
+	srcWidth, srcHeight := rgba.Rect.Dx(), rgba.Rect.Dy()
+
+	dst := image.NewRGBA(image.Rect(0, 0, width, height))
+	// 目标像素x覆盖源图的[xs[x], xs[x+1])列，缩小时每个区间至少包含一列
+	xs := make([]int, width+1)
+	for x := range xs {
+		xs[x] = x * srcWidth / width
+	}
+	sums := make([]uint64, width*4)
+
+	for y := 0; y < height; y++ {
+		y0, y1 := y*srcHeight/height, (y+1)*srcHeight/height
+		for i := range sums {
+			sums[i] = 0
+		}
+		for sy := y0; sy < y1; sy++ {
+			row := rgba.Pix[rgba.PixOffset(origin.X, origin.Y+sy):]
+			for x := 0; x < width; x++ {
+				sum := sums[x*4 : x*4+4]
+				for sx := xs[x]; sx < xs[x+1]; sx++ {
+					pixel := row[sx*4 : sx*4+4]
+					sum[0] += uint64(pixel[0])
+					sum[1] += uint64(pixel[1])
+					sum[2] += uint64(pixel[2])
+					sum[3] += uint64(pixel[3])
+				}
+			}
+		}
+
+		out := dst.Pix[y*dst.Stride:]
+		for x := 0; x < width; x++ {
+			count := uint64((xs[x+1] - xs[x]) * (y1 - y0))
+			for c := 0; c < 4; c++ {
+				out[x*4+c] = uint8((sums[x*4+c] + count/2) / count)
+			}
+		}
+	}
+	return dst
+}
+
+// pngDPI 读取PNG的pHYs块中的分辨率，没有或单位不是米时返回0
+func pngDPI(data []byte) float64 {
+	pos := 8
+	for pos+8 <= len(data) {
+		length := int(binary.BigEndian.Uint32(data[pos:]))
+		body := pos + 8
+		if length < 0 || body+length+4 > len(data) {
+			return 0
+		}
+		switch string(data[pos+4 : body]) {
+		case "pHYs":
+			if length >= 9 && data[body+8] == 1 {
+				return float64(binary.BigEndian.Uint32(data[body:])) * 0.0254
+			}
+			return 0
+		case "IDAT":
+			return 0
+		}
+		pos = body + length + 4
+	}
+	return 0
+}
+
+// setPNGDPI 在IHDR块之后插入pHYs块，dpi不大于0时原样返回
+// 用于image/png编码的结果，其中IHDR总是第一个块且没有pHYs块
+func setPNGDPI(data []byte, dpi float64) []byte {
+	const ihdrEnd = 8 + 8 + 13 + 4
+	if dpi <= 0 || len(data) < ihdrEnd {
+		return data
+	}
+
+	pixelsPerMeter := uint32(math.Round(dpi / 0.0254))
+	chunk := make([]byte, 8+9+4)
+	binary.BigEndian.PutUint32(chunk[0:], 9)
+	copy(chunk[4:], "pHYs")
+	binary.BigEndian.PutUint32(chunk[8:], pixelsPerMeter)
+	binary.BigEndian.PutUint32(chunk[12:], pixelsPerMeter)
+	chunk[16] = 1 // 单位：米
+	binary.BigEndian.PutUint32(chunk[17:], crc32.ChecksumIEEE(chunk[4:17]))
+
+	output := make([]byte, 0, len(data)+len(chunk))
+	output = append(output, data[:ihdrEnd]...)
+	output = append(output, chunk...)
+	return append(output, data[ihdrEnd:]...)
+}
+
+// jpegSegments 依次遍历JPEG图像数据之前的标记段，fn返回false时停止
+func jpegSegments(data []byte, fn func(marker byte, body []byte) bool) {
+	if len(data) < 4 || data[0] != 0xFF || data[1] != 0xD8 {
+		return
+	}
+	pos := 2
+	for pos+4 <= len(data) && data[pos] == 0xFF {
+		marker := data[pos+1]
+		if marker == 0xDA || marker == 0xD9 { // SOS、EOI
+			return
+		}
+		length := int(binary.BigEndian.Uint16(data[pos+2:]))
+		if length < 2 || pos+2+length > len(data) {
+			return
+		}
+		if !fn(marker, data[pos+4:pos+2+length]) {
+			return
+		}
+		pos += 2 + length
+	}
+}
+
+// jpegDPI 读取JFIF段中的分辨率，没有或只有像素宽高比时返回0
+func jpegDPI(data []byte) float64 {
+	var dpi float64
+	jpegSegments(data, func(marker byte, body []byte) bool {
+		if marker != 0xE0 || len(body) < 12 || !bytes.HasPrefix(body, []byte("JFIF\x00")) {
+			return true
+		}
+		density := float64(binary.BigEndian.Uint16(body[8:]))
+		switch body[7] {
+		case 1:
+			dpi = density
+		case 2:
+			dpi = density * 2.54
+		}
+		return false
+	})
+	return dpi
+}
+
+// jpegOrientation 读取EXIF中的方向标记，没有时返回0
+func jpegOrientation(data []byte) int {
+	orientation := 0
+	jpegSegments(data, func(marker byte, body []byte) bool {
+		if marker != 0xE1 || !bytes.HasPrefix(body, []byte("Exif\x00\x00")) {
+			return true
+		}
+		tiff := body[6:]
+		if len(tiff) < 8 {
+			return false
+		}
+		var order binary.ByteOrder
+		switch string(tiff[:2]) {
+		case "II":
+			order = binary.LittleEndian
+		case "MM":
+			order = binary.BigEndian
+		default:
+			return false
+		}
+
+		ifd := int(order.Uint32(tiff[4:]))
+		if ifd < 0 || ifd+2 > len(tiff) {
+			return false
+		}
+		count := int(order.Uint16(tiff[ifd:]))
+		for i := 0; i < count; i++ {
+			entry := ifd + 2 + i*12
+			if entry+12 > len(tiff) {
+				break
+			}
+			if order.Uint16(tiff[entry:]) == 0x0112 {
+				orientation = int(order.Uint16(tiff[entry+8:]))
+				break
+			}
+		}
+		return false
+	})
+	return orientation
+}
+
+// setJPEGDPI 在SOI之后插入JFIF段，dpi不大于0时原样返回
+// 用于image/jpeg编码的结果，其中没有JFIF段
+func setJPEGDPI(data []byte, dpi float64) []byte {
+	if dpi <= 0 || len(data) < 2 {
+		return data
+	}
+
+	density := uint16(min(math.Round(dpi), math.MaxUint16))
+	segment := []byte{0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 1, 0, 0, 0, 0, 0, 0}
+	binary.BigEndian.PutUint16(segment[12:], density)
+	binary.BigEndian.PutUint16(segment[14:], density)
+
+	output := make([]byte, 0, len(data)+len(segment))
+	output = append(output, data[:2]...)
+	output = append(output, segment...)
+	return append(output, data[2:]...)
+}
@@ -0,0 +1,346 @@
+package converter
+
+import (
+	"bytes"
+	"log"
+	"net/url"
+	"os"
+	"path/filepath"
+	"regexp"
+	"strings"
+	"sync"
+)
+
+var (
+	// ![alt](path "title")
+	inlineImagePattern = regexp.MustCompile(`!\[[^\]]*\]\(\s*<?([^)\s>]+)>?(?:\s+["'(][^)]*)?\)`)
+	// <img src="path">
+	htmlImagePattern = regexp.MustCompile(`(?i)<img\s[^>]*?src\s*=\s*["']([^"']+)["']`)
+	// ![alt][label]、![label][] 和 ![label]
+	referenceImagePattern = regexp.MustCompile(`!\[([^\]]*)\](?:\[([^\]]*)\])?`)
+	// [label]: path "title"
+	linkDefinitionPattern = regexp.MustCompile(`(?m)^ {0,3}\[([^\]]+)\]:[ \t]*<?([^\s>]+)>?`)
+	// 围栏代码块的起止行
+	codeFencePattern = regexp.MustCompile("^ {0,3}(```+|~~~+)")
+	// 行内代码
+	codeSpanPattern = regexp.MustCompile("`+[^`\n]*`+")
+	// HTML注释，可以跨行
+	htmlCommentPattern = regexp.MustCompile(`(?s)<!--.*?-->`)
+	// 列表项的起始行，其后缩进的行是列表内容而不是缩进代码块
+	listItemPattern = regexp.MustCompile(`^ {0,3}(?:[-+*]|\d{1,9}[.)])(?:[ \t]|$)`)
+	// URL协议，如 http:、mailto:（单个字母是Windows盘符）
+	uriSchemePattern = regexp.MustCompile(`^[a-zA-Z][a-zA-Z0-9+.-]+:`)
+)
+
+// conventionalImageDirs 输入目录下常用的图片子目录，引用只写文件名时也在其中查找
+var conventionalImageDirs = []string{"images", "figures", "pics", "assets"}
+
+// imageReferences 提取Markdown中引用的本地图片路径（去重，保持出现顺序）
+// 支持行内图片、引用式图片和HTML的img标签，代码块、行内代码、HTML注释
+// 和转义的感叹号（\![x](y)）中的内容不计入
+func imageReferences(markdown []byte) []string {
+	prose := stripNonProse(markdown)
+
+	var refs []string
+	seen := make(map[string]bool)
+	add := func(ref string) {
+		if seen[ref] || isRemoteReference(ref) {
+			return
+		}
+		seen[ref] = true
+		refs = append(refs, ref)
+	}
+
+	for _, pattern := range []*regexp.Regexp{inlineImagePattern, htmlImagePattern} {
+		for _, match := range pattern.FindAllSubmatch(prose, -1) {
+			add(string(match[1]))
+		}
+	}
+
+	// 引用式图片：先收集链接定义，再按图片使用的标签查找
+	definitions := make(map[string]string)
+	for _, match := range linkDefinitionPattern.FindAllSubmatch(prose, -1) {
+		label := normalizeLabel(string(match[1]))
+		if _, ok := definitions[label]; !ok {
+			definitions[label] = string(match[2])
+		}
+	}
+	if len(definitions) > 0 {
+		for _, match := range referenceImagePattern.FindAllSubmatchIndex(prose, -1) {
+			// 紧跟括号的是行内图片，已在上面处理
+			if end := match[1]; end < len(prose) && prose[end] == '(' && match[4] < 0 {
+				continue
+			}
+			label := string(prose[match[2]:match[3]])
+			if match[4] >= 0 && match[5] > match[4] {
+				label = string(prose[match[4]:match[5]])
+			}
+			if ref, ok := definitions[normalizeLabel(label)]; ok {
+				add(ref)
+			}
+		}
+	}
+
+	return refs
+}
+
+// normalizeLabel 链接标签不区分大小写，连续空白视为一个空格
+func normalizeLabel(label string) string {
+	return strings.ToLower(strings.Join(strings.Fields(label), " "))
+}
+
+// stripNonProse 去掉其中的图片语法不是真正图片的部分：
+// 围栏代码块、缩进代码块、行内代码、HTML注释和反斜杠转义
+func stripNonProse(markdown []byte) []byte {
+	out := make([]byte, 0, len(markdown))
+	var fence []byte
+	inList := false   // 位于列表项中，缩进的行属于列表内容
+	blank := true     // 上一行是空行（文档开头视为空行）
+	inIndent := false // 位于缩进代码块中
+	for _, line := range bytes.SplitAfter(markdown, []byte("\n")) {
+		if match := codeFencePattern.FindSubmatch(line); match != nil && !inIndent {
+			marker := match[1]
+			if fence == nil {
+				fence = marker
+				out = append(out, '\n')
+				continue
+			}
+			if marker[0] == fence[0] && len(marker) >= len(fence) {
+				fence = nil
+				out = append(out, '\n')
+				continue
+			}
+		}
+		if fence != nil {
+			out = append(out, '\n')
+			continue
+		}
+
+		trimmed := bytes.TrimSpace(line)
+		switch {
+		case len(trimmed) == 0:
+			blank = true
+			out = append(out, '\n')
+			continue
+		case isIndentedCode(line) && !inList && (blank || inIndent):
+			// 缩进代码块只能从空行之后开始，之后连续缩进的行（可夹空行）都属于代码块
+			inIndent = true
+			blank = false
+			out = append(out, '\n')
+			continue
+		}
+		inIndent = false
+		blank = false
+		if listItemPattern.Match(line) {
+			inList = true
+		} else if !isIndentedCode(line) && len(line)-len(bytes.TrimLeft(line, " \t")) == 0 {
+			// 顶格的普通段落结束列表
+			inList = false
+		}
+		out = append(out, codeSpanPattern.ReplaceAll(line, nil)...)
+	}
+
+	out = htmlCommentPattern.ReplaceAllFunc(out, func(comment []byte) []byte {
+		// 保留换行，行结构不变
+		return bytes.Repeat([]byte("\n"), bytes.Count(comment, []byte("\n")))
+	})
+	return stripEscapes(out)
+}
+
+// isIndentedCode 判断行是否缩进到代码块的深度（4个空格或制表符）
+func isIndentedCode(line []byte) bool {
+	return bytes.HasPrefix(line, []byte("    ")) || bytes.HasPrefix(line, []byte("\t"))
+}
+
+// stripEscapes 处理反斜杠转义：转义的感叹号、反斜杠替换为空格，不再与后面的内容构成图片语法；
+// 其他转义的标点去掉反斜杠，与pandoc解析链接地址的方式一致
+func stripEscapes(markdown []byte) []byte {
+	if !bytes.Contains(markdown, []byte("\\")) {
+		return markdown
+	}
+	out := make([]byte, 0, len(markdown))
+	for i := 0; i < len(markdown); i++ {
+		c := markdown[i]
+		if c != '\\' || i+1 >= len(markdown) || !isASCIIPunct(markdown[i+1]) {
+			out = append(out, c)
+			continue
+		}
+		i++
+		switch markdown[i] {
+		case '!', '\\':
+			out = append(out, ' ')
+		default:
+			out = append(out, markdown[i])
+		}
+	}
+	return out
+}
+
+// isASCIIPunct 判断是否为可以用反斜杠转义的ASCII标点
+func isASCIIPunct(c byte) bool {
+	return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~')
+}
+
+// isRemoteReference 判断是否为远程或内联资源
+func isRemoteReference(ref string) bool {
+	return strings.HasPrefix(ref, "//") || uriSchemePattern.MatchString(ref)
+}
+
+// imageScan 转换前扫描文档引用的图片的结果
+type imageScan struct {
+	images        []string // 找到的图片路径，按引用顺序
+	refs          []string // 与images一一对应的原始引用
+	names         []string // 与images一一对应，相对于找到它的资源目录的路径，绝对路径的引用为空
+	missing       []string // 找不到的引用
+	resourcePaths []string // pandoc查找这些图片所需的最少资源路径
+}
+
+// warnMissing 记录找不到的图片
+// 扫描只是近似的Markdown解析，找不到的引用仍交给pandoc处理（pandoc会以图片说明代替）
+func (s *imageScan) warnMissing(inputFile string) {
+	if len(s.missing) > 0 {
+		log.Printf("%s: 找不到引用的图片: %s", inputFile, strings.Join(s.missing, ", "))
+	}
+}
+
+// imageResolver 按目录缓存文件列表，解析图片引用时不必逐个stat
+// 同一批量请求中的文档共用一个解析器，每个目录只读取一次
+type imageResolver struct {
+	mu       sync.Mutex
+	listings map[string]*dirListing // 目录 -> 文件列表，目录不可读时为nil
+}
+
+// dirListing 单个目录的内容
+type dirListing struct {
+	files map[string]bool
+	dirs  map[string]bool
+}
+
+func newImageResolver() *imageResolver {
+	return &imageResolver{listings: make(map[string]*dirListing)}
+}
+
+// scan 解析文档引用的所有本地图片
+// 相对路径先在输入目录中查找，再在输入目录下的常用图片子目录中查找
+func (r *imageResolver) scan(markdown []byte, inputDir string) *imageScan {
+	result := &imageScan{}
+	refs := imageReferences(markdown)
+	if len(refs) == 0 {
+		return result
+	}
+
+	searchDirs := []string{inputDir}
+	for _, name := range conventionalImageDirs {
+		if r.hasDir(inputDir, name) {
+			searchDirs = append(searchDirs, filepath.Join(inputDir, name))
+		}
+	}
+
+	used := make(map[string]bool)
+	for _, ref := range refs {
+		path, dir, ok := r.resolve(ref, searchDirs)
+		if !ok {
+			result.missing = append(result.missing, ref)
+			continue
+		}
+		var name string
+		if dir != "" {
+			used[dir] = true
+			name, _ = filepath.Rel(dir, path)
+		}
+		result.images = append(result.images, path)
+		result.refs = append(result.refs, ref)
+		result.names = append(result.names, name)
+	}
+
+	// pandoc按资源路径的顺序查找，保持与searchDirs相同的顺序才能找到同一个文件；
+	// 输入目录总是保留，扫描未识别的引用写法仍能按原来的方式找到；
+	// 只用到输入目录且它就是工作目录时，pandoc的默认资源路径已经足够
+	if len(used) == 0 || (len(used) == 1 && used[inputDir] && inputDir == ".") {
+		return result
+	}
+	for i, dir := range searchDirs {
+		if i == 0 || used[dir] {
+			result.resourcePaths = append(result.resourcePaths, dir)
+		}
+	}
+	return result
+}
+
+// resolve 查找图片，返回其路径和找到它的资源目录（绝对路径的图片不需要资源目录）
+func (r *imageResolver) resolve(ref string, searchDirs []string) (string, string, bool) {
+	candidates := []string{ref}
+	// pandoc会对引用做URL解码
+	if decoded, err := url.PathUnescape(ref); err == nil && decoded != ref {
+		candidates = append(candidates, decoded)
+	}
+
+	for _, candidate := range candidates {
+		candidate = filepath.FromSlash(candidate)
+		if filepath.IsAbs(candidate) {
+			if r.exists(candidate) {
+				return candidate, "", true
+			}
+			continue
+		}
+		for _, dir := range searchDirs {
+			if path := filepath.Join(dir, candidate); r.exists(path) {
+				return path, dir, true
+			}
+		}
+	}
+	return "", "", false
+}
+
+// exists 按所在目录的文件列表判断文件是否存在
+func (r *imageResolver) exists(path string) bool {
+	dir, name := filepath.Split(path)
+
+	r.mu.Lock()
+	listing := r.listingLocked(filepath.Clean(dir))
+	found := listing != nil && listing.files[name]
+	r.mu.Unlock()
+	if found || listing == nil {
+		return found
+	}
+
+	// 不区分大小写的文件系统上，文件名大小写不同也能找到，只有这种情况才单独stat
+	info, err := os.Stat(path)
+	if err != nil || info.IsDir() {
+		return false
+	}
+	r.mu.Lock()
+	listing.files[name] = true
+	r.mu.Unlock()
+	return true
+}
+
+// hasDir 判断parent下是否有名为name的子目录
+func (r *imageResolver) hasDir(parent, name string) bool {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	listing := r.listingLocked(parent)
+	return listing != nil && listing.dirs[name]
+}
+
+// listingLocked 返回目录内容，首次访问时读取，调用方需持有r.mu
+func (r *imageResolver) listingLocked(dir string) *dirListing {
+	if listing, ok := r.listings[dir]; ok {
+		return listing
+	}
+
+	var listing *dirListing
+	if entries, err := os.ReadDir(dir); err == nil {
+		listing = &dirListing{files: make(map[string]bool), dirs: make(map[string]bool)}
+		for _, entry := range entries {
+			if entry.IsDir() {
+				listing.dirs[entry.Name()] = true
+			} else {
+				// 符号链接也按文件处理，指向的目标不存在时pandoc同样会报错
+				listing.files[entry.Name()] = true
+			}
+		}
+	}
+	r.listings[dir] = listing
+	return listing
+}
@@ -0,0 +1,96 @@
+package converter
+
+import (
+	"encoding/json"
+	"os"
+	"path/filepath"
+
+	"md2docx/internal/config"
+	"md2docx/pkg/utils"
+)
+
+// dependencyManifest 输出文件的依赖清单，与输出文件放在同一目录
+// 增量转换时据此判断输出是否比所有依赖都新
+type dependencyManifest struct {
+	Input         string   `json:"input"`
+	Template      string   `json:"template,omitempty"`
+	Images        []string `json:"images,omitempty"`
+	Missing       []string `json:"missing,omitempty"` // 转换时找不到的图片引用，之后可能出现，每次都重新转换
+	PandocVersion string   `json:"pandoc_version"`
+}
+
+// manifestPath 返回输出文件对应的依赖清单路径（隐藏文件）
+func manifestPath(outputFile string) string {
+	return filepath.Join(filepath.Dir(outputFile), "."+filepath.Base(outputFile)+".deps.json")
+}
+
+// writeManifest 记录本次转换实际使用的依赖
+func writeManifest(plan *conversionPlan) error {
+	manifest := dependencyManifest{
+		Input:         plan.inputFile,
+		Template:      plan.referenceDoc,
+		Images:        plan.images.images,
+		Missing:       plan.images.missing,
+		PandocVersion: plan.pandoc.Version,
+	}
+
+	data, err := json.MarshalIndent(manifest, "", "  ")
+	if err != nil {
+		return err
+	}
+	return utils.WriteFileAtomic(manifestPath(plan.outputFile), data)
+}
+
+// isUpToDate 判断输出文件是否比输入、模板和引用的图片都新
+// 在规划转换之前调用：只读取依赖清单并stat其中的文件，不读取和扫描Markdown；
+// 没有依赖清单、清单与本次参数不一致或任一依赖缺失时都视为需要重新转换
+func isUpToDate(cfg *config.Config, inputFile, outputFile, templateFile string) bool {
+	outputInfo, err := os.Stat(outputFile)
+	if err != nil {
+		return false
+	}
+
+	data, err := os.ReadFile(manifestPath(outputFile))
+	if err != nil {
+		return false
+	}
+	var manifest dependencyManifest
+	if err := json.Unmarshal(data, &manifest); err != nil {
+		return false
+	}
+
+	// 与planConversion相同的方式确定Pandoc和参考模板（均为缓存的结果）
+	pandoc, err := cfg.Pandoc()
+	if err != nil {
+		return false
+	}
+	if templateFile == "" {
+		templateFile = cfg.TemplateFile
+	}
+	referenceDoc := ""
+	if templateFile != "" {
+		if _, err := config.LookupTemplate(templateFile); err == nil {
+			referenceDoc = templateFile
+		}
+	}
+
+	if len(manifest.Missing) > 0 ||
+		manifest.Input != inputFile ||
+		manifest.Template != referenceDoc ||
+		manifest.PandocVersion != pandoc.Version {
+		return false
+	}
+
+	dependencies := append([]string{inputFile}, manifest.Images...)
+	if referenceDoc != "" {
+		dependencies = append(dependencies, referenceDoc)
+	}
+	for _, path := range dependencies {
+		info, err := os.Stat(path)
+		if err != nil || info.ModTime().After(outputInfo.ModTime()) {
+			return false
+		}
+	}
+
+	return true
+}
@@ -0,0 +1,225 @@
+package converter
+
+import (
+	"context"
+	"crypto/sha256"
+	"encoding/hex"
+	"fmt"
+	"log"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+	"sync"
+
+	"md2docx/internal/config"
+	"md2docx/internal/models"
+	"md2docx/pkg/utils"
+)
+
+// documentAST 文档解析得到的pandoc JSON AST
+type documentAST struct {
+	once sync.Once
+	path string
+	err  error
+}
+
+// astCache 批量转换中已解析文档的AST，按内容缓存，内容相同的文档只解析一次
+// AST保存在临时目录中而不是内存里，批量结束时删除
+type astCache struct {
+	mu      sync.Mutex
+	dir     string
+	entries map[string]*documentAST
+}
+
+func newASTCache() *astCache {
+	return &astCache{entries: make(map[string]*documentAST)}
+}
+
+// get 返回计划对应文档的AST文件，首次请求时执行pandoc解析
+func (a *astCache) get(ctx context.Context, plan *conversionPlan) (string, error) {
+	h := sha256.New()
+	fmt.Fprintf(h, "%s\x00%s\x00", plan.pandoc.Path, plan.pandoc.Version)
+	h.Write(plan.markdown)
+	key := hex.EncodeToString(h.Sum(nil))
+
+	a.mu.Lock()
+	entry, ok := a.entries[key]
+	if !ok {
+		entry = &documentAST{}
+		a.entries[key] = entry
+	}
+	a.mu.Unlock()
+
+	entry.once.Do(func() {
+		entry.path, entry.err = a.parse(ctx, plan, key)
+	})
+	return entry.path, entry.err
+}
+
+// parse 用pandoc把Markdown解析为JSON AST
+// 图片在写出docx时才按资源路径读取，解析时不需要资源路径
+func (a *astCache) parse(ctx context.Context, plan *conversionPlan, key string) (string, error) {
+	a.mu.Lock()
+	if a.dir == "" {
+		dir, err := os.MkdirTemp("", "md2docx-ast-")
+		if err != nil {
+			a.mu.Unlock()
+			return "", fmt.Errorf("创建临时目录失败: %v", err)
+		}
+		a.dir = dir
+	}
+	path := filepath.Join(a.dir, key+".json")
+	a.mu.Unlock()
+
+	cmd := exec.CommandContext(ctx, plan.pandoc.Path, plan.inputFile, "-o", path, "-f", "markdown", "-t", "json")
+	cmd.WaitDelay = pandocWaitDelay
+	output, err := cmd.CombinedOutput()
+	if ctx.Err() != nil {
+		return "", ctx.Err()
+	}
+	if err != nil {
+		return "", fmt.Errorf("Pandoc解析失败: %v, 输出: %s", err, string(output))
+	}
+	return path, nil
+}
+
+// close 删除所有AST文件
+func (a *astCache) close() {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	if a.dir != "" {
+		os.RemoveAll(a.dir)
+		a.dir = ""
+	}
+	a.entries = make(map[string]*documentAST)
+}
+
+// astArgs 把pandoc参数改为从AST文件读取
+// args的前五项是：输入文件、-o、输出文件、-f、markdown
+// 输入不再是原文件，没有指定资源路径时补上输入目录，相对路径的图片才能找到
+func astArgs(args []string, astFile, inputDir string) []string {
+	args[0] = astFile
+	args[4] = "json"
+	for _, arg := range args {
+		if arg == "--resource-path" {
+			return args
+		}
+	}
+	return append(args, "--resource-path", inputDir)
+}
+
+// validateTemplateOutputs 检查多模板请求：模板必须有效，各模板的输出不能相互覆盖
+func validateTemplateOutputs(req *models.BatchConversionRequest) error {
+	outputs := make(map[string]int)
+	for i, output := range req.Templates {
+		if output.TemplateFile != "" {
+			if _, err := config.LookupTemplate(output.TemplateFile); err != nil {
+				return err
+			}
+		}
+		name := templateOutputName(output)
+		if strings.ContainsAny(name, `/\`) || !strings.Contains(name, models.TemplateNamePlaceholder) {
+			return fmt.Errorf("模板输出文件名必须包含%s且不能包含路径: %s", models.TemplateNamePlaceholder, name)
+		}
+		key := filepath.Join(templateOutputDir(req, output), strings.ToLower(name))
+		if previous, ok := outputs[key]; ok {
+			return fmt.Errorf("第%d个和第%d个模板的输出文件名相同: %s", previous+1, i+1, name)
+		}
+		outputs[key] = i
+	}
+	return nil
+}
+
+// templateOutputName 模板的输出文件名规则，未指定时在输入文件名后加上模板文件名
+func templateOutputName(output models.TemplateOutput) string {
+	if output.OutputName != "" {
+		return output.OutputName
+	}
+	if output.TemplateFile == "" {
+		return models.TemplateNamePlaceholder
+	}
+	base := filepath.Base(output.TemplateFile)
+	return models.TemplateNamePlaceholder + "-" + strings.TrimSuffix(base, filepath.Ext(base))
+}
+
+// templateOutputDir 模板的输出目录
+func templateOutputDir(req *models.BatchConversionRequest, output models.TemplateOutput) string {
+	if output.OutputDir != "" {
+		return output.OutputDir
+	}
+	return req.OutputDir
+}
+
+// convertBatchItemTemplates 用请求中的每个模板转换单个文件
+// 文档只由pandoc解析一次，之后每个模板只执行一次docx写出；
+// 输出缓存命中或增量转换中已是最新的模板不需要解析结果，全部命中时不执行解析
+func (c *Converter) convertBatchItemTemplates(ctx context.Context, cfg *config.Config, shared *batchResources, inputFile string, req *models.BatchConversionRequest) models.ConversionResult {
+	result := models.ConversionResult{
+		InputFile: inputFile,
+		Success:   false,
+		Status:    models.StatusFailed,
+	}
+
+	if err := utils.ValidateInputFile(inputFile); err != nil {
+		result.Error = err.Error()
+		return result
+	}
+
+	baseName := strings.TrimSuffix(filepath.Base(inputFile), filepath.Ext(inputFile))
+	var failures []string
+	completed, skipped := 0, 0
+	for _, output := range req.Templates {
+		outputName := strings.ReplaceAll(templateOutputName(output), models.TemplateNamePlaceholder, baseName)
+		outputPath, err := utils.DetermineOutputPath(inputFile, templateOutputDir(req, output), outputName)
+		if err == nil {
+			err = utils.ValidateOutputDir(filepath.Dir(outputPath))
+		}
+		if err == nil && req.Incremental && isUpToDate(cfg, inputFile, outputPath, output.TemplateFile) {
+			skipped++
+			result.OutputFiles = append(result.OutputFiles, outputPath)
+			continue
+		}
+
+		var plan *conversionPlan
+		if err == nil {
+			plan, err = c.planConversion(cfg, shared, inputFile, outputPath, output.TemplateFile)
+		}
+		if err != nil {
+			// 规划失败（如无法读取输入）时其余模板同样会失败，不再尝试
+			result.Error = fmt.Sprintf("转换失败: %v", err)
+			return result
+		}
+		plan.ast = shared.asts
+
+		if err := c.executePlan(ctx, plan); err != nil {
+			if ctx.Err() != nil {
+				return interruptedResult(ctx, inputFile)
+			}
+			failures = append(failures, fmt.Sprintf("%s: %v", filepath.Base(outputPath), err))
+			continue
+		}
+		if req.Incremental {
+			if err := writeManifest(plan); err != nil {
+				log.Printf("写入依赖清单失败: %v", err)
+			}
+		}
+		completed++
+		result.OutputFiles = append(result.OutputFiles, outputPath)
+	}
+
+	if len(result.OutputFiles) > 0 {
+		result.OutputFile = result.OutputFiles[0]
+	}
+	switch {
+	case len(failures) > 0:
+		result.Error = "转换失败: " + strings.Join(failures, "; ")
+	case completed == 0 && skipped > 0:
+		result.Success = true
+		result.Status = models.StatusSkipped
+	default:
+		result.Success = true
+		result.Status = models.StatusCompleted
+	}
+	return result
+}
@@ -0,0 +1,260 @@
+package converter
+
+import (
+	"container/list"
+	"crypto/sha256"
+	"encoding/hex"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+)
+
+const defaultOutputCacheMaxMB = 1024 // 输出缓存默认大小上限（MB）
+
+// CacheStats 输出缓存统计信息
+type CacheStats struct {
+	Hits      int64 `json:"hits"`
+	Misses    int64 `json:"misses"`
+	Evictions int64 `json:"evictions"`
+	Entries   int   `json:"entries"`
+	SizeBytes int64 `json:"size_bytes"`
+}
+
+// outputCache 按内容寻址的docx输出缓存
+// 键由输入内容计算得出，命中时直接复制缓存的docx，不再执行pandoc；
+// 总大小超过上限时按最近最少使用顺序淘汰
+type outputCache struct {
+	dir      string
+	maxBytes int64
+
+	mu      sync.Mutex
+	entries map[string]*list.Element // 键 -> lru中的元素
+	lru     *list.List               // 队首为最近使用
+	stats   CacheStats
+}
+
+// outputCacheEntry 缓存条目
+type outputCacheEntry struct {
+	key  string
+	size int64
+}
+
+// newOutputCache 打开缓存目录，并按文件修改时间恢复LRU顺序
+func newOutputCache(dir string, maxMB int) (*outputCache, error) {
+	if maxMB <= 0 {
+		maxMB = defaultOutputCacheMaxMB
+	}
+	if err := os.MkdirAll(dir, 0755); err != nil {
+		return nil, fmt.Errorf("无法创建缓存目录: %v", err)
+	}
+
+	oc := &outputCache{
+		dir:      dir,
+		maxBytes: int64(maxMB) * 1024 * 1024,
+		entries:  make(map[string]*list.Element),
+		lru:      list.New(),
+	}
+
+	dirEntries, err := os.ReadDir(dir)
+	if err != nil {
+		return nil, fmt.Errorf("读取缓存目录失败: %v", err)
+	}
+
+	var infos []os.FileInfo
+	for _, entry := range dirEntries {
+		if entry.IsDir() || filepath.Ext(entry.Name()) != ".docx" {
+			continue
+		}
+		if info, err := entry.Info(); err == nil {
+			infos = append(infos, info)
+		}
+	}
+	sort.Slice(infos, func(i, j int) bool { return infos[i].ModTime().Before(infos[j].ModTime()) })
+
+	oc.mu.Lock()
+	defer oc.mu.Unlock()
+	for _, info := range infos {
+		key := strings.TrimSuffix(info.Name(), ".docx")
+		oc.entries[key] = oc.lru.PushFront(&outputCacheEntry{key: key, size: info.Size()})
+		oc.stats.SizeBytes += info.Size()
+	}
+	oc.evictLocked()
+
+	return oc, nil
+}
+
+// restore 缓存命中时把缓存的docx复制到outputFile（调用方传入的临时文件，由调用方改名）
+func (oc *outputCache) restore(key, outputFile string) bool {
+	oc.mu.Lock()
+	elem, ok := oc.entries[key]
+	if !ok {
+		oc.stats.Misses++
+		oc.mu.Unlock()
+		return false
+	}
+	oc.lru.MoveToFront(elem)
+	oc.mu.Unlock()
+
+	cached := oc.path(key)
+	if err := copyFile(cached, outputFile); err != nil {
+		// 缓存文件已被外部删除或损坏，按未命中处理
+		oc.mu.Lock()
+		oc.removeLocked(elem)
+		oc.stats.Misses++
+		oc.mu.Unlock()
+		return false
+	}
+
+	// 更新修改时间，重启后仍能恢复LRU顺序
+	now := time.Now()
+	os.Chtimes(cached, now, now)
+
+	oc.mu.Lock()
+	oc.stats.Hits++
+	oc.mu.Unlock()
+	return true
+}
+
+// store 把新生成的docx放入缓存
+func (oc *outputCache) store(key, outputFile string) error {
+	oc.mu.Lock()
+	_, exists := oc.entries[key]
+	oc.mu.Unlock()
+	if exists {
+		return nil
+	}
+
+	// 先写临时文件再重命名，避免并发读取到不完整的缓存文件
+	tmp, err := os.CreateTemp(oc.dir, ".tmp-*")
+	if err != nil {
+		return err
+	}
+	tmp.Close()
+	if err := copyFile(outputFile, tmp.Name()); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+	info, err := os.Stat(tmp.Name())
+	if err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+	if err := os.Rename(tmp.Name(), oc.path(key)); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+
+	oc.mu.Lock()
+	defer oc.mu.Unlock()
+	if _, exists := oc.entries[key]; !exists {
+		oc.entries[key] = oc.lru.PushFront(&outputCacheEntry{key: key, size: info.Size()})
+		oc.stats.SizeBytes += info.Size()
+		oc.evictLocked()
+	}
+	return nil
+}
+
+// snapshot 返回统计信息副本
+func (oc *outputCache) snapshot() CacheStats {
+	oc.mu.Lock()
+	defer oc.mu.Unlock()
+	stats := oc.stats
+	stats.Entries = len(oc.entries)
+	return stats
+}
+
+// evictLocked 淘汰最久未使用的条目直到总大小不超过上限，调用方需持有oc.mu
+func (oc *outputCache) evictLocked() {
+	for oc.stats.SizeBytes > oc.maxBytes && oc.lru.Len() > 0 {
+		oc.removeLocked(oc.lru.Back())
+		oc.stats.Evictions++
+	}
+}
+
+// removeLocked 删除单个条目及其文件，调用方需持有oc.mu
+func (oc *outputCache) removeLocked(elem *list.Element) {
+	entry := elem.Value.(*outputCacheEntry)
+	if current, ok := oc.entries[entry.key]; !ok || current != elem {
+		return
+	}
+	oc.lru.Remove(elem)
+	delete(oc.entries, entry.key)
+	oc.stats.SizeBytes -= entry.size
+	os.Remove(oc.path(entry.key))
+}
+
+// path 返回缓存文件路径
+func (oc *outputCache) path(key string) string {
+	return filepath.Join(oc.dir, key+".docx")
+}
+
+// outputCacheKey 计算输出缓存键
+// Markdown内容、引用的图片、参考模板、Pandoc版本和参数相同时输出必然相同
+// 输入和输出路径（plan.args的前三项）不计入缓存键
+func outputCacheKey(plan *conversionPlan) (string, error) {
+	// 缺少的图片之后出现时内容不同但键相同，这种输出不缓存
+	if len(plan.images.missing) > 0 {
+		return "", fmt.Errorf("引用的图片缺失: %s", strings.Join(plan.images.missing, ", "))
+	}
+
+	h := sha256.New()
+	fmt.Fprintf(h, "pandoc %s\x00", plan.pandoc.Version)
+	for _, arg := range plan.args[3:] {
+		fmt.Fprintf(h, "%s\x00", arg)
+	}
+	if plan.optimizer != nil {
+		fmt.Fprintf(h, "image-optimize %s\x00", plan.optimizer.settings())
+	}
+
+	fmt.Fprintf(h, "markdown %d\x00", len(plan.markdown))
+	h.Write(plan.markdown)
+
+	for i, path := range plan.images.images {
+		fmt.Fprintf(h, "image %s\x00", plan.images.refs[i])
+		if err := hashFile(h, path); err != nil {
+			return "", err
+		}
+	}
+
+	// 模板内容用注册表中的指纹表示，不必每次重新读取
+	if plan.template != nil {
+		fmt.Fprintf(h, "reference-doc %s\x00", plan.template.Fingerprint)
+	}
+
+	return hex.EncodeToString(h.Sum(nil)), nil
+}
+
+// hashFile 把文件内容写入哈希
+func hashFile(w io.Writer, path string) error {
+	file, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer file.Close()
+	_, err = io.Copy(w, file)
+	return err
+}
+
+// copyFile 复制文件内容
+func copyFile(src, dst string) error {
+	in, err := os.Open(src)
+	if err != nil {
+		return err
+	}
+	defer in.Close()
+
+	out, err := os.Create(dst)
+	if err != nil {
+		return err
+	}
+	if _, err := io.Copy(out, in); err != nil {
+		out.Close()
+		return err
+	}
+	return out.Close()
+}
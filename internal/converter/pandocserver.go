@@ -0,0 +1,428 @@
+package converter
+
+import (
+	"bytes"
+	"context"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"net"
+	"net/http"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"md2docx/internal/config"
+)
+
+const (
+	defaultServerMaxJobs     = 200  // 每个pandoc server进程处理多少个文档后回收
+	defaultServerMaxMemoryMB = 1024 // pandoc server进程内存上限（MB），超过后回收
+	serverStartupTimeout     = 10 * time.Second
+	serverRequestTimeout     = 5 * time.Minute
+)
+
+// errServerUnsupported 文档无法通过pandoc server转换，需要回退到启动新进程
+var errServerUnsupported = errors.New("文档不支持通过pandoc server转换")
+
+// serverResponseError pandoc server正常应答但转换失败（非200状态），进程本身仍然可用
+type serverResponseError struct {
+	status  int
+	message string
+}
+
+func (e *serverResponseError) Error() string {
+	return fmt.Sprintf("pandoc server返回错误 %d: %s", e.status, e.message)
+}
+
+// pandocServerPool 常驻的pandoc server进程池
+// 每个进程通过本地回环地址的HTTP接口接收转换请求，避免每个文档都启动新的pandoc
+type pandocServerPool struct {
+	command   []string // 启动pandoc server的命令（不含端口参数）
+	size      int
+	maxJobs   int
+	maxMemory int64
+	client    *http.Client
+
+	idle    chan *pandocServerWorker
+	mu      sync.Mutex
+	started int
+	closed  bool
+	workers map[*pandocServerWorker]struct{}
+}
+
+// pandocServerWorker 单个常驻pandoc server进程
+type pandocServerWorker struct {
+	cmd  *exec.Cmd
+	url  string
+	jobs int
+	done chan struct{} // 进程退出后关闭
+}
+
+// pandocServerRequest pandoc server的请求参数
+type pandocServerRequest struct {
+	Text         string            `json:"text"`
+	From         string            `json:"from"`
+	To           string            `json:"to"`
+	Standalone   bool              `json:"standalone"`
+	ReferenceDoc string            `json:"reference-doc,omitempty"`
+	Files        map[string]string `json:"files,omitempty"` // 文件名到base64内容的映射
+}
+
+// newPandocServerPool 创建pandoc server进程池
+// 会同步启动第一个进程以确认当前pandoc支持server模式，不支持时返回错误
+func newPandocServerPool(pandocPath string, size, maxJobs, maxMemoryMB int) (*pandocServerPool, error) {
+	if size < 1 {
+		size = 1
+	}
+	if maxJobs <= 0 {
+		maxJobs = defaultServerMaxJobs
+	}
+	if maxMemoryMB <= 0 {
+		maxMemoryMB = defaultServerMaxMemoryMB
+	}
+
+	pool := &pandocServerPool{
+		size:      size,
+		maxJobs:   maxJobs,
+		maxMemory: int64(maxMemoryMB) * 1024 * 1024,
+		client:    &http.Client{Timeout: serverRequestTimeout},
+		idle:      make(chan *pandocServerWorker, size),
+		workers:   make(map[*pandocServerWorker]struct{}),
+	}
+
+	// 优先使用 "pandoc server"，其次是同目录下的 pandoc-server
+	candidates := [][]string{{pandocPath, "server"}}
+	serverBinary := filepath.Join(filepath.Dir(pandocPath), "pandoc-server")
+	if _, err := os.Stat(serverBinary); err == nil {
+		candidates = append(candidates, []string{serverBinary})
+	}
+
+	var lastErr error
+	for _, command := range candidates {
+		pool.command = command
+		worker, err := pool.startWorker()
+		if err != nil {
+			lastErr = err
+			continue
+		}
+		pool.started = 1
+		pool.workers[worker] = struct{}{}
+		pool.idle <- worker
+		return pool, nil
+	}
+
+	return nil, fmt.Errorf("pandoc server模式不可用: %v", lastErr)
+}
+
+// convert 使用常驻进程转换单个文件，ctx取消时回收正在处理该文件的进程
+// template为nil表示不使用参考模板，模板内容取自注册表，不重新读取文件
+func (p *pandocServerPool) convert(ctx context.Context, markdown []byte, outputFile string, template *config.TemplateInfo) error {
+	// pandoc server无法访问本地文件系统，包含本地图片的文档交给常规路径处理
+	if bytes.Contains(markdown, []byte("![")) || bytes.Contains(markdown, []byte("<img")) {
+		return errServerUnsupported
+	}
+
+	request := pandocServerRequest{
+		Text:       string(markdown),
+		From:       "markdown",
+		To:         "docx",
+		Standalone: true,
+	}
+	if template != nil {
+		request.ReferenceDoc = "reference.docx"
+		request.Files = map[string]string{
+			"reference.docx": template.Base64(),
+		}
+	}
+
+	body, err := json.Marshal(request)
+	if err != nil {
+		return fmt.Errorf("序列化请求失败: %v", err)
+	}
+
+	worker, err := p.acquire(ctx)
+	if err != nil {
+		return err
+	}
+
+	output, err := p.post(ctx, worker, body)
+	var responseErr *serverResponseError
+	if err != nil && !errors.As(err, &responseErr) {
+		// 传输错误说明进程异常或请求被取消，直接回收，由调用方回退到常规路径
+		p.retire(worker)
+		return err
+	}
+	// 返回错误状态只说明该文档转换失败，进程仍可继续使用
+	p.release(worker)
+	if err != nil {
+		return err
+	}
+
+	if err := os.WriteFile(outputFile, output, 0644); err != nil {
+		return fmt.Errorf("写入输出文件失败: %v", err)
+	}
+	return nil
+}
+
+// post 向指定进程发送转换请求，返回docx内容
+func (p *pandocServerPool) post(ctx context.Context, worker *pandocServerWorker, body []byte) ([]byte, error) {
+	req, err := http.NewRequestWithContext(ctx, http.MethodPost, worker.url, bytes.NewReader(body))
+	if err != nil {
+		return nil, err
+	}
+	req.Header.Set("Content-Type", "application/json")
+	req.Header.Set("Accept", "application/octet-stream")
+
+	resp, err := p.client.Do(req)
+	if err != nil {
+		return nil, fmt.Errorf("pandoc server请求失败: %v", err)
+	}
+	defer resp.Body.Close()
+
+	output, err := io.ReadAll(resp.Body)
+	if err != nil {
+		return nil, fmt.Errorf("读取pandoc server响应失败: %v", err)
+	}
+	if resp.StatusCode != http.StatusOK {
+		return nil, &serverResponseError{status: resp.StatusCode, message: strings.TrimSpace(string(output))}
+	}
+	return output, nil
+}
+
+// acquire 获取一个空闲进程，必要时启动新进程
+func (p *pandocServerPool) acquire(ctx context.Context) (*pandocServerWorker, error) {
+	// drain和close会关闭空闲队列，此时读到的是零值
+	select {
+	case worker, ok := <-p.idle:
+		if !ok {
+			return nil, errors.New("pandoc server进程池已关闭")
+		}
+		return worker, nil
+	default:
+	}
+
+	p.mu.Lock()
+	if p.closed {
+		p.mu.Unlock()
+		return nil, errors.New("pandoc server进程池已关闭")
+	}
+	if p.started < p.size {
+		p.started++
+		p.mu.Unlock()
+
+		worker, err := p.startWorker()
+		p.mu.Lock()
+		defer p.mu.Unlock()
+		if err != nil {
+			p.started--
+			return nil, err
+		}
+		if p.closed {
+			worker.stop()
+			return nil, errors.New("pandoc server进程池已关闭")
+		}
+		p.workers[worker] = struct{}{}
+		return worker, nil
+	}
+	p.mu.Unlock()
+
+	// 所有进程都在忙，等待空闲进程；超时后由调用方回退到常规路径
+	select {
+	case worker, ok := <-p.idle:
+		if !ok {
+			return nil, errors.New("pandoc server进程池已关闭")
+		}
+		return worker, nil
+	case <-time.After(serverStartupTimeout):
+		return nil, errors.New("等待pandoc server空闲进程超时")
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// release 归还进程，达到任务数或内存上限时回收
+func (p *pandocServerPool) release(worker *pandocServerWorker) {
+	worker.jobs++
+	if worker.jobs >= p.maxJobs {
+		p.retire(worker)
+		return
+	}
+	if rss, ok := processRSS(worker.cmd.Process.Pid); ok && rss > p.maxMemory {
+		p.retire(worker)
+		return
+	}
+
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	if p.closed {
+		worker.stop()
+		delete(p.workers, worker)
+		return
+	}
+	p.idle <- worker
+}
+
+// retire 停止进程并释放其名额，下次需要时会启动新进程
+func (p *pandocServerPool) retire(worker *pandocServerWorker) {
+	worker.stop()
+
+	p.mu.Lock()
+	delete(p.workers, worker)
+	p.started--
+	p.mu.Unlock()
+
+	// 在后台补充新进程，避免等待中的请求因进程回收而饿死
+	go p.refill()
+}
+
+// refill 启动一个新进程并放入空闲队列
+func (p *pandocServerPool) refill() {
+	p.mu.Lock()
+	if p.closed || p.started >= p.size {
+		p.mu.Unlock()
+		return
+	}
+	p.started++
+	p.mu.Unlock()
+
+	worker, err := p.startWorker()
+
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	if err != nil {
+		p.started--
+		return
+	}
+	if p.closed {
+		worker.stop()
+		return
+	}
+	p.workers[worker] = struct{}{}
+	p.idle <- worker
+}
+
+// close 停止所有进程
+func (p *pandocServerPool) close() {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	if p.closed {
+		return
+	}
+	p.closed = true
+	for worker := range p.workers {
+		worker.stop()
+	}
+	p.workers = nil
+	close(p.idle)
+}
+
+// drain 停止接受新请求：空闲进程立即停止，正在转换的进程完成当前文档后在release中停止
+func (p *pandocServerPool) drain() {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	if p.closed {
+		return
+	}
+	p.closed = true
+drained:
+	for {
+		select {
+		case worker := <-p.idle:
+			worker.stop()
+			delete(p.workers, worker)
+		default:
+			break drained
+		}
+	}
+	close(p.idle)
+}
+
+// startWorker 启动一个pandoc server进程并等待其开始监听
+func (p *pandocServerPool) startWorker() (*pandocServerWorker, error) {
+	port, err := freeLoopbackPort()
+	if err != nil {
+		return nil, err
+	}
+
+	// pandoc server默认2秒后终止转换，大文档需要与请求超时一致的时限
+	args := append(append([]string{}, p.command[1:]...),
+		"--port", strconv.Itoa(port),
+		"--timeout", strconv.Itoa(int(serverRequestTimeout/time.Second)))
+	cmd := exec.Command(p.command[0], args...)
+	if err := cmd.Start(); err != nil {
+		return nil, err
+	}
+
+	worker := &pandocServerWorker{
+		cmd:  cmd,
+		url:  fmt.Sprintf("http://127.0.0.1:%d/", port),
+		done: make(chan struct{}),
+	}
+	go func() {
+		cmd.Wait()
+		close(worker.done)
+	}()
+
+	address := fmt.Sprintf("127.0.0.1:%d", port)
+	deadline := time.Now().Add(serverStartupTimeout)
+	for time.Now().Before(deadline) {
+		select {
+		case <-worker.done:
+			return nil, fmt.Errorf("%s 启动后立即退出", strings.Join(p.command, " "))
+		default:
+		}
+
+		if conn, err := net.DialTimeout("tcp", address, 100*time.Millisecond); err == nil {
+			conn.Close()
+			return worker, nil
+		}
+		time.Sleep(20 * time.Millisecond)
+	}
+
+	worker.stop()
+	return nil, fmt.Errorf("%s 启动超时", strings.Join(p.command, " "))
+}
+
+// stop 终止进程并等待退出
+func (w *pandocServerWorker) stop() {
+	select {
+	case <-w.done:
+		return
+	default:
+	}
+	w.cmd.Process.Kill()
+	<-w.done
+}
+
+// freeLoopbackPort 获取一个当前可用的本地端口
+func freeLoopbackPort() (int, error) {
+	listener, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		return 0, fmt.Errorf("无法获取可用端口: %v", err)
+	}
+	defer listener.Close()
+	return listener.Addr().(*net.TCPAddr).Port, nil
+}
+
+// processRSS 读取进程的常驻内存（仅Linux下可用）
+func processRSS(pid int) (int64, bool) {
+	data, err := os.ReadFile(fmt.Sprintf("/proc/%d/statm", pid))
+	if err != nil {
+		return 0, false
+	}
+	fields := strings.Fields(string(data))
+	if len(fields) < 2 {
+		return 0, false
+	}
+	pages, err := strconv.ParseInt(fields[1], 10, 64)
+	if err != nil {
+		return 0, false
+	}
+	return pages * int64(os.Getpagesize()), true
+}
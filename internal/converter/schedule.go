@@ -0,0 +1,245 @@
+package converter
+
+import (
+	"encoding/json"
+	"os"
+	"path/filepath"
+	"regexp"
+	"sort"
+	"sync"
+	"time"
+
+	"md2docx/internal/models"
+)
+
+// 代价模型的经验系数（毫秒），历史耗时会按实际情况整体校准
+const (
+	costBaseMs       = 150.0 // 启动pandoc等固定开销
+	costPerKBMs      = 2.0   // 每KB Markdown
+	costPerImageMs   = 20.0  // 每张图片
+	costPerImageMBMs = 40.0  // 每MB图片数据（需要读取并嵌入docx）
+	costPerTableMs   = 15.0  // 每个表格
+)
+
+// maxTimingEntries 历史耗时文件最多保留的条目数
+const maxTimingEntries = 5000
+
+var (
+	// 管道表格的分隔行，如 |---|:---:|
+	pipeTablePattern = regexp.MustCompile(`(?m)^\s*\|?\s*:?-{3,}:?\s*(\|\s*:?-{3,}:?\s*)+\|?\s*$`)
+	// 网格表格的边框行，如 +----+----+
+	gridTablePattern = regexp.MustCompile(`(?m)^\s*\+(-{3,}\+)+\s*$`)
+	// HTML表格
+	htmlTablePattern = regexp.MustCompile(`(?i)<table[\s>]`)
+)
+
+// documentCost 单个文档的代价特征
+type documentCost struct {
+	size       int64 // Markdown文件大小
+	images     int   // 本地图片数量
+	imageBytes int64 // 本地图片总大小
+	tables     int   // 表格数量
+}
+
+// estimateDocument 读取文档并统计代价特征，读取失败时返回零值（排在最短处，尽快报告错误）
+func estimateDocument(resolver *imageResolver, inputFile string) documentCost {
+	markdown, err := os.ReadFile(inputFile)
+	if err != nil {
+		return documentCost{}
+	}
+
+	cost := documentCost{size: int64(len(markdown))}
+	images := resolver.scan(markdown, filepath.Dir(inputFile))
+	cost.images = len(images.images) + len(images.missing)
+	for _, path := range images.images {
+		if info, err := os.Stat(path); err == nil {
+			cost.imageBytes += info.Size()
+		}
+	}
+
+	// 网格表格每行都有边框，按行数的一半粗略折算为表格数
+	cost.tables = len(pipeTablePattern.FindAllIndex(markdown, -1)) +
+		len(htmlTablePattern.FindAllIndex(markdown, -1)) +
+		(len(gridTablePattern.FindAllIndex(markdown, -1))+1)/2
+	return cost
+}
+
+// estimateMs 按经验系数估算转换耗时
+func (d documentCost) estimateMs() float64 {
+	return costBaseMs +
+		float64(d.size)/1024*costPerKBMs +
+		float64(d.images)*costPerImageMs +
+		float64(d.imageBytes)/(1024*1024)*costPerImageMBMs +
+		float64(d.tables)*costPerTableMs
+}
+
+// timingEntry 单个文件最近的实际转换耗时
+type timingEntry struct {
+	Size    int64     `json:"size"`
+	Millis  float64   `json:"ms"`
+	Updated time.Time `json:"updated"`
+}
+
+// timingHistory 历史转换耗时，保存在配置目录下，用于修正代价估算
+type timingHistory struct {
+	mu      sync.Mutex
+	path    string
+	entries map[string]*timingEntry
+	scale   float64 // 实际耗时与经验估算之比的滑动平均
+	dirty   bool
+}
+
+// timingHistoryFile 历史耗时文件的格式
+type timingHistoryFile struct {
+	Scale   float64                 `json:"scale"`
+	Entries map[string]*timingEntry `json:"entries"`
+}
+
+// loadTimingHistory 读取历史耗时，文件不存在或损坏时从空记录开始
+func loadTimingHistory(path string) *timingHistory {
+	h := &timingHistory{path: path, entries: make(map[string]*timingEntry), scale: 1}
+
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return h
+	}
+	var file timingHistoryFile
+	if err := json.Unmarshal(data, &file); err != nil {
+		return h
+	}
+	if file.Entries != nil {
+		h.entries = file.Entries
+	}
+	if file.Scale > 0 {
+		h.scale = file.Scale
+	}
+	return h
+}
+
+// predict 预测文件的转换耗时：文件大小未变时使用上次的实际耗时，否则使用校准后的估算
+func (h *timingHistory) predict(inputFile string, cost documentCost) float64 {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	if entry, ok := h.entries[inputFile]; ok && entry.Size == cost.size {
+		return entry.Millis
+	}
+	return cost.estimateMs() * h.scale
+}
+
+// record 记录一次实际转换耗时
+func (h *timingHistory) record(inputFile string, cost documentCost, elapsed time.Duration) {
+	millis := float64(elapsed) / float64(time.Millisecond)
+
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	entry, ok := h.entries[inputFile]
+	if ok && entry.Size == cost.size {
+		entry.Millis = (entry.Millis + millis) / 2
+	} else {
+		entry = &timingEntry{Size: cost.size, Millis: millis}
+		h.entries[inputFile] = entry
+	}
+	entry.Updated = time.Now()
+
+	// 校准经验系数，限制单次偏差的影响
+	if ratio := millis / cost.estimateMs(); ratio > 0 {
+		if ratio < 0.05 {
+			ratio = 0.05
+		} else if ratio > 20 {
+			ratio = 20
+		}
+		h.scale = h.scale*0.8 + ratio*0.2
+	}
+	h.dirty = true
+}
+
+// save 写回历史耗时，超出上限时丢弃最久未更新的条目
+func (h *timingHistory) save() error {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	if !h.dirty {
+		return nil
+	}
+
+	if len(h.entries) > maxTimingEntries {
+		paths := make([]string, 0, len(h.entries))
+		for path := range h.entries {
+			paths = append(paths, path)
+		}
+		sort.Slice(paths, func(i, j int) bool {
+			return h.entries[paths[i]].Updated.After(h.entries[paths[j]].Updated)
+		})
+		for _, path := range paths[maxTimingEntries:] {
+			delete(h.entries, path)
+		}
+	}
+
+	data, err := json.Marshal(timingHistoryFile{Scale: h.scale, Entries: h.entries})
+	if err != nil {
+		return err
+	}
+
+	// 先写临时文件再改名，多个后端进程同时保存时不会留下半个文件
+	tmp, err := os.CreateTemp(filepath.Dir(h.path), ".timings-*.tmp")
+	if err != nil {
+		return err
+	}
+	if _, err := tmp.Write(data); err != nil {
+		tmp.Close()
+		os.Remove(tmp.Name())
+		return err
+	}
+	if err := tmp.Close(); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+	if err := os.Rename(tmp.Name(), h.path); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+
+	h.dirty = false
+	return nil
+}
+
+// batchSchedule 批量转换的调度结果
+type batchSchedule struct {
+	order   []int          // 文件的开始顺序（原始序号）
+	costs   []documentCost // 按原始序号排列，未启用调度时为nil
+	history *timingHistory
+}
+
+// scheduleBatch 按请求指定的顺序安排文件：
+// longest_first 预计耗时长的先开始，避免大文件排在最后拖长整批的完成时间；
+// shortest_first 预计耗时短的先开始，尽快返回第一批结果。
+func (c *Converter) scheduleBatch(req *models.BatchConversionRequest, resolver *imageResolver) *batchSchedule {
+	schedule := &batchSchedule{order: make([]int, len(req.InputFiles))}
+	for i := range schedule.order {
+		schedule.order[i] = i
+	}
+
+	if req.Order != models.OrderLongestFirst && req.Order != models.OrderShortestFirst {
+		return schedule
+	}
+
+	history := c.timingHistory()
+	schedule.history = history
+	schedule.costs = make([]documentCost, len(req.InputFiles))
+	predicted := make([]float64, len(req.InputFiles))
+	for i, inputFile := range req.InputFiles {
+		schedule.costs[i] = estimateDocument(resolver, inputFile)
+		predicted[i] = history.predict(inputFile, schedule.costs[i])
+	}
+
+	sort.SliceStable(schedule.order, func(i, j int) bool {
+		a, b := predicted[schedule.order[i]], predicted[schedule.order[j]]
+		if req.Order == models.OrderLongestFirst {
+			return a > b
+		}
+		return a < b
+	})
+	return schedule
+}
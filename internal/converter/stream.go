@@ -0,0 +1,205 @@
+package converter
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/base64"
+	"errors"
+	"fmt"
+	"io"
+	"mime"
+	"os/exec"
+	"path"
+	"path/filepath"
+	"regexp"
+)
+
+// maxStderrBytes 流式转换保留的pandoc错误输出上限
+const maxStderrBytes = 64 * 1024
+
+// StreamImage 随流式转换上传的图片，以data URI形式内联到Markdown中
+type StreamImage struct {
+	ContentType string
+	Data        []byte
+}
+
+// ConvertStream 从markdown读取内容，经pandoc标准输入输出直接转换，不创建任何临时文件
+//
+// images中的图片按文件名匹配Markdown中的图片引用并替换为data URI，pandoc会将其嵌入docx。
+// pandoc开始输出时调用start获取写入目标，此前出错时start不会被调用，调用方仍可返回错误响应；
+// start被调用后返回的错误表示输出不完整。
+// 单文件请求一样走交互式通道，排队已满时返回*QueueFullError。
+func (c *Converter) ConvertStream(ctx context.Context, markdown io.Reader, images map[string]StreamImage, start func() io.Writer) error {
+	cfg := c.config.Load()
+	pandoc, err := cfg.Pandoc()
+	if err != nil {
+		return fmt.Errorf("Pandoc配置无效: %v", err)
+	}
+
+	args := []string{
+		"-f", "markdown",
+		"-t", "docx",
+		"--standalone",
+		"-o", "-",
+	}
+	if cfg.TemplateFile != "" {
+		if err := cfg.ValidateTemplate(); err == nil {
+			args = append(args, "--reference-doc", cfg.TemplateFile)
+		}
+	}
+
+	release, err := c.admission.tryAcquire(ctx, LaneInteractive)
+	if err != nil {
+		if _, busy := err.(*QueueFullError); busy {
+			return err
+		}
+		return errors.New(interruptedMessage(ctx))
+	}
+	defer release()
+
+	cmd := exec.CommandContext(ctx, pandoc.Path, args...)
+	cmd.WaitDelay = pandocWaitDelay
+	cmd.Stdin = markdown
+	if len(images) > 0 {
+		cmd.Stdin = newImageInliner(markdown, images)
+	}
+	stderr := &limitedBuffer{limit: maxStderrBytes}
+	cmd.Stderr = stderr
+
+	stdout, err := cmd.StdoutPipe()
+	if err != nil {
+		return fmt.Errorf("创建pandoc输出管道失败: %v", err)
+	}
+	if err := cmd.Start(); err != nil {
+		return fmt.Errorf("启动Pandoc失败: %v", err)
+	}
+
+	// 等到pandoc产生第一个字节再开始响应，转换失败时仍可返回错误
+	output := bufio.NewReaderSize(stdout, 32*1024)
+	if _, err := output.Peek(1); err != nil {
+		waitErr := cmd.Wait()
+		if ctx.Err() != nil {
+			return errors.New(interruptedMessage(ctx))
+		}
+		if waitErr == nil {
+			waitErr = errors.New("没有输出")
+		}
+		return fmt.Errorf("Pandoc执行失败: %v, 输出: %s", waitErr, stderr.String())
+	}
+
+	_, copyErr := io.Copy(start(), output)
+	if copyErr != nil {
+		// 客户端已断开，不再等待pandoc写完
+		cmd.Process.Kill()
+	}
+	waitErr := cmd.Wait()
+
+	switch {
+	case ctx.Err() != nil:
+		return errors.New(interruptedMessage(ctx))
+	case copyErr != nil:
+		return fmt.Errorf("写入转换结果失败: %v", copyErr)
+	case waitErr != nil:
+		return fmt.Errorf("Pandoc执行失败: %v, 输出: %s", waitErr, stderr.String())
+	}
+	return nil
+}
+
+// imageInliner 逐行读取Markdown，把引用上传图片的路径替换为data URI
+// 只缓存当前行，内存占用与文档大小无关
+type imageInliner struct {
+	source  *bufio.Reader
+	images  map[string]StreamImage
+	pending []byte
+	err     error
+}
+
+func newImageInliner(source io.Reader, images map[string]StreamImage) *imageInliner {
+	return &imageInliner{source: bufio.NewReader(source), images: images}
+}
+
+func (r *imageInliner) Read(p []byte) (int, error) {
+	for len(r.pending) == 0 {
+		if r.err != nil {
+			return 0, r.err
+		}
+		line, err := r.source.ReadBytes('\n')
+		r.err = err
+		r.pending = r.inline(line)
+	}
+
+	n := copy(p, r.pending)
+	r.pending = r.pending[n:]
+	return n, nil
+}
+
+// inline 替换一行中的图片引用
+func (r *imageInliner) inline(line []byte) []byte {
+	for _, pattern := range []*regexp.Regexp{inlineImagePattern, htmlImagePattern} {
+		matches := pattern.FindAllSubmatchIndex(line, -1)
+		if matches == nil {
+			continue
+		}
+
+		var buf bytes.Buffer
+		last, replaced := 0, false
+		for _, match := range matches {
+			start, end := match[2], match[3]
+			image, ok := r.lookup(string(line[start:end]))
+			if !ok {
+				continue
+			}
+			buf.Write(line[last:start])
+			buf.WriteString(dataURI(image))
+			last, replaced = end, true
+		}
+		if replaced {
+			buf.Write(line[last:])
+			line = buf.Bytes()
+		}
+	}
+	return line
+}
+
+// lookup 按引用路径或文件名查找上传的图片（multipart上传时只保留文件名）
+func (r *imageInliner) lookup(ref string) (StreamImage, bool) {
+	if image, ok := r.images[ref]; ok {
+		return image, true
+	}
+	image, ok := r.images[path.Base(filepath.ToSlash(ref))]
+	return image, ok
+}
+
+// dataURI 将图片编码为data URI
+func dataURI(image StreamImage) string {
+	return "data:" + image.ContentType + ";base64," + base64.StdEncoding.EncodeToString(image.Data)
+}
+
+// ImageContentType 返回上传图片的MIME类型，未声明时按扩展名推断
+func ImageContentType(fileName, declared string) string {
+	if declared != "" && declared != "application/octet-stream" {
+		return declared
+	}
+	if contentType := mime.TypeByExtension(filepath.Ext(fileName)); contentType != "" {
+		return contentType
+	}
+	return "application/octet-stream"
+}
+
+// limitedBuffer 只保留前limit个字节的缓冲区
+type limitedBuffer struct {
+	bytes.Buffer
+	limit int
+}
+
+func (b *limitedBuffer) Write(p []byte) (int, error) {
+	if room := b.limit - b.Len(); room > 0 {
+		if len(p) > room {
+			b.Buffer.Write(p[:room])
+		} else {
+			b.Buffer.Write(p)
+		}
+	}
+	return len(p), nil
+}
@@ -0,0 +1,202 @@
+package jobs
+
+import (
+	"context"
+	"crypto/rand"
+	"encoding/hex"
+	"fmt"
+	"sync"
+	"time"
+
+	"md2docx/internal/converter"
+	"md2docx/internal/models"
+)
+
+// jobRetention 已结束的任务在内存中保留的时间
+const jobRetention = time.Hour
+
+// Manager 异步转换任务管理器
+// 任务保存在内存中，提交后立即返回任务ID，客户端通过ID查询进度或取消任务
+type Manager struct {
+	converter *converter.Converter
+	mu        sync.Mutex
+	jobs      map[string]*job
+}
+
+// job 单个批量转换任务
+type job struct {
+	mu     sync.Mutex
+	status models.ConversionStatus
+	cancel context.CancelFunc
+}
+
+// NewManager 创建任务管理器
+func NewManager(conv *converter.Converter) *Manager {
+	return &Manager{
+		converter: conv,
+		jobs:      make(map[string]*job),
+	}
+}
+
+// Submit 提交批量转换任务，立即返回任务的初始状态
+func (m *Manager) Submit(req *models.BatchConversionRequest) (*models.ConversionStatus, error) {
+	id, err := newJobID()
+	if err != nil {
+		return nil, err
+	}
+
+	results := make([]models.ConversionResult, len(req.InputFiles))
+	for i, inputFile := range req.InputFiles {
+		results[i] = models.ConversionResult{InputFile: inputFile, Status: models.StatusPending}
+	}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	j := &job{
+		status: models.ConversionStatus{
+			ID:         id,
+			Status:     models.StatusPending,
+			Message:    "任务已提交",
+			StartTime:  time.Now(),
+			InputFiles: append([]string(nil), req.InputFiles...),
+			Results:    results,
+		},
+		cancel: cancel,
+	}
+
+	m.mu.Lock()
+	m.removeExpiredLocked()
+	m.jobs[id] = j
+	m.mu.Unlock()
+
+	go m.run(ctx, j, req)
+
+	return j.snapshot(), nil
+}
+
+// Get 查询任务状态
+func (m *Manager) Get(id string) (*models.ConversionStatus, bool) {
+	m.mu.Lock()
+	j, ok := m.jobs[id]
+	m.mu.Unlock()
+	if !ok {
+		return nil, false
+	}
+	return j.snapshot(), true
+}
+
+// Cancel 取消任务，已结束的任务保持原状态
+func (m *Manager) Cancel(id string) (*models.ConversionStatus, bool) {
+	m.mu.Lock()
+	j, ok := m.jobs[id]
+	m.mu.Unlock()
+	if !ok {
+		return nil, false
+	}
+
+	j.mu.Lock()
+	if j.status.EndTime == nil {
+		j.status.Message = "正在取消任务"
+	}
+	j.mu.Unlock()
+	j.cancel()
+
+	return j.snapshot(), true
+}
+
+// run 在后台执行任务
+func (m *Manager) run(ctx context.Context, j *job, req *models.BatchConversionRequest) {
+	defer j.cancel()
+
+	j.mu.Lock()
+	j.status.Status = models.StatusProcessing
+	j.status.Message = "正在转换"
+	j.mu.Unlock()
+
+	response, err := m.converter.ConvertBatchContext(ctx, req, func(index int, result models.ConversionResult) {
+		j.mu.Lock()
+		defer j.mu.Unlock()
+		j.status.Results[index] = result
+		j.status.Completed++
+		j.status.Progress = j.status.Completed * 100 / len(j.status.Results)
+	})
+
+	j.mu.Lock()
+	defer j.mu.Unlock()
+
+	endTime := time.Now()
+	j.status.EndTime = &endTime
+
+	if err != nil {
+		j.status.Status = models.StatusFailed
+		j.status.Message = fmt.Sprintf("转换服务内部错误: %v", err)
+		return
+	}
+
+	for _, result := range response.Results {
+		if len(result.OutputFiles) > 0 {
+			// 多模板转换时部分模板失败的文件，已生成的输出同样列出
+			j.status.OutputFiles = append(j.status.OutputFiles, result.OutputFiles...)
+		} else if result.Success {
+			j.status.OutputFiles = append(j.status.OutputFiles, result.OutputFile)
+		}
+		if !result.Success && result.Error != "" {
+			j.status.Errors = append(j.status.Errors, fmt.Sprintf("%s: %s", result.InputFile, result.Error))
+		}
+	}
+
+	switch {
+	case ctx.Err() != nil:
+		j.status.Status = models.StatusCancelled
+	case response.Success:
+		j.status.Status = models.StatusCompleted
+	default:
+		j.status.Status = models.StatusFailed
+	}
+
+	j.status.Message = response.Message
+	if len(response.Results) == 0 && response.Error != "" {
+		// 请求本身无效（如输入为空或输出目录不可写）
+		j.status.Message = response.Error
+		j.status.Errors = append(j.status.Errors, response.Error)
+	}
+	j.status.Progress = 100
+}
+
+// removeExpiredLocked 清理超过保留时间的已结束任务，调用方需持有m.mu
+func (m *Manager) removeExpiredLocked() {
+	cutoff := time.Now().Add(-jobRetention)
+	for id, j := range m.jobs {
+		j.mu.Lock()
+		expired := j.status.EndTime != nil && j.status.EndTime.Before(cutoff)
+		j.mu.Unlock()
+		if expired {
+			delete(m.jobs, id)
+		}
+	}
+}
+
+// snapshot 返回任务状态的副本
+func (j *job) snapshot() *models.ConversionStatus {
+	j.mu.Lock()
+	defer j.mu.Unlock()
+
+	status := j.status
+	status.InputFiles = append([]string(nil), j.status.InputFiles...)
+	status.OutputFiles = append([]string(nil), j.status.OutputFiles...)
+	status.Errors = append([]string(nil), j.status.Errors...)
+	status.Results = append([]models.ConversionResult(nil), j.status.Results...)
+	if j.status.EndTime != nil {
+		endTime := *j.status.EndTime
+		status.EndTime = &endTime
+	}
+	return &status
+}
+
+// newJobID 生成随机任务ID
+func newJobID() (string, error) {
+	buf := make([]byte, 8)
+	if _, err := rand.Read(buf); err != nil {
+		return "", fmt.Errorf("生成任务ID失败: %v", err)
+	}
+	return hex.EncodeToString(buf), nil
+}
@@ -0,0 +1,130 @@
+package jobs
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"testing"
+	"time"
+
+	"md2docx/internal/config"
+	"md2docx/internal/converter"
+	"md2docx/internal/models"
+)
+
+func TestSubmitAndGet(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := t.TempDir()
+	inputFiles := createInputFiles(t, tmpDir, "doc", 3)
+	manager := NewManager(converter.New(&config.Config{PandocPath: createFakePandoc(t, tmpDir)}))
+
+	status, err := manager.Submit(&models.BatchConversionRequest{InputFiles: inputFiles})
+	if err != nil {
+		t.Fatalf("提交任务失败: %v", err)
+	}
+	if status.ID == "" {
+		t.Fatal("任务ID为空")
+	}
+
+	status = waitForJob(t, manager, status.ID)
+	if status.Status != models.StatusCompleted {
+		t.Errorf("期望任务状态 %s, 实际 %s (%s)", models.StatusCompleted, status.Status, status.Message)
+	}
+	if status.Progress != 100 || status.Completed != len(inputFiles) {
+		t.Errorf("进度不正确: progress=%d completed=%d", status.Progress, status.Completed)
+	}
+	if len(status.OutputFiles) != len(inputFiles) {
+		t.Errorf("期望输出文件 %d 个, 实际 %d 个", len(inputFiles), len(status.OutputFiles))
+	}
+	for i, result := range status.Results {
+		if result.InputFile != inputFiles[i] || result.Status != models.StatusCompleted {
+			t.Errorf("文件 %d 状态不正确: %+v", i, result)
+		}
+	}
+}
+
+func TestCancel(t *testing.T) {
+	if runtime.GOOS == "windows" {
+		t.Skip("需要shell脚本模拟pandoc")
+	}
+
+	tmpDir := t.TempDir()
+	inputFiles := createInputFiles(t, tmpDir, "slow", 4)
+	manager := NewManager(converter.New(&config.Config{
+		PandocPath: createFakePandoc(t, tmpDir),
+		MaxWorkers: 1,
+	}))
+
+	status, err := manager.Submit(&models.BatchConversionRequest{InputFiles: inputFiles})
+	if err != nil {
+		t.Fatalf("提交任务失败: %v", err)
+	}
+	if _, ok := manager.Cancel(status.ID); !ok {
+		t.Fatal("取消任务失败")
+	}
+
+	status = waitForJob(t, manager, status.ID)
+	if status.Status != models.StatusCancelled {
+		t.Errorf("期望任务状态 %s, 实际 %s", models.StatusCancelled, status.Status)
+	}
+	if last := status.Results[len(status.Results)-1]; last.Status != models.StatusCancelled {
+		t.Errorf("期望最后一个文件被取消, 实际 %+v", last)
+	}
+}
+
+func TestGetUnknownJob(t *testing.T) {
+	manager := NewManager(converter.New(&config.Config{}))
+	if _, ok := manager.Get("missing"); ok {
+		t.Error("期望找不到任务")
+	}
+	if _, ok := manager.Cancel("missing"); ok {
+		t.Error("期望找不到任务")
+	}
+}
+
+// 辅助函数：等待任务结束
+func waitForJob(t *testing.T, manager *Manager, id string) *models.ConversionStatus {
+	deadline := time.Now().Add(10 * time.Second)
+	for time.Now().Before(deadline) {
+		status, ok := manager.Get(id)
+		if !ok {
+			t.Fatalf("任务 %s 不存在", id)
+		}
+		if status.EndTime != nil {
+			return status
+		}
+		time.Sleep(20 * time.Millisecond)
+	}
+	t.Fatalf("任务 %s 未在规定时间内结束", id)
+	return nil
+}
+
+// 辅助函数：创建测试用的Markdown文件
+func createInputFiles(t *testing.T, dir, prefix string, count int) []string {
+	var files []string
+	for i := 0; i < count; i++ {
+		path := filepath.Join(dir, fmt.Sprintf("%s%d.md", prefix, i))
+		if err := os.WriteFile(path, []byte("# 标题\n"), 0644); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		files = append(files, path)
+	}
+	return files
+}
+
+// 辅助函数：创建模拟pandoc的shell脚本，文件名包含slow的文档会延迟1秒
+func createFakePandoc(t *testing.T, dir string) string {
+	fakePandoc := filepath.Join(dir, "pandoc")
+	script := "#!/bin/sh\n" +
+		"case \"$1\" in --version) echo 'pandoc 3.0'; exit 0 ;; --*) exit 0 ;; server) exit 1 ;; esac\n" +
+		"case \"$1\" in *slow*) sleep 1 ;; esac\n" +
+		"echo docx > \"$3\"\n"
+	if err := os.WriteFile(fakePandoc, []byte(script), 0755); err != nil {
+		t.Fatalf("创建假pandoc失败: %v", err)
+	}
+	return fakePandoc
+}
@@ -12,11 +12,32 @@ type ConversionRequest struct {
 
 // BatchConversionRequest 批量转换请求
 type BatchConversionRequest struct {
-	InputFiles   []string `json:"input_files"`   // 输入Markdown文件路径列表
-	OutputDir    string   `json:"output_dir"`    // 统一输出目录路径（可选）
-	TemplateFile string   `json:"template_file"` // 参考模板文件路径（可选）
+	InputFiles   []string         `json:"input_files"`         // 输入Markdown文件路径列表
+	OutputDir    string           `json:"output_dir"`          // 统一输出目录路径（可选）
+	TemplateFile string           `json:"template_file"`       // 参考模板文件路径（可选）
+	Templates    []TemplateOutput `json:"templates,omitempty"` // 多个模板各生成一份输出，指定时忽略template_file（可选）
+	Incremental  bool             `json:"incremental"`         // 增量转换：输出已是最新的文件直接跳过（可选）
+	Order        string           `json:"order"`               // 调度顺序，取值见Order常量（可选）
 }
 
+// TemplateOutput 多模板批量转换中的一个模板及其输出命名规则
+// 每个文档只解析一次，再按各个模板分别生成docx
+type TemplateOutput struct {
+	TemplateFile string `json:"template_file"` // 参考模板文件路径，为空时使用配置的默认模板
+	OutputName   string `json:"output_name"`   // 输出文件名（不含扩展名），{name}替换为输入文件名；为空时为"{name}-模板文件名"
+	OutputDir    string `json:"output_dir"`    // 该模板的输出目录，为空时使用请求的output_dir（可选）
+}
+
+// TemplateNamePlaceholder 模板输出文件名中代表输入文件名（不含扩展名）的占位符
+const TemplateNamePlaceholder = "{name}"
+
+// 批量转换的调度顺序，按文档大小、图片、表格和历史耗时估算每个文件的代价
+const (
+	OrderInput         = ""               // 按输入顺序
+	OrderLongestFirst  = "longest_first"  // 预计耗时长的先开始，适合并行批量缩短总耗时
+	OrderShortestFirst = "shortest_first" // 预计耗时短的先开始，尽快看到第一批结果
+)
+
 // ConversionResponse 转换响应
 type ConversionResponse struct {
 	Success    bool                  `json:"success"`
@@ -26,18 +47,39 @@ type ConversionResponse struct {
 	Error      string                `json:"error,omitempty"`
 }
 
+// 任务及单个文件的状态
+const (
+	StatusPending    = "pending"
+	StatusProcessing = "processing"
+	StatusCompleted  = "completed"
+	StatusFailed     = "failed"
+	StatusCancelled  = "cancelled"
+	StatusSkipped    = "skipped" // 增量转换中输出已是最新
+)
+
 // ConversionResult 单个文件的转换结果
 type ConversionResult struct {
-	InputFile  string `json:"input_file"`
-	OutputFile string `json:"output_file"`
-	Success    bool   `json:"success"`
-	Error      string `json:"error,omitempty"`
+	InputFile   string   `json:"input_file"`
+	OutputFile  string   `json:"output_file"`
+	OutputFiles []string `json:"output_files,omitempty"` // 多模板转换时按模板顺序排列的所有输出
+	Success     bool     `json:"success"`
+	Status      string   `json:"status,omitempty"` // 文件状态，取值见Status常量
+	Error       string   `json:"error,omitempty"`
+}
+
+// BatchStreamEvent 流式批量转换事件，对应NDJSON响应中的一行
+type BatchStreamEvent struct {
+	Event    string              `json:"event"` // "item"：单个文件完成；"done"：全部结束
+	Index    int                 `json:"index"`
+	Total    int                 `json:"total"`
+	Result   *ConversionResult   `json:"result,omitempty"`
+	Response *ConversionResponse `json:"response,omitempty"`
 }
 
 // ConversionStatus 转换状态
 type ConversionStatus struct {
 	ID          string    `json:"id"`
-	Status      string    `json:"status"` // "pending", "processing", "completed", "failed"
+	Status      string    `json:"status"` // "pending", "processing", "completed", "failed", "cancelled"
 	Progress    int       `json:"progress"` // 0-100
 	Message     string    `json:"message"`
 	StartTime   time.Time `json:"start_time"`
@@ -45,6 +87,10 @@ type ConversionStatus struct {
 	InputFiles  []string  `json:"input_files"`
 	OutputFiles []string  `json:"output_files,omitempty"`
 	Errors      []string  `json:"errors,omitempty"`
+
+	// 批量任务的逐文件进度
+	Completed int                `json:"completed"`         // 已处理的文件数
+	Results   []ConversionResult `json:"results,omitempty"` // 每个文件的进度，与InputFiles顺序一致
 }
 
 // ConfigRequest 配置请求
@@ -0,0 +1,20 @@
+//go:build !(linux || darwin || freebsd)
+
+package utils
+
+import (
+	"os"
+	"path/filepath"
+)
+
+// checkDirWritable 没有access(2)的平台上（如Windows的目录只读属性不影响创建文件）
+// 仍通过创建探测文件检查，结果由ValidateOutputDir缓存，每个目录只检查一次
+func checkDirWritable(dirPath string) error {
+	testFile := filepath.Join(dirPath, ".write_test")
+	file, err := os.Create(testFile)
+	if err != nil {
+		return err
+	}
+	file.Close()
+	return os.Remove(testFile)
+}
@@ -0,0 +1,16 @@
+//go:build linux || darwin || freebsd
+
+package utils
+
+import "syscall"
+
+// access(2)的模式位
+const (
+	accessWrite   = 0x2 // W_OK
+	accessExecute = 0x1 // X_OK，在目录中创建文件还需要进入目录的权限
+)
+
+// checkDirWritable 用access(2)检查目录是否可写，不在目录中创建任何文件
+func checkDirWritable(dirPath string) error {
+	return syscall.Access(dirPath, accessWrite|accessExecute)
+}
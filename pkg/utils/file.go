@@ -2,9 +2,11 @@ package utils
 
 import (
 	"fmt"
+	"math/rand"
 	"os"
 	"path/filepath"
 	"strings"
+	"sync"
 )
 
 // ValidateInputFile 验证输入文件
@@ -34,31 +36,112 @@ func ValidateInputFile(filePath string) error {
 	return nil
 }
 
+// maxWritableDirs 可写目录缓存的条目上限，超出时整体清空
+const maxWritableDirs = 1024
+
+// writableDirs 已确认可写的输出目录
+// 检查结果按目录缓存，不再每次转换都在目录中创建再删除探测文件；
+// 写入输出失败时通过InvalidateOutputDir清除，下次验证时重新检查。
+var writableDirs = struct {
+	sync.Mutex
+	dirs map[string]struct{}
+}{dirs: make(map[string]struct{})}
+
 // ValidateOutputDir 验证输出目录
 func ValidateOutputDir(dirPath string) error {
 	if dirPath == "" {
 		return nil // 输出目录可以为空，使用默认值
 	}
 
+	key := filepath.Clean(dirPath)
+	writableDirs.Lock()
+	_, known := writableDirs.dirs[key]
+	writableDirs.Unlock()
+	if known {
+		return nil
+	}
+
 	// 检查目录是否存在，如果不存在则创建
-	if _, err := os.Stat(dirPath); os.IsNotExist(err) {
+	info, err := os.Stat(dirPath)
+	if os.IsNotExist(err) {
 		if err := os.MkdirAll(dirPath, 0755); err != nil {
 			return fmt.Errorf("无法创建输出目录: %v", err)
 		}
+	} else if err != nil {
+		return fmt.Errorf("无法访问输出目录: %v", err)
+	} else if !info.IsDir() {
+		return fmt.Errorf("输出路径不是目录: %s", dirPath)
 	}
 
 	// 检查目录是否可写
-	testFile := filepath.Join(dirPath, ".write_test")
-	file, err := os.Create(testFile)
-	if err != nil {
+	if err := checkDirWritable(dirPath); err != nil {
 		return fmt.Errorf("输出目录不可写: %v", err)
 	}
-	file.Close()
-	os.Remove(testFile)
 
+	writableDirs.Lock()
+	if len(writableDirs.dirs) >= maxWritableDirs {
+		writableDirs.dirs = make(map[string]struct{})
+	}
+	writableDirs.dirs[key] = struct{}{}
+	writableDirs.Unlock()
 	return nil
 }
 
+// InvalidateOutputDir 清除目录的可写缓存，在目录中写入失败时调用
+func InvalidateOutputDir(dirPath string) {
+	writableDirs.Lock()
+	delete(writableDirs.dirs, filepath.Clean(dirPath))
+	writableDirs.Unlock()
+}
+
+// CreateTempOutput 在输出文件所在目录创建空的临时文件，返回其路径
+// 内容写完后由CommitOutput改名为最终文件名，读取方不会看到写了一半的文件。
+// 临时文件与os.Create一样按umask确定权限，改名后输出文件的权限不变。
+func CreateTempOutput(outputPath string) (string, error) {
+	dir, base := filepath.Split(outputPath)
+	if dir == "" {
+		dir = "."
+	}
+
+	for try := 0; ; try++ {
+		name := filepath.Join(dir, fmt.Sprintf(".%s.%d.tmp", base, rand.Uint32()))
+		file, err := os.OpenFile(name, os.O_RDWR|os.O_CREATE|os.O_EXCL, 0666)
+		if err == nil {
+			file.Close()
+			return name, nil
+		}
+		if os.IsExist(err) && try < 100 {
+			continue
+		}
+		InvalidateOutputDir(dir)
+		return "", err
+	}
+}
+
+// CommitOutput 把临时文件改名为输出文件，替换已有的同名文件；失败时删除临时文件
+func CommitOutput(tempPath, outputPath string) error {
+	if err := os.Rename(tempPath, outputPath); err != nil {
+		os.Remove(tempPath)
+		InvalidateOutputDir(filepath.Dir(outputPath))
+		return err
+	}
+	return nil
+}
+
+// WriteFileAtomic 写入文件：先写同目录下的临时文件，再改名为目标文件
+func WriteFileAtomic(path string, data []byte) error {
+	tempPath, err := CreateTempOutput(path)
+	if err != nil {
+		return err
+	}
+	if err := os.WriteFile(tempPath, data, 0666); err != nil {
+		os.Remove(tempPath)
+		InvalidateOutputDir(filepath.Dir(path))
+		return err
+	}
+	return CommitOutput(tempPath, path)
+}
+
 // DetermineOutputPath 确定输出文件路径
 func DetermineOutputPath(inputFile, outputDir, outputName string) (string, error) {
 	// 确定输出目录
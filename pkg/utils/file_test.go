@@ -81,6 +81,67 @@ func TestValidateOutputDir(t *testing.T) {
 	}
 }
 
+func TestValidateOutputDir_Cached(t *testing.T) {
+	tmpDir, err := os.MkdirTemp("", "output_test")
+	if err != nil {
+		t.Fatalf("创建临时目录失败: %v", err)
+	}
+	defer os.RemoveAll(tmpDir)
+
+	if err := ValidateOutputDir(tmpDir); err != nil {
+		t.Fatalf("验证有效目录失败: %v", err)
+	}
+	entries, _ := os.ReadDir(tmpDir)
+	if len(entries) != 0 {
+		t.Errorf("验证目录时不应创建文件, 实际 %d 个", len(entries))
+	}
+
+	// 目录被删除后缓存仍然有效，写入失败时清除缓存并重新创建目录
+	os.RemoveAll(tmpDir)
+	if _, err := CreateTempOutput(filepath.Join(tmpDir, "a.docx")); err == nil {
+		t.Fatal("期望在已删除的目录中创建临时文件失败")
+	}
+	if err := ValidateOutputDir(tmpDir); err != nil {
+		t.Fatalf("重新验证目录失败: %v", err)
+	}
+	if _, err := os.Stat(tmpDir); err != nil {
+		t.Errorf("期望目录被重新创建: %v", err)
+	}
+
+	// 路径是文件时验证失败
+	filePath := filepath.Join(tmpDir, "file")
+	if err := os.WriteFile(filePath, nil, 0644); err != nil {
+		t.Fatalf("写入文件失败: %v", err)
+	}
+	if err := ValidateOutputDir(filePath); err == nil {
+		t.Error("期望验证失败（路径是文件），但成功了")
+	}
+}
+
+func TestWriteFileAtomic(t *testing.T) {
+	tmpDir, err := os.MkdirTemp("", "atomic_test")
+	if err != nil {
+		t.Fatalf("创建临时目录失败: %v", err)
+	}
+	defer os.RemoveAll(tmpDir)
+
+	path := filepath.Join(tmpDir, "out.docx")
+	for _, content := range []string{"first", "second"} {
+		if err := WriteFileAtomic(path, []byte(content)); err != nil {
+			t.Fatalf("写入文件失败: %v", err)
+		}
+		data, err := os.ReadFile(path)
+		if err != nil || string(data) != content {
+			t.Errorf("期望内容 %q, 实际 %q (%v)", content, data, err)
+		}
+	}
+
+	entries, _ := os.ReadDir(tmpDir)
+	if len(entries) != 1 {
+		t.Errorf("期望只有目标文件, 实际 %d 个文件", len(entries))
+	}
+}
+
 func TestDetermineOutputPath(t *testing.T) {
 	// 测试用例1：指定输出目录和文件名
 	inputFile := "/path/to/input.md"
@@ -9,6 +9,7 @@ TEMPLATE = app
 SOURCES += \
     src/main_complete_test.cpp \
     src/httpapi.cpp \
+    src/localnetworkaccessmanager.cpp \
     src/singleconverter.cpp \
     src/batchconverter.cpp \
     src/configmanager.cpp
@@ -16,6 +17,7 @@ SOURCES += \
 # 头文件
 HEADERS += \
     src/httpapi.h \
+    src/localnetworkaccessmanager.h \
     src/singleconverter.h \
     src/batchconverter.h \
     src/configmanager.h
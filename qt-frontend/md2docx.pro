@@ -19,7 +19,8 @@ SOURCES += \
     src/singleconverter.cpp \
     src/batchconverter.cpp \
     src/configmanager.cpp \
-    src/httpapi.cpp
+    src/httpapi.cpp \
+    src/localnetworkaccessmanager.cpp
 
 # 头文件
 HEADERS += \
@@ -27,7 +28,8 @@ HEADERS += \
     src/singleconverter.h \
     src/batchconverter.h \
     src/configmanager.h \
-    src/httpapi.h
+    src/httpapi.h \
+    src/localnetworkaccessmanager.h
 
 # UI文件 - 使用代码创建UI，不需要.ui文件
 # FORMS += \
@@ -8,11 +8,13 @@ TEMPLATE = app
 # 源文件
 SOURCES += \
     src/main_simple.cpp \
-    src/httpapi.cpp
+    src/httpapi.cpp \
+    src/localnetworkaccessmanager.cpp
 
 # 头文件
 HEADERS += \
-    src/httpapi.h
+    src/httpapi.h \
+    src/localnetworkaccessmanager.h
 
 # 输出目录 - 统一使用 build 目录结构
 CONFIG(debug, debug|release) {
@@ -1,4 +1,4 @@
-QT += core widgets network
+QT += core widgets network concurrent
 
 CONFIG += c++17
 
@@ -17,22 +17,41 @@ DEFINES += APP_VERSION=\\\"$$VERSION\\\"
 SOURCES += \
     src/main_simple_integrated.cpp \
     src/embeddedserver.cpp \
+    src/embeddedserverpool.cpp \
+    src/serverlogbuffer.cpp \
     src/singlefileconverter.cpp \
     src/multifileconverter.cpp \
     src/settingswidget.cpp \
     src/aboutwidget.cpp \
     src/httpapi.cpp \
-    src/appsettings.cpp
+    src/localnetworkaccessmanager.cpp \
+    src/appsettings.cpp \
+    src/nativedocxengine.cpp \
+    src/ziparchive.cpp
 
 # 头文件
 HEADERS += \
     src/embeddedserver.h \
+    src/embeddedserverpool.h \
+    src/serverlogbuffer.h \
     src/singlefileconverter.h \
     src/multifileconverter.h \
     src/settingswidget.h \
     src/aboutwidget.h \
     src/httpapi.h \
-    src/appsettings.h
+    src/localnetworkaccessmanager.h \
+    src/appsettings.h \
+    src/nativedocxengine.h \
+    src/ziparchive.h
+
+# 本地docx引擎使用zlib压缩
+# Windows（MSVC）没有系统zlib，使用Qt自带的zlib（由QtCore导出）
+win32 {
+    QT += core-private
+    DEFINES += MD2DOCX_QT_ZLIB
+} else {
+    LIBS += -lz
+}
 
 # 包含路径
 INCLUDEPATH += src
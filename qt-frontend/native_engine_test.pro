@@ -0,0 +1,44 @@
+QT += core gui testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = native_engine_test
+TEMPLATE = app
+
+# 源文件
+SOURCES += \
+    ../tests/unit/native_docx_engine_test.cpp \
+    src/nativedocxengine.cpp \
+    src/ziparchive.cpp
+
+# 头文件
+HEADERS += \
+    src/nativedocxengine.h \
+    src/ziparchive.h
+
+# 与pandoc逐文件对比的测试数据
+DEFINES += MD2DOCX_TESTDATA_DIR=\\\"$$PWD/../tests/testdata\\\"
+
+# 本地docx引擎使用zlib压缩
+# Windows（MSVC）没有系统zlib，使用Qt自带的zlib（由QtCore导出）
+win32 {
+    QT += core-private
+    DEFINES += MD2DOCX_QT_ZLIB
+} else {
+    LIBS += -lz
+}
+
+INCLUDEPATH += src
+
+# 输出目录 - 统一使用 build 目录结构
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../build/bin
+    OBJECTS_DIR = $$PWD/../build/intermediate/qt/$${TARGET}/debug/obj
+    MOC_DIR = $$PWD/../build/intermediate/qt/$${TARGET}/debug/moc
+} else {
+    DESTDIR = $$PWD/../build/bin
+    OBJECTS_DIR = $$PWD/../build/intermediate/qt/$${TARGET}/release/obj
+    MOC_DIR = $$PWD/../build/intermediate/qt/$${TARGET}/release/moc
+    QMAKE_CXXFLAGS += -O2
+}
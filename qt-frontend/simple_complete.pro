@@ -9,12 +9,14 @@ TEMPLATE = app
 SOURCES += \
     src/main_simple_complete.cpp \
     src/httpapi.cpp \
+    src/localnetworkaccessmanager.cpp \
     src/singleconverter.cpp \
     src/simple_batchconverter.cpp
 
 # 头文件
 HEADERS += \
     src/httpapi.h \
+    src/localnetworkaccessmanager.h \
     src/singleconverter.h \
     src/simple_batchconverter.h
 
@@ -9,11 +9,13 @@ TEMPLATE = app
 SOURCES += \
     src/main_single_test.cpp \
     src/httpapi.cpp \
+    src/localnetworkaccessmanager.cpp \
     src/singleconverter.cpp
 
 # 头文件
 HEADERS += \
     src/httpapi.h \
+    src/localnetworkaccessmanager.h \
     src/singleconverter.h
 
 # 输出目录 - 统一使用 build 目录结构
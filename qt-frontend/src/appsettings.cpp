@@ -17,6 +17,8 @@ const QString AppSettings::KEY_WINDOW_STATE = "window/state";
 const QString AppSettings::KEY_PANDOC_PATH = "pandoc/path";
 const QString AppSettings::KEY_TEMPLATE_FILE = "template/file";
 const QString AppSettings::KEY_USE_TEMPLATE = "template/use";
+const QString AppSettings::KEY_USE_NATIVE_ENGINE = "conversion/nativeEngine";
+const QString AppSettings::KEY_SERVER_POOL_SIZE = "server/poolSize";
 const QString AppSettings::KEY_RECENT_FILES = "files/recent";
 
 AppSettings::AppSettings(QObject *parent) : QObject(parent) {
@@ -129,6 +131,23 @@ void AppSettings::setUseTemplate(bool use) {
   m_settings->setValue(KEY_USE_TEMPLATE, use);
 }
 
+bool AppSettings::getUseNativeEngine() const {
+  // 本地引擎默认关闭，需要在配置中显式开启
+  return m_settings->value(KEY_USE_NATIVE_ENGINE, false).toBool();
+}
+
+void AppSettings::setUseNativeEngine(bool use) {
+  m_settings->setValue(KEY_USE_NATIVE_ENGINE, use);
+}
+
+int AppSettings::getServerPoolSize() const {
+  return m_settings->value(KEY_SERVER_POOL_SIZE, 0).toInt();
+}
+
+void AppSettings::setServerPoolSize(int size) {
+  m_settings->setValue(KEY_SERVER_POOL_SIZE, size);
+}
+
 QStringList AppSettings::getRecentFiles() const {
   return m_settings->value(KEY_RECENT_FILES).toStringList();
 }
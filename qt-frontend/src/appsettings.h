@@ -46,6 +46,14 @@ public:
   bool getUseTemplate() const;
   void setUseTemplate(bool use);
 
+  // 常见Markdown子集使用本地引擎直接生成docx，其余仍交给pandoc
+  bool getUseNativeEngine() const;
+  void setUseNativeEngine(bool use);
+
+  // 内嵌后端进程数，0表示根据CPU核心数自动决定
+  int getServerPoolSize() const;
+  void setServerPoolSize(int size);
+
   // 最近使用的文件
   QStringList getRecentFiles() const;
   void addRecentFile(const QString &file);
@@ -71,6 +79,8 @@ private:
   static const QString KEY_PANDOC_PATH;
   static const QString KEY_TEMPLATE_FILE;
   static const QString KEY_USE_TEMPLATE;
+  static const QString KEY_USE_NATIVE_ENGINE;
+  static const QString KEY_SERVER_POOL_SIZE;
   static const QString KEY_RECENT_FILES;
 };
 
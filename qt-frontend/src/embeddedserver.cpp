@@ -1,34 +1,31 @@
 #include "embeddedserver.h"
+#include "localnetworkaccessmanager.h"
+#include "serverlogbuffer.h"
+
 #include <QApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QNetworkReply>
-#include <QNetworkRequest>
-#include <QRandomGenerator>
 #include <QStandardPaths>
-#include <QTcpSocket>
 
-EmbeddedServer::EmbeddedServer(QObject *parent)
+EmbeddedServer::EmbeddedServer(QObject *parent, int index)
     : QObject(parent), m_serverProcess(nullptr),
-      m_healthCheckTimer(new QTimer(this)),
-      m_networkManager(new QNetworkAccessManager(this)), m_serverPort(8080),
-      m_serverRunning(false), m_serverHealthy(false) {
-  // 首先尝试从配置文件读取端口
-  loadPortFromConfig();
-
-  // 如果配置文件中没有端口或端口不可用，查找可用端口
-  if (m_serverPort == 0 || !isPortAvailable(m_serverPort)) {
-    findAvailablePort();
-  }
-
-  m_serverUrl = QString("http://localhost:%1").arg(m_serverPort);
+      m_heartbeatTimer(new QTimer(this)), m_index(index), m_serverPort(0),
+      m_workerLimit(0), m_serverRunning(false), m_serverReady(false),
+      m_serverHealthy(false), m_pingSequence(0), m_logBuffer(nullptr) {
+#ifdef Q_OS_UNIX
+  // 类Unix系统上通过Unix域套接字通信，无需探测端口，也不会与其他程序冲突
+  m_socketPath = QDir(QDir::tempPath())
+                     .absoluteFilePath(QString("md2docx-%1-%2.sock")
+                                           .arg(QApplication::applicationPid())
+                                           .arg(index));
+  m_serverUrl = LocalNetworkAccessManager::serverUrlForSocket(m_socketPath);
+#endif
+  // 其他系统由服务器监听系统分配的端口，地址在收到READY行后确定
 
-  // 设置健康检查定时器
-  setupHealthCheckTimer();
+  // 设置心跳超时定时器
+  setupHeartbeatTimer();
 }
 
 EmbeddedServer::~EmbeddedServer() { stopServer(); }
@@ -46,14 +43,20 @@ bool EmbeddedServer::startServer() {
   }
 
   qDebug() << "启动嵌入式服务器:" << serverPath;
-  qDebug() << "服务器端口:" << m_serverPort;
+  if (!m_socketPath.isEmpty()) {
+    qDebug() << "服务器套接字:" << m_socketPath;
+  }
 
   // 创建服务器进程
   m_serverProcess = new QProcess(this);
 
   // 连接信号
   connect(m_serverProcess, &QProcess::started, this,
-          &EmbeddedServer::onServerStarted);
+          &EmbeddedServer::onProcessStarted);
+  connect(m_serverProcess, &QProcess::readyReadStandardOutput, this,
+          &EmbeddedServer::onServerOutput);
+  connect(m_serverProcess, &QProcess::readyReadStandardError, this,
+          &EmbeddedServer::onServerErrorOutput);
   connect(m_serverProcess,
           QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
           &EmbeddedServer::onServerFinished);
@@ -62,7 +65,18 @@ bool EmbeddedServer::startServer() {
 
   // 设置环境变量
   QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-  env.insert("SERVER_PORT", QString::number(m_serverPort));
+  env.insert("MD2DOCX_HEARTBEAT", "1");
+  // 进程池中的后端各自使用独立的输出缓存和历史耗时文件
+  env.insert("MD2DOCX_INSTANCE", QString::number(m_index));
+  if (m_workerLimit > 0) {
+    env.insert("MD2DOCX_MAX_WORKERS", QString::number(m_workerLimit));
+  }
+  if (m_socketPath.isEmpty()) {
+    // 端口为0时由系统分配，避免启动前探测端口
+    env.insert("SERVER_PORT", "0");
+  } else {
+    env.insert("MD2DOCX_SOCKET", m_socketPath);
+  }
   m_serverProcess->setProcessEnvironment(env);
 
   // 启动服务器
@@ -85,8 +99,12 @@ bool EmbeddedServer::startServer() {
     return false;
   }
 
-  // 等待服务器就绪
-  QTimer::singleShot(2000, this, &EmbeddedServer::performHealthCheck);
+  // 服务器监听成功后会输出READY行，超时未收到则报错
+  QTimer::singleShot(STARTUP_TIMEOUT, this, [this]() {
+    if (m_serverRunning && !m_serverReady) {
+      emit serverError("服务器启动超时，未收到就绪通知");
+    }
+  });
 
   return true;
 }
@@ -98,36 +116,170 @@ void EmbeddedServer::stopServer() {
 
   qDebug() << "停止嵌入式服务器";
 
-  // 停止健康检查
-  m_healthCheckTimer->stop();
+  // 停止心跳
+  m_heartbeatTimer->stop();
+
+  // 主动停止时由这里统一清理，不再经过onServerFinished
+  disconnect(m_serverProcess, nullptr, this, nullptr);
 
-  // 优雅关闭服务器
-  m_serverProcess->terminate();
+  // 优雅关闭服务器：关闭标准输入后服务器会等待进行中的请求完成再退出
+  m_serverProcess->closeWriteChannel();
+  if (!m_serverProcess->waitForFinished(3000)) {
+    m_serverProcess->terminate();
+  }
   if (!m_serverProcess->waitForFinished(5000)) {
     qDebug() << "强制关闭服务器";
     m_serverProcess->kill();
     m_serverProcess->waitForFinished(2000);
   }
 
+  // 信号已断开，退出前最后的输出在这里读出
+  flushOutput();
   delete m_serverProcess;
   m_serverProcess = nullptr;
 
+  // 服务器被强制结束时不会删除套接字文件
+  if (!m_socketPath.isEmpty()) {
+    QFile::remove(m_socketPath);
+  }
+
   m_serverRunning = false;
+  m_serverReady = false;
   m_serverHealthy = false;
+  m_serverState.clear();
 
   emit serverStopped();
 }
 
-void EmbeddedServer::checkHealth() { performHealthCheck(); }
+void EmbeddedServer::checkHealth() {
+  if (!m_serverRunning || !m_serverReady || !m_serverProcess) {
+    return;
+  }
+
+  // 上一次PING尚未得到响应时不重复发送
+  if (m_heartbeatTimer->isActive()) {
+    return;
+  }
+
+  ++m_pingSequence;
+  m_serverProcess->write(QString("PING %1\n").arg(m_pingSequence).toUtf8());
+  m_heartbeatTimer->start();
+}
 
-void EmbeddedServer::onServerStarted() {
-  qDebug() << "服务器进程已启动";
+void EmbeddedServer::onProcessStarted() {
+  qDebug() << "服务器进程已启动，等待就绪通知";
   m_serverRunning = true;
+  m_serverReady = false;
+  m_stdoutBuffer.clear();
+  m_stderrBuffer.clear();
+}
+
+void EmbeddedServer::onServerOutput() {
+  if (!m_serverProcess) {
+    return;
+  }
+
+  m_stdoutBuffer += m_serverProcess->readAllStandardOutput();
+
+  int newline;
+  while ((newline = m_stdoutBuffer.indexOf('\n')) >= 0) {
+    QByteArray line = m_stdoutBuffer.left(newline).trimmed();
+    m_stdoutBuffer.remove(0, newline + 1);
+
+    if (!m_serverReady && parseReadyLine(line)) {
+      m_serverReady = true;
+      qDebug() << "服务器已就绪:" << m_serverUrl;
+      emit serverStarted();
+    } else if (!m_serverReady || !parseHeartbeatLine(line)) {
+      appendLog(false, line);
+    }
+  }
+
+  // 防止没有换行的输出无限累积，过长的部分作为单独一行记录
+  if (m_stdoutBuffer.size() > MAX_LINE_LENGTH) {
+    appendLog(false, m_stdoutBuffer.left(MAX_LINE_LENGTH));
+    m_stdoutBuffer.clear();
+  }
+}
+
+void EmbeddedServer::onServerErrorOutput() {
+  if (!m_serverProcess) {
+    return;
+  }
+  drainErrorOutput(m_serverProcess->readAllStandardError());
+}
+
+void EmbeddedServer::drainErrorOutput(const QByteArray &data) {
+  m_stderrBuffer += data;
+
+  int newline;
+  while ((newline = m_stderrBuffer.indexOf('\n')) >= 0) {
+    appendLog(true, m_stderrBuffer.left(newline));
+    m_stderrBuffer.remove(0, newline + 1);
+  }
+
+  if (m_stderrBuffer.size() > MAX_LINE_LENGTH) {
+    appendLog(true, m_stderrBuffer.left(MAX_LINE_LENGTH));
+    m_stderrBuffer.clear();
+  }
+}
+
+void EmbeddedServer::flushOutput() {
+  if (m_serverProcess) {
+    // 进程已退出，标准输出中不会再有需要处理的协议行
+    m_stdoutBuffer += m_serverProcess->readAllStandardOutput();
+    drainErrorOutput(m_serverProcess->readAllStandardError());
+  }
 
-  // 开始健康检查
-  m_healthCheckTimer->start();
+  for (const QByteArray &line : m_stdoutBuffer.split('\n')) {
+    appendLog(false, line);
+  }
+  appendLog(true, m_stderrBuffer);
+  m_stdoutBuffer.clear();
+  m_stderrBuffer.clear();
+}
 
-  emit serverStarted();
+void EmbeddedServer::appendLog(bool isStderr, const QByteArray &line) {
+  if (!m_logBuffer || line.trimmed().isEmpty()) {
+    return;
+  }
+  m_logBuffer->append(m_index,
+                      isStderr ? ServerLogEntry::Stderr : ServerLogEntry::Stdout,
+                      line.left(MAX_LINE_LENGTH));
+}
+
+bool EmbeddedServer::parseReadyLine(const QByteArray &line) {
+  // 格式: READY port=<端口> pid=<进程号> 或 READY socket=<路径> pid=<进程号>
+  if (!line.startsWith("READY ")) {
+    return false;
+  }
+
+  int port = 0;
+  QString socketPath;
+  const QList<QByteArray> fields = line.mid(6).split(' ');
+  for (const QByteArray &field : fields) {
+    int eq = field.indexOf('=');
+    if (eq <= 0) {
+      continue;
+    }
+    QByteArray key = field.left(eq);
+    QByteArray value = field.mid(eq + 1);
+    if (key == "port") {
+      port = value.toInt();
+    } else if (key == "socket") {
+      socketPath = QString::fromUtf8(value);
+    }
+  }
+
+  if (!m_socketPath.isEmpty()) {
+    return socketPath == m_socketPath;
+  }
+  if (port <= 0 || port > 65535) {
+    return false;
+  }
+  m_serverPort = port;
+  m_serverUrl = QString("http://localhost:%1").arg(m_serverPort);
+  return true;
 }
 
 void EmbeddedServer::onServerFinished(int exitCode,
@@ -135,11 +287,17 @@ void EmbeddedServer::onServerFinished(int exitCode,
   qDebug() << "服务器进程结束，退出代码:" << exitCode << "状态:" << exitStatus;
 
   m_serverRunning = false;
+  m_serverReady = false;
   m_serverHealthy = false;
-  m_healthCheckTimer->stop();
+  m_serverState.clear();
+  m_heartbeatTimer->stop();
+
+  // 崩溃时的panic信息可能还留在缓冲中
+  flushOutput();
 
+  // 当前仍在该进程的信号处理中，不能立即删除
   if (m_serverProcess) {
-    delete m_serverProcess;
+    m_serverProcess->deleteLater();
     m_serverProcess = nullptr;
   }
 
@@ -177,56 +335,58 @@ void EmbeddedServer::onServerError(QProcess::ProcessError error) {
   emit serverError(errorString);
 }
 
-void EmbeddedServer::onHealthCheckFinished() {
-  QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
-  if (!reply)
-    return;
+bool EmbeddedServer::parseHeartbeatLine(const QByteArray &line) {
+  // 格式: STATE <状态> [说明] 或 PONG <序号> <状态>，其他行返回false
+  if (line.startsWith("STATE ")) {
+    QByteArray rest = line.mid(6);
+    int space = rest.indexOf(' ');
+    QString state = QString::fromUtf8(space < 0 ? rest : rest.left(space));
+    QString detail =
+        space < 0 ? QString() : QString::fromUtf8(rest.mid(space + 1));
+    updateServerState(state, detail);
+  } else if (line.startsWith("PONG ")) {
+    const QList<QByteArray> fields = line.split(' ');
+    if (fields.size() < 2 || fields.at(1).toInt() != m_pingSequence) {
+      return true;
+    }
+    m_heartbeatTimer->stop();
+    if (fields.size() >= 3) {
+      updateServerState(QString::fromUtf8(fields.at(2)), m_stateDetail);
+    }
+    setHealthy(isHealthyState(m_serverState));
+  } else {
+    return false;
+  }
+  return true;
+}
 
-  bool isHealthy = (reply->error() == QNetworkReply::NoError);
+void EmbeddedServer::updateServerState(const QString &state,
+                                       const QString &detail) {
+  if (state != m_serverState || detail != m_stateDetail) {
+    m_serverState = state;
+    m_stateDetail = detail;
+    qDebug() << "服务器状态变化:" << state << detail;
+    emit serverStateChanged(state, detail);
+  }
+  setHealthy(isHealthyState(state));
+}
 
+void EmbeddedServer::setHealthy(bool isHealthy) {
   if (isHealthy != m_serverHealthy) {
     m_serverHealthy = isHealthy;
     qDebug() << "服务器健康状态变化:" << (isHealthy ? "健康" : "不健康");
     emit healthCheckResult(isHealthy);
   }
-
-  reply->deleteLater();
 }
 
-void EmbeddedServer::performHealthCheck() {
-  if (!m_serverRunning) {
-    return;
-  }
-
-  QNetworkRequest request(QUrl(m_serverUrl + "/api/health"));
-  request.setRawHeader("User-Agent", "EmbeddedServer/1.0");
-  // request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
-  // QNetworkRequest::NoRedirectPolicy); // Qt 5.15兼容性
-
-  QNetworkReply *reply = m_networkManager->get(request);
-  connect(reply, &QNetworkReply::finished, this,
-          &EmbeddedServer::onHealthCheckFinished);
-
-  // 设置超时
-  QTimer::singleShot(HEALTH_CHECK_TIMEOUT, reply, &QNetworkReply::abort);
+bool EmbeddedServer::isHealthyState(const QString &state) {
+  // 过载时仍能处理请求，只是需要排队
+  return state == "ok" || state == "overloaded";
 }
 
-void EmbeddedServer::findAvailablePort() {
-  // 尝试从8080开始找可用端口
-  for (int port = 8080; port <= 8090; ++port) {
-    QTcpSocket socket;
-    socket.connectToHost("localhost", port);
-    if (!socket.waitForConnected(100)) {
-      m_serverPort = port;
-      qDebug() << "找到可用端口:" << port;
-      return;
-    }
-    socket.disconnectFromHost();
-  }
-
-  // 如果都不可用，使用随机端口
-  m_serverPort = 8080 + QRandomGenerator::global()->bounded(1000);
-  qDebug() << "使用随机端口:" << m_serverPort;
+void EmbeddedServer::onHeartbeatTimeout() {
+  qDebug() << "服务器心跳超时";
+  setHealthy(false);
 }
 
 QString EmbeddedServer::getServerExecutablePath() {
@@ -273,89 +433,9 @@ QString EmbeddedServer::getServerExecutablePath() {
   return QString();
 }
 
-void EmbeddedServer::setupHealthCheckTimer() {
-  m_healthCheckTimer->setInterval(HEALTH_CHECK_INTERVAL);
-  m_healthCheckTimer->setSingleShot(false);
-  connect(m_healthCheckTimer, &QTimer::timeout, this,
-          &EmbeddedServer::performHealthCheck);
-}
-
-void EmbeddedServer::loadPortFromConfig() {
-  // 获取配置文件路径
-  QString configPath = getConfigFilePath();
-
-  QFileInfo configFile(configPath);
-  if (!configFile.exists()) {
-    qDebug() << "配置文件不存在，使用默认端口:" << configPath;
-    return;
-  }
-
-  // 读取配置文件
-  QFile file(configPath);
-  if (!file.open(QIODevice::ReadOnly)) {
-    qDebug() << "无法读取配置文件:" << configPath;
-    return;
-  }
-
-  QByteArray data = file.readAll();
-  file.close();
-
-  // 解析JSON
-  QJsonParseError error;
-  QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-  if (error.error != QJsonParseError::NoError) {
-    qDebug() << "配置文件JSON解析失败:" << error.errorString();
-    return;
-  }
-
-  QJsonObject config = doc.object();
-  if (config.contains("server_port")) {
-    int port = config["server_port"].toInt();
-    if (port > 0 && port <= 65535) {
-      m_serverPort = port;
-      qDebug() << "从配置文件读取端口:" << port;
-    }
-  }
-}
-
-QString EmbeddedServer::getConfigFilePath() {
-  QString appDir = QApplication::applicationDirPath();
-
-  // 尝试多个可能的配置文件位置
-  QStringList possiblePaths;
-
-  // 1. 与可执行文件在同一目录（应用包内）
-  possiblePaths << appDir + "/config.json";
-
-  // 2. 项目根目录（开发模式）
-  possiblePaths << appDir + "/../../../config.json";
-  possiblePaths << appDir + "/../../config.json";
-  possiblePaths << appDir + "/../config.json";
-
-  // 3. build目录（后端运行位置）
-  possiblePaths << appDir + "/../../../build/config.json";
-  possiblePaths << appDir + "/../../build/config.json";
-  possiblePaths << appDir + "/../build/config.json";
-
-  // 查找第一个存在的配置文件
-  for (const QString &path : possiblePaths) {
-    QFileInfo fileInfo(path);
-    if (fileInfo.exists()) {
-      qDebug() << "找到配置文件:" << fileInfo.absoluteFilePath();
-      return fileInfo.absoluteFilePath();
-    }
-  }
-
-  // 如果都不存在，返回默认路径（应用包内）
-  QString defaultPath = appDir + "/config.json";
-  qDebug() << "使用默认配置文件路径:" << defaultPath;
-  return defaultPath;
-}
-
-bool EmbeddedServer::isPortAvailable(int port) {
-  QTcpSocket socket;
-  socket.connectToHost("localhost", port);
-  bool available = !socket.waitForConnected(100);
-  socket.disconnectFromHost();
-  return available;
+void EmbeddedServer::setupHeartbeatTimer() {
+  m_heartbeatTimer->setInterval(HEARTBEAT_TIMEOUT);
+  m_heartbeatTimer->setSingleShot(true);
+  connect(m_heartbeatTimer, &QTimer::timeout, this,
+          &EmbeddedServer::onHeartbeatTimeout);
 }
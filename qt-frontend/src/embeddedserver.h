@@ -1,33 +1,55 @@
 #ifndef EMBEDDEDSERVER_H
 #define EMBEDDEDSERVER_H
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QObject>
 #include <QProcess>
 #include <QTimer>
 
+class ServerLogBuffer;
+
 /**
  * 嵌入式服务器类
  * 在Qt应用内部启动Go后端服务，实现单一程序运行
+ *
+ * 服务器通过标准输出推送状态变化（STATE行），不再定时轮询健康检查接口；
+ * 进程退出由QProcess立即通知，需要确认服务器仍在响应时调用checkHealth，
+ * 通过标准输入发送PING，1秒内未收到PONG即视为不健康。
+ *
+ * 标准输出和标准错误在有数据时立即读出，协议行之外的输出写入日志缓冲区，
+ * 避免QProcess内部缓冲随服务器的输出无限增长。
  */
 class EmbeddedServer : public QObject {
   Q_OBJECT
 
 public:
-  explicit EmbeddedServer(QObject *parent = nullptr);
+  // index区分同一程序启动的多个后端进程
+  explicit EmbeddedServer(QObject *parent = nullptr, int index = 0);
   ~EmbeddedServer();
 
+  // 后端使用的并发数上限，0表示由服务器决定（需在startServer之前设置）
+  void setWorkerLimit(int workers) { m_workerLimit = workers; }
+
+  // 服务器日志写入的缓冲区，未设置时读出后直接丢弃
+  void setLogBuffer(ServerLogBuffer *buffer) { m_logBuffer = buffer; }
+  ServerLogBuffer *logBuffer() const { return m_logBuffer; }
+
   // 服务器控制
   bool startServer();
   void stopServer();
   bool isRunning() const { return m_serverRunning; }
+  bool isReady() const { return m_serverReady; }
+  bool isHealthy() const { return m_serverHealthy; }
 
   // 服务器信息
   QString serverUrl() const { return m_serverUrl; }
   int serverPort() const { return m_serverPort; }
+  QString socketPath() const { return m_socketPath; }
+
+  // 服务器推送的状态: ok、pandoc_missing、overloaded、draining
+  QString serverState() const { return m_serverState; }
+  QString serverStateDetail() const { return m_stateDetail; }
 
-  // 健康检查
+  // 健康检查：通过心跳通道确认服务器仍在响应
   void checkHealth();
 
 signals:
@@ -35,35 +57,50 @@ signals:
   void serverStopped();
   void serverError(const QString &error);
   void healthCheckResult(bool isHealthy);
+  void serverStateChanged(const QString &state, const QString &detail);
 
 private slots:
-  void onServerStarted();
+  void onProcessStarted();
+  void onServerOutput();
+  void onServerErrorOutput();
   void onServerFinished(int exitCode, QProcess::ExitStatus exitStatus);
   void onServerError(QProcess::ProcessError error);
-  void onHealthCheckFinished();
-  void performHealthCheck();
+  void onHeartbeatTimeout();
 
 private:
-  void findAvailablePort();
   QString getServerExecutablePath();
-  void setupHealthCheckTimer();
-  void loadPortFromConfig();
-  QString getConfigFilePath();
-  bool isPortAvailable(int port);
+  void setupHeartbeatTimer();
+  bool parseReadyLine(const QByteArray &line);
+  bool parseHeartbeatLine(const QByteArray &line);
+  void drainErrorOutput(const QByteArray &data);
+  void flushOutput(); // 读出剩余输出，未成行的部分也写入日志
+  void appendLog(bool isStderr, const QByteArray &line);
+  void updateServerState(const QString &state, const QString &detail);
+  void setHealthy(bool isHealthy);
+  static bool isHealthyState(const QString &state);
 
   QProcess *m_serverProcess;
-  QTimer *m_healthCheckTimer;
-  QNetworkAccessManager *m_networkManager;
+  QTimer *m_heartbeatTimer; // 等待PONG的超时定时器
 
   QString m_serverUrl;
+  int m_index; // 在进程池中的序号，用于区分日志来源
   int m_serverPort;
+  QString m_socketPath; // 非空时通过Unix域套接字通信，不占用TCP端口
+  int m_workerLimit;
   bool m_serverRunning;
+  bool m_serverReady; // 已收到服务器的READY行
   bool m_serverHealthy;
+  QString m_serverState;
+  QString m_stateDetail;
+  int m_pingSequence;
+  QByteArray m_stdoutBuffer; // 尚未成行的标准输出
+  QByteArray m_stderrBuffer; // 尚未成行的标准错误输出
+  ServerLogBuffer *m_logBuffer;
 
-  // 健康检查配置
-  static const int HEALTH_CHECK_INTERVAL = 5000; // 5秒
-  static const int STARTUP_TIMEOUT = 10000;      // 10秒启动超时
-  static const int HEALTH_CHECK_TIMEOUT = 3000;  // 3秒健康检查超时
+  // 服务器配置
+  static const int STARTUP_TIMEOUT = 10000;  // 10秒启动超时
+  static const int MAX_LINE_LENGTH = 4096;   // 输出单行长度上限
+  static const int HEARTBEAT_TIMEOUT = 1000; // 1秒内未收到PONG视为不健康
 };
 
 #endif // EMBEDDEDSERVER_H
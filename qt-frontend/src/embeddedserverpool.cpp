@@ -0,0 +1,303 @@
+#include "embeddedserverpool.h"
+#include "embeddedserver.h"
+#include "serverlogbuffer.h"
+
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+
+EmbeddedServerPool::EmbeddedServerPool(int size, QObject *parent)
+    : QObject(parent), m_logBuffer(new ServerLogBuffer(
+                           ServerLogBuffer::DEFAULT_CAPACITY, this)),
+      m_started(false), m_stopping(false), m_healthy(false),
+      m_loadCheckTimer(new QTimer(this)) {
+  m_loadCheckTimer->setInterval(LOAD_CHECK_INTERVAL);
+  connect(m_loadCheckTimer, &QTimer::timeout, this,
+          &EmbeddedServerPool::onLoadCheckTimeout);
+
+  if (size <= 0) {
+    size = defaultPoolSize();
+  }
+
+  // 每个后端只使用分到的核心，避免多个进程同时占满CPU
+  int workers = qMax(1, QThread::idealThreadCount() / size);
+
+  for (int i = 0; i < size; ++i) {
+    EmbeddedServer *server = new EmbeddedServer(this, i);
+    server->setLogBuffer(m_logBuffer);
+    if (size > 1) {
+      server->setWorkerLimit(workers);
+    }
+
+    connect(server, &EmbeddedServer::serverStarted, this,
+            &EmbeddedServerPool::onBackendStarted);
+    connect(server, &EmbeddedServer::serverStopped, this,
+            &EmbeddedServerPool::onBackendStopped);
+    connect(server, &EmbeddedServer::serverError, this,
+            &EmbeddedServerPool::onBackendError);
+    connect(server, &EmbeddedServer::healthCheckResult, this,
+            &EmbeddedServerPool::onBackendHealthChanged);
+    connect(server, &EmbeddedServer::serverStateChanged, this,
+            &EmbeddedServerPool::onBackendStateChanged);
+
+    m_servers.append(server);
+    m_restartCounts.append(0);
+  }
+
+  qDebug() << "嵌入式服务器进程数:" << size << "每个进程并发数:" << workers;
+}
+
+EmbeddedServerPool::~EmbeddedServerPool() { stopServer(); }
+
+bool EmbeddedServerPool::startServer() {
+  m_stopping = false;
+
+  bool anyStarted = false;
+  for (EmbeddedServer *server : m_servers) {
+    if (server->startServer()) {
+      anyStarted = true;
+    }
+  }
+  return anyStarted;
+}
+
+void EmbeddedServerPool::stopServer() {
+  m_stopping = true;
+  for (EmbeddedServer *server : m_servers) {
+    server->stopServer();
+  }
+  m_started = false;
+  m_healthy = false;
+  m_urls.clear();
+  m_outstanding.clear();
+  m_loadCheckTimer->stop();
+}
+
+bool EmbeddedServerPool::isRunning() const {
+  for (EmbeddedServer *server : m_servers) {
+    if (server->isRunning()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+QString EmbeddedServerPool::serverUrl() const {
+  QStringList urls = serverUrls();
+  return urls.isEmpty() ? QString() : urls.first();
+}
+
+QStringList EmbeddedServerPool::serverUrls() const {
+  // 心跳超时、缺少pandoc或正在停止的后端不再分配请求，恢复后重新加入
+  QStringList urls;
+  for (EmbeddedServer *server : m_servers) {
+    if (isRoutable(server)) {
+      urls.append(server->serverUrl());
+    }
+  }
+  return urls;
+}
+
+bool EmbeddedServerPool::isRoutable(const EmbeddedServer *server) {
+  if (!server->isReady()) {
+    return false;
+  }
+  // 刚就绪、尚未推送状态的后端照常使用，收到状态后按健康状态决定
+  return server->isHealthy() || server->serverState().isEmpty();
+}
+
+bool EmbeddedServerPool::hasReadyBackend() const {
+  for (EmbeddedServer *server : m_servers) {
+    if (server->isReady()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void EmbeddedServerPool::checkHealth() {
+  for (EmbeddedServer *server : m_servers) {
+    server->checkHealth();
+  }
+}
+
+void EmbeddedServerPool::onBackendLoadChanged(const QString &url,
+                                              int outstanding) {
+  int previous = m_outstanding.value(url);
+  if (outstanding > 0) {
+    m_outstanding.insert(url, outstanding);
+  } else {
+    m_outstanding.remove(url);
+  }
+
+  // 新请求发出时确认该后端仍在响应
+  if (outstanding > previous) {
+    if (EmbeddedServer *server = backendForUrl(url)) {
+      server->checkHealth();
+    }
+  }
+
+  if (m_outstanding.isEmpty()) {
+    m_loadCheckTimer->stop();
+  } else if (!m_loadCheckTimer->isActive()) {
+    m_loadCheckTimer->start();
+  }
+}
+
+void EmbeddedServerPool::onLoadCheckTimeout() {
+  // 只检查有未完成请求的后端，卡住的后端在1秒内被发现
+  for (auto it = m_outstanding.constBegin(); it != m_outstanding.constEnd();
+       ++it) {
+    if (EmbeddedServer *server = backendForUrl(it.key())) {
+      server->checkHealth();
+    }
+  }
+}
+
+EmbeddedServer *EmbeddedServerPool::backendForUrl(const QString &url) const {
+  for (EmbeddedServer *server : m_servers) {
+    if (server->serverUrl() == url) {
+      return server;
+    }
+  }
+  return nullptr;
+}
+
+void EmbeddedServerPool::onBackendStarted() {
+  EmbeddedServer *server = qobject_cast<EmbeddedServer *>(sender());
+  int index = m_servers.indexOf(server);
+  if (index >= 0) {
+    m_restartCounts[index] = 0;
+  }
+
+  updateUrls();
+
+  if (!m_started) {
+    m_started = true;
+    emit serverStarted();
+  }
+}
+
+void EmbeddedServerPool::onBackendStopped() {
+  if (m_stopping) {
+    return;
+  }
+
+  EmbeddedServer *server = qobject_cast<EmbeddedServer *>(sender());
+  if (!server) {
+    return;
+  }
+
+  // 其他后端继续工作，HttpApi不再向该后端发送请求
+  updateUrls();
+  updateHealth();
+  updateServerState();
+
+  if (!hasReadyBackend() && m_started) {
+    m_started = false;
+    emit serverStopped();
+  }
+
+  restartBackend(server);
+}
+
+void EmbeddedServerPool::onBackendError(const QString &error) {
+  // 还有其他后端可用时只记录日志，由自动重启恢复
+  if (!serverUrls().isEmpty()) {
+    qDebug() << "后端进程错误:" << error;
+    return;
+  }
+  emit serverError(error);
+}
+
+void EmbeddedServerPool::onBackendHealthChanged() {
+  updateUrls();
+  updateHealth();
+}
+
+void EmbeddedServerPool::onBackendStateChanged() {
+  updateUrls();
+  updateHealth();
+  updateServerState();
+}
+
+void EmbeddedServerPool::updateUrls() {
+  // 健康状态和推送的状态都会改变可用地址，只在列表变化时通知
+  QStringList urls = serverUrls();
+  if (urls != m_urls) {
+    m_urls = urls;
+    emit serverUrlsChanged(urls);
+  }
+}
+
+int EmbeddedServerPool::defaultPoolSize() {
+  int cores = QThread::idealThreadCount();
+  return qBound(1, cores / CORES_PER_BACKEND, int(MAX_AUTO_POOL_SIZE));
+}
+
+void EmbeddedServerPool::restartBackend(EmbeddedServer *server) {
+  int index = m_servers.indexOf(server);
+  if (index < 0) {
+    return;
+  }
+
+  if (m_restartCounts.at(index) >= MAX_RESTARTS) {
+    qDebug() << "后端进程" << index << "连续重启失败，不再重启";
+    if (!isRunning()) {
+      emit serverError("所有后端进程均已退出");
+    }
+    return;
+  }
+  ++m_restartCounts[index];
+
+  QTimer::singleShot(RESTART_DELAY, this, [this, server, index]() {
+    if (m_stopping || server->isRunning()) {
+      return;
+    }
+    qDebug() << "重启后端进程" << index;
+    server->startServer();
+  });
+}
+
+void EmbeddedServerPool::updateHealth() {
+  // 任一后端健康即可继续处理请求
+  bool healthy = false;
+  for (EmbeddedServer *server : m_servers) {
+    if (server->isReady() && server->isHealthy()) {
+      healthy = true;
+      break;
+    }
+  }
+
+  if (healthy != m_healthy) {
+    m_healthy = healthy;
+    emit healthCheckResult(healthy);
+  }
+}
+
+void EmbeddedServerPool::updateServerState() {
+  // 按优先级汇总：有后端正常工作时用户无需处理；
+  // 否则依次为繁忙、缺少pandoc、正在停止
+  static const char *const priority[] = {"ok", "overloaded", "pandoc_missing",
+                                         "draining"};
+  QString state;
+  QString detail;
+  for (const char *candidate : priority) {
+    for (EmbeddedServer *server : m_servers) {
+      if (server->isRunning() && server->serverState() == candidate) {
+        state = server->serverState();
+        detail = server->serverStateDetail();
+        break;
+      }
+    }
+    if (!state.isEmpty()) {
+      break;
+    }
+  }
+
+  if (state != m_serverState || detail != m_stateDetail) {
+    m_serverState = state;
+    m_stateDetail = detail;
+    emit serverStateChanged(state, detail);
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef EMBEDDEDSERVERPOOL_H
+#define EMBEDDEDSERVERPOOL_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class EmbeddedServer;
+class ServerLogBuffer;
+class QTimer;
+
+/**
+ * 嵌入式服务器进程池
+ * 启动多个Go后端进程并分摊CPU，对外提供与EmbeddedServer相同的信号。
+ * 任一后端就绪即视为服务器启动；单个后端异常退出时自动重启，
+ * 可用地址列表通过serverUrlsChanged通知HttpApi：心跳超时或推送了
+ * pandoc_missing、draining状态的后端不在列表中，恢复后重新加入。
+ * 所有后端的输出写入同一个日志缓冲区，重启前后的日志也保留在一起。
+ *
+ * 心跳只在有转换请求时发送：请求发往某个后端时向其发送PING，
+ * 请求未完成期间每秒再检查一次，空闲时不做任何工作。
+ */
+class EmbeddedServerPool : public QObject {
+  Q_OBJECT
+
+public:
+  // size为0时根据CPU核心数自动决定进程数
+  explicit EmbeddedServerPool(int size = 0, QObject *parent = nullptr);
+  ~EmbeddedServerPool();
+
+  // 服务器控制
+  bool startServer();
+  void stopServer();
+  bool isRunning() const;
+
+  // 服务器信息
+  QString serverUrl() const;      // 第一个就绪后端的地址
+  QStringList serverUrls() const; // 所有可以接收请求的后端地址
+  int size() const { return m_servers.size(); }
+  ServerLogBuffer *logBuffer() const { return m_logBuffer; }
+
+  // 健康检查：通过每个后端的心跳通道确认
+  void checkHealth();
+
+  // 各后端推送的状态汇总：任一后端为ok即为ok，否则取最需要用户处理的状态
+  QString serverState() const { return m_serverState; }
+  QString serverStateDetail() const { return m_stateDetail; }
+
+public slots:
+  // HttpApi中某个后端的未完成请求数变化，用于决定何时发送心跳
+  void onBackendLoadChanged(const QString &url, int outstanding);
+
+signals:
+  void serverStarted();
+  void serverStopped();
+  void serverError(const QString &error);
+  void healthCheckResult(bool isHealthy);
+  void serverUrlsChanged(const QStringList &urls);
+  void serverStateChanged(const QString &state, const QString &detail);
+
+private slots:
+  void onBackendStarted();
+  void onBackendStopped();
+  void onBackendError(const QString &error);
+  void onBackendHealthChanged();
+  void onBackendStateChanged();
+  void onLoadCheckTimeout();
+
+private:
+  static int defaultPoolSize();
+  void restartBackend(EmbeddedServer *server);
+  void updateHealth();
+  void updateServerState();
+  void updateUrls();
+  bool hasReadyBackend() const;
+  static bool isRoutable(const EmbeddedServer *server);
+  EmbeddedServer *backendForUrl(const QString &url) const;
+
+  QList<EmbeddedServer *> m_servers;
+  QList<int> m_restartCounts; // 每个后端连续重启的次数
+  ServerLogBuffer *m_logBuffer;
+  bool m_started;             // 已有后端就绪
+  bool m_stopping;
+  bool m_healthy;
+  QStringList m_urls; // 最近一次通知的可用地址
+  QString m_serverState;
+  QString m_stateDetail;
+  QHash<QString, int> m_outstanding; // 各后端地址的未完成请求数
+  QTimer *m_loadCheckTimer;          // 有未完成请求时每秒检查一次心跳
+
+  static const int MAX_AUTO_POOL_SIZE = 4;  // 自动模式下最多启动的进程数
+  static const int CORES_PER_BACKEND = 16;  // 自动模式下每个进程分到的核心数
+  static const int MAX_RESTARTS = 5;        // 连续重启超过该次数后放弃
+  static const int RESTART_DELAY = 1000;    // 重启前等待1秒
+  static const int LOAD_CHECK_INTERVAL = 1000; // 请求未完成超过1秒时再次发送心跳
+};
+
+#endif // EMBEDDEDSERVERPOOL_H
@@ -1,5 +1,7 @@
 #include "httpapi.h"
+#include "localnetworkaccessmanager.h"
 
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -10,24 +12,104 @@
 #include <QJsonParseError>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QRandomGenerator>
 #include <QStandardPaths>
 #include <QTimer>
 #include <QUrl>
 
+#include <climits>
+
 HttpApi::HttpApi(QObject *parent)
-    : QObject(parent), m_networkManager(new QNetworkAccessManager(this)),
+    : QObject(parent), m_networkManager(new LocalNetworkAccessManager(this)),
       m_serverUrl("http://localhost:8080"), m_serverOnline(false),
-      m_timeoutTimer(new QTimer(this)) {
-  m_timeoutTimer->setSingleShot(true);
-  m_timeoutTimer->setInterval(REQUEST_TIMEOUT);
-
+      m_nextRequestId(0), m_pendingConfigUpdates(0) {
   // 尝试从配置文件读取服务器端口
   loadServerPortFromConfig();
+  setServerUrl(m_serverUrl);
+}
+
+HttpApi::~HttpApi() {
+  // 中止未完成的转换请求，服务器随之结束对应的pandoc进程
+  QList<QNetworkReply *> replies = m_singleRequests.keys();
+  replies += m_batchParts.keys();
+  for (QNetworkReply *reply : replies) {
+    reply->disconnect(this);
+    reply->abort();
+  }
 }
 
-HttpApi::~HttpApi() {}
+void HttpApi::setServerUrl(const QString &url) {
+  setServerUrls(QStringList() << url);
+}
 
-void HttpApi::setServerUrl(const QString &url) { m_serverUrl = url; }
+void HttpApi::setServerUrls(const QStringList &urls) {
+  // 保留仍在使用的后端的未完成请求数
+  QList<Backend> backends;
+  for (const QString &url : urls) {
+    Backend backend;
+    backend.url = url;
+    for (const Backend &existing : m_backends) {
+      if (existing.url == url) {
+        backend.outstanding = existing.outstanding;
+        break;
+      }
+    }
+    backends.append(backend);
+  }
+  // 移除的后端上的请求不再计数，不再为其发送心跳
+  for (const Backend &existing : m_backends) {
+    if (existing.outstanding > 0 && !urls.contains(existing.url)) {
+      emit backendLoadChanged(existing.url, 0);
+    }
+  }
+  m_backends = backends;
+
+  if (!urls.isEmpty()) {
+    m_serverUrl = urls.first();
+  }
+}
+
+QStringList HttpApi::serverUrls() const {
+  QStringList urls;
+  for (const Backend &backend : m_backends) {
+    urls.append(backend.url);
+  }
+  return urls;
+}
+
+QString HttpApi::acquireBackend(const QStringList &exclude) {
+  // 选择未完成请求最少的后端，尽量避开exclude中刚刚失败的后端
+  int best = -1;
+  for (int pass = 0; pass < 2 && best < 0; ++pass) {
+    for (int i = 0; i < m_backends.size(); ++i) {
+      if (pass == 0 && exclude.contains(m_backends.at(i).url)) {
+        continue;
+      }
+      if (best < 0 ||
+          m_backends.at(i).outstanding < m_backends.at(best).outstanding) {
+        best = i;
+      }
+    }
+  }
+
+  if (best < 0) {
+    return m_serverUrl;
+  }
+  ++m_backends[best].outstanding;
+  emit backendLoadChanged(m_backends.at(best).url,
+                          m_backends.at(best).outstanding);
+  return m_backends.at(best).url;
+}
+
+void HttpApi::releaseBackend(const QString &url) {
+  for (Backend &backend : m_backends) {
+    if (backend.url == url && backend.outstanding > 0) {
+      --backend.outstanding;
+      emit backendLoadChanged(backend.url, backend.outstanding);
+      return;
+    }
+  }
+}
 
 void HttpApi::checkHealth() {
   QNetworkRequest request = createRequest("/api/health");
@@ -51,8 +133,6 @@ void HttpApi::getConfig() {
 }
 
 void HttpApi::updateConfig(const ConfigData &config) {
-  QNetworkRequest request = createRequest("/api/config");
-
   QJsonObject data;
   data["pandoc_path"] = config.pandocPath;
   data["template_file"] = config.templateFile;
@@ -61,13 +141,26 @@ void HttpApi::updateConfig(const ConfigData &config) {
   QJsonDocument doc(data);
   QByteArray jsonData = doc.toJson();
 
-  QNetworkReply *reply = m_networkManager->post(request, jsonData);
+  // 每个后端各自持有配置，需要全部更新
+  QStringList urls = serverUrls();
+  if (urls.isEmpty()) {
+    urls << m_serverUrl;
+  }
+  if (m_pendingConfigUpdates == 0) {
+    m_configUpdateError.clear();
+  }
+  m_pendingConfigUpdates += urls.size();
 
-  connect(reply, &QNetworkReply::finished, this,
-          &HttpApi::onUpdateConfigFinished);
-  connect(reply,
-          QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error),
-          this, &HttpApi::onNetworkError);
+  for (const QString &url : urls) {
+    QNetworkRequest request = createRequest("/api/config", url);
+    QNetworkReply *reply = m_networkManager->post(request, jsonData);
+
+    connect(reply, &QNetworkReply::finished, this,
+            &HttpApi::onUpdateConfigFinished);
+    connect(reply,
+            QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error),
+            this, &HttpApi::onNetworkError);
+  }
 }
 
 void HttpApi::validateConfig() {
@@ -81,8 +174,29 @@ void HttpApi::validateConfig() {
           this, &HttpApi::onNetworkError);
 }
 
-void HttpApi::convertSingle(const ConversionRequest &request) {
-  QNetworkRequest netRequest = createRequest("/api/convert/single");
+int HttpApi::convertSingle(const ConversionRequest &request) {
+  int requestId = ++m_nextRequestId;
+  m_activeSingles.insert(requestId);
+  sendSingle(request, requestId, 0, deadlineAfter(request.timeoutMs));
+  return requestId;
+}
+
+void HttpApi::sendSingle(const ConversionRequest &request, int requestId,
+                         int busyRetries, qint64 deadline) {
+  // 繁忙重试时可能已经过了截止时间，不再发送
+  if (isPastDeadline(deadline)) {
+    m_activeSingles.remove(requestId);
+    ConversionResponse response;
+    response.success = false;
+    response.error = "已超过请求的截止时间，转换已停止";
+    emit singleConversionFinished(response);
+    return;
+  }
+
+  QString backendUrl = acquireBackend();
+  QNetworkRequest netRequest =
+      createRequest("/api/convert/single", backendUrl);
+  applyDeadline(netRequest, deadline);
 
   QJsonObject data;
   data["input_file"] = request.inputFile;
@@ -94,6 +208,15 @@ void HttpApi::convertSingle(const ConversionRequest &request) {
   QByteArray jsonData = doc.toJson();
 
   QNetworkReply *reply = m_networkManager->post(netRequest, jsonData);
+  m_replyBackends.insert(reply, backendUrl);
+
+  SingleOperation operation;
+  operation.request = request;
+  operation.requestId = requestId;
+  operation.busyRetries = busyRetries;
+  operation.deadline = deadline;
+  m_singleRequests.insert(reply, operation);
+  watchDeadline(reply, deadline);
 
   connect(reply, &QNetworkReply::finished, this,
           &HttpApi::onSingleConversionFinished);
@@ -102,32 +225,192 @@ void HttpApi::convertSingle(const ConversionRequest &request) {
           this, &HttpApi::onNetworkError);
 }
 
-void HttpApi::convertBatch(const BatchConversionRequest &request) {
-  QNetworkRequest netRequest = createRequest("/api/convert/batch");
+int HttpApi::convertBatch(const BatchConversionRequest &request) {
+  int batchId = ++m_nextRequestId;
+  BatchOperation &operation = m_batches[batchId];
+  operation.request = request;
+  operation.deadline = deadlineAfter(request.timeoutMs);
+  operation.results.resize(request.inputFiles.size());
+  operation.finished.fill(false, request.inputFiles.size());
+
+  if (request.inputFiles.isEmpty()) {
+    // 与其他情况一样异步返回结果
+    QTimer::singleShot(0, this, [this, batchId]() { finishBatch(batchId); });
+    return batchId;
+  }
+
+  // 文件足够多时按轮转方式拆分到各个后端，相邻的大文件不会集中到同一个后端
+  int parts = qMax(1, m_backends.size());
+  parts = qMin(parts, request.inputFiles.size() / MIN_FILES_PER_PART);
+  parts = qMax(1, parts);
+
+  QVector<QList<int>> partIndices(parts);
+  for (int i = 0; i < request.inputFiles.size(); ++i) {
+    partIndices[i % parts].append(i);
+  }
+
+  operation.pendingParts = parts;
+  for (const QList<int> &indices : partIndices) {
+    sendBatchPart(batchId, indices, QStringList(), 0);
+  }
+  return batchId;
+}
+
+void HttpApi::cancel(int requestId) {
+  if (m_batches.contains(requestId)) {
+    m_batches[requestId].cancelled = true;
+    // 中止后各部分在onBatchConversionFinished中把剩余文件标记为已取消；
+    // 正在等待繁忙重试的部分在重试时处理
+    const QList<QNetworkReply *> replies = m_batchParts.keys();
+    for (QNetworkReply *reply : replies) {
+      if (m_batchParts.contains(reply) &&
+          m_batchParts.value(reply).batchId == requestId) {
+        reply->abort();
+      }
+    }
+    return;
+  }
+
+  if (!m_activeSingles.contains(requestId)) {
+    return;
+  }
+  const QList<QNetworkReply *> replies = m_singleRequests.keys();
+  for (QNetworkReply *reply : replies) {
+    if (m_singleRequests.value(reply).requestId == requestId) {
+      reply->abort();
+      return;
+    }
+  }
+
+  // 正在等待繁忙重试，没有进行中的请求
+  m_activeSingles.remove(requestId);
+  ConversionResponse response;
+  response.success = false;
+  response.error = "转换已取消";
+  emit singleConversionFinished(response);
+}
+
+void HttpApi::sendBatchPart(int batchId, const QList<int> &indices,
+                            const QStringList &excludeUrls, int attempt,
+                            int busyRetries) {
+  const BatchConversionRequest &request = m_batches[batchId].request;
+  const qint64 deadline = m_batches[batchId].deadline;
+
+  // 繁忙重试时可能已经过了截止时间，不再发送
+  if (isPastDeadline(deadline)) {
+    finishBatchPart(batchId, indices, "failed",
+                    "已超过请求的截止时间，转换已停止");
+    return;
+  }
+
+  // 使用流式接口，服务器每完成一个文件就返回一行结果
+  QString backendUrl = acquireBackend(excludeUrls);
+  QNetworkRequest netRequest =
+      createRequest("/api/convert/batch/stream", backendUrl);
+  netRequest.setRawHeader("Accept", "application/x-ndjson");
+  applyDeadline(netRequest, deadline);
 
   QJsonObject data;
   QJsonArray inputFiles;
-  for (const QString &file : request.inputFiles) {
-    inputFiles.append(file);
+  for (int index : indices) {
+    inputFiles.append(request.inputFiles.at(index));
   }
   data["input_files"] = inputFiles;
   data["output_dir"] = request.outputDir;
   data["template_file"] = request.templateFile;
+  data["incremental"] = request.incremental;
+  if (!request.order.isEmpty()) {
+    data["order"] = request.order;
+  }
 
   QJsonDocument doc(data);
   QByteArray jsonData = doc.toJson();
 
   QNetworkReply *reply = m_networkManager->post(netRequest, jsonData);
 
+  BatchPart part;
+  part.batchId = batchId;
+  part.indices = indices;
+  part.backendUrl = backendUrl;
+  part.attempt = attempt;
+  part.busyRetries = busyRetries;
+  m_batchParts.insert(reply, part);
+  watchDeadline(reply, deadline);
+
+  // 网络错误在onBatchConversionFinished中处理，后端崩溃时换后端重试
+  connect(reply, &QNetworkReply::readyRead, this,
+          &HttpApi::onBatchStreamReadyRead);
   connect(reply, &QNetworkReply::finished, this,
           &HttpApi::onBatchConversionFinished);
-  connect(reply,
-          QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error),
-          this, &HttpApi::onNetworkError);
 }
 
-QNetworkRequest HttpApi::createRequest(const QString &endpoint) {
-  QUrl url(m_serverUrl + endpoint);
+bool HttpApi::isBackendFailure(QNetworkReply::NetworkError error) {
+  // 1-99为连接层错误（连接被拒绝、连接中断、超时等），说明后端进程不可用；
+  // 用户主动取消不算
+  return error > QNetworkReply::NoError &&
+         error < QNetworkReply::ProxyConnectionRefusedError &&
+         error != QNetworkReply::OperationCanceledError;
+}
+
+bool HttpApi::isServerBusy(QNetworkReply *reply) {
+  return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() ==
+         429;
+}
+
+int HttpApi::busyRetryDelay(QNetworkReply *reply, int busyRetries) {
+  // 优先使用服务器给出的Retry-After（秒），否则按指数退避
+  bool ok = false;
+  int delay = reply->rawHeader("Retry-After").trimmed().toInt(&ok) * 1000;
+  if (!ok || delay <= 0) {
+    delay = BUSY_RETRY_BASE << qMin(busyRetries, 6);
+  }
+  delay = qMin(delay, int(MAX_BUSY_RETRY_DELAY));
+
+  // 加上最多50%的随机抖动，避免多个客户端同时重试再次挤满队列
+  return delay + QRandomGenerator::global()->bounded(delay / 2 + 1);
+}
+
+qint64 HttpApi::deadlineAfter(int timeoutMs) {
+  if (timeoutMs <= 0) {
+    return 0;
+  }
+  return QDateTime::currentMSecsSinceEpoch() + timeoutMs;
+}
+
+bool HttpApi::isPastDeadline(qint64 deadline) {
+  return deadline > 0 && QDateTime::currentMSecsSinceEpoch() >= deadline;
+}
+
+void HttpApi::applyDeadline(QNetworkRequest &request, qint64 deadline) {
+  if (deadline > 0) {
+    request.setRawHeader("X-Request-Deadline", QByteArray::number(deadline));
+  }
+}
+
+void HttpApi::watchDeadline(QNetworkReply *reply, qint64 deadline) {
+  if (deadline <= 0) {
+    return;
+  }
+
+  // 服务器在截止时间结束pandoc进程，客户端同时中止请求，不再等待结果；
+  // 定时器以reply为上下文，请求先结束时自动失效
+  qint64 remaining = deadline - QDateTime::currentMSecsSinceEpoch();
+  int delay = int(qBound<qint64>(0, remaining, INT_MAX));
+  QTimer::singleShot(delay, reply, [reply]() {
+    if (reply->isRunning()) {
+      reply->setProperty("deadlineExceeded", true);
+      reply->abort();
+    }
+  });
+}
+
+bool HttpApi::isDeadlineExceeded(QNetworkReply *reply) {
+  return reply->property("deadlineExceeded").toBool();
+}
+
+QNetworkRequest HttpApi::createRequest(const QString &endpoint,
+                                       const QString &baseUrl) {
+  QUrl url((baseUrl.isEmpty() ? m_serverUrl : baseUrl) + endpoint);
   QNetworkRequest request(url);
   request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
   return request;
@@ -193,17 +476,27 @@ void HttpApi::onUpdateConfigFinished() {
   if (!reply)
     return;
 
-  bool success = (reply->error() == QNetworkReply::NoError);
+  if (reply->error() != QNetworkReply::NoError) {
+    m_configUpdateError = reply->errorString();
+  }
+  reply->deleteLater();
+
+  // 所有后端都返回后再通知结果
+  if (--m_pendingConfigUpdates > 0) {
+    return;
+  }
+  m_pendingConfigUpdates = 0;
+
+  bool success = m_configUpdateError.isEmpty();
   QString message;
 
   if (success) {
     message = "配置更新成功";
   } else {
-    message = QString("配置更新失败: %1").arg(reply->errorString());
+    message = QString("配置更新失败: %1").arg(m_configUpdateError);
   }
 
   emit configUpdated(success, message);
-  reply->deleteLater();
 }
 
 void HttpApi::onValidateConfigFinished() {
@@ -238,9 +531,33 @@ void HttpApi::onSingleConversionFinished() {
   if (!reply)
     return;
 
+  releaseBackend(m_replyBackends.take(reply));
+  SingleOperation operation = m_singleRequests.take(reply);
+
+  // 服务器繁忙：等待后重发，不把429当作转换失败
+  if (isServerBusy(reply) && operation.busyRetries < MAX_BUSY_RETRIES) {
+    int delay = busyRetryDelay(reply, operation.busyRetries);
+    qDebug() << "服务器繁忙，" << delay << "毫秒后重试单文件转换";
+    QTimer::singleShot(delay, this, [this, operation]() {
+      if (m_activeSingles.contains(operation.requestId)) {
+        sendSingle(operation.request, operation.requestId,
+                   operation.busyRetries + 1, operation.deadline);
+      }
+    });
+    reply->deleteLater();
+    return;
+  }
+  m_activeSingles.remove(operation.requestId);
+
   ConversionResponse response;
 
-  if (reply->error() != QNetworkReply::NoError) {
+  if (isDeadlineExceeded(reply)) {
+    response.success = false;
+    response.error = "已超过请求的截止时间，转换已停止";
+  } else if (reply->error() == QNetworkReply::OperationCanceledError) {
+    response.success = false;
+    response.error = "转换已取消";
+  } else if (reply->error() != QNetworkReply::NoError) {
     response.success = false;
     response.error = reply->errorString();
   } else {
@@ -260,21 +577,204 @@ void HttpApi::onBatchConversionFinished() {
   if (!reply)
     return;
 
+  // 处理最后一段尚未读取的数据
+  if (reply->error() == QNetworkReply::NoError) {
+    processBatchStream(reply);
+  }
+
+  BatchPart part = m_batchParts.take(reply);
+  m_streamBuffers.remove(reply);
+  releaseBackend(part.backendUrl);
+  reply->deleteLater();
+
+  if (!m_batches.contains(part.batchId)) {
+    return;
+  }
+  BatchOperation &operation = m_batches[part.batchId];
+
+  // 尚未收到结果的文件
+  QList<int> remaining;
+  for (int index : part.indices) {
+    if (!operation.finished.at(index)) {
+      remaining.append(index);
+    }
+  }
+
+  // 已取消：剩余文件不再重试
+  if (operation.cancelled) {
+    finishBatchPart(part.batchId, remaining, "cancelled", "转换已取消");
+    return;
+  }
+
+  // 已超过截止时间：剩余文件以超时失败
+  if (isDeadlineExceeded(reply)) {
+    operation.lastError = "已超过请求的截止时间，转换已停止";
+    finishBatchPart(part.batchId, remaining, "failed", operation.lastError);
+    return;
+  }
+
+  // 服务器繁忙时整个部分都未开始：等待后重发，交给当时最空闲的后端
+  if (!remaining.isEmpty() && isServerBusy(reply) &&
+      part.busyRetries < MAX_BUSY_RETRIES) {
+    int delay = busyRetryDelay(reply, part.busyRetries);
+    qDebug() << "服务器繁忙，" << delay << "毫秒后重试" << remaining.size()
+             << "个文件";
+    QTimer::singleShot(delay, this, [this, part, remaining]() {
+      if (!m_batches.contains(part.batchId)) {
+        return;
+      }
+      if (m_batches.value(part.batchId).cancelled) {
+        finishBatchPart(part.batchId, remaining, "cancelled", "转换已取消");
+        return;
+      }
+      sendBatchPart(part.batchId, remaining, QStringList(), part.attempt,
+                    part.busyRetries + 1);
+    });
+    return;
+  }
+
+  if (!remaining.isEmpty()) {
+    QString error = reply->errorString();
+    if (reply->error() == QNetworkReply::NoError) {
+      error = part.error.isEmpty() ? QString("批量转换响应不完整") : part.error;
+    }
+    bool backendFailed = isBackendFailure(reply->error()) ||
+                         (reply->error() == QNetworkReply::NoError &&
+                          !part.completed);
+
+    // 后端崩溃或连接中断：剩余文件换一个后端重试，不影响其他部分
+    if (backendFailed && part.attempt < MAX_BATCH_RETRIES) {
+      qDebug() << "后端" << part.backendUrl << "转换中断，" << remaining.size()
+               << "个文件改由其他后端处理:" << error;
+      sendBatchPart(part.batchId, remaining, QStringList() << part.backendUrl,
+                    part.attempt + 1);
+      return;
+    }
+
+    operation.lastError = error;
+  }
+
+  finishBatchPart(part.batchId, remaining, "failed", operation.lastError);
+}
+
+void HttpApi::finishBatchPart(int batchId, const QList<int> &indices,
+                              const QString &status, const QString &error) {
+  BatchOperation &operation = m_batches[batchId];
+  const int total = operation.results.size();
+  for (int index : indices) {
+    ConversionResult result;
+    result.inputFile = operation.request.inputFiles.at(index);
+    result.success = false;
+    result.status = status;
+    result.error = error;
+    operation.results[index] = result;
+    operation.finished[index] = true;
+    emit batchItemFinished(index, total, result);
+  }
+
+  if (--operation.pendingParts == 0) {
+    finishBatch(batchId);
+  }
+}
+
+void HttpApi::finishBatch(int batchId) {
+  BatchOperation operation = m_batches.take(batchId);
+  const int total = operation.results.size();
+
   ConversionResponse response;
+  int successCount = 0;
+  int skippedCount = 0;
+  int cancelledCount = 0;
+  for (const ConversionResult &result : operation.results) {
+    response.results.append(result);
+    if (result.success) {
+      ++successCount;
+    }
+    if (result.status == "skipped") {
+      ++skippedCount;
+    } else if (result.status == "cancelled") {
+      ++cancelledCount;
+    }
+  }
 
-  if (reply->error() != QNetworkReply::NoError) {
-    response.success = false;
-    response.error = reply->errorString();
+  // 汇总各部分的结果，提示信息与服务器保持一致
+  response.success = successCount > 0;
+  if (total == 0) {
+    response.error = "输入文件列表不能为空";
+  } else if (successCount == total) {
+    response.message = QString("所有%1个文件转换成功").arg(successCount);
+  } else if (successCount > 0) {
+    response.message = QString("%1个文件转换成功，%2个文件转换失败")
+                           .arg(successCount)
+                           .arg(total - successCount);
   } else {
-    QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject json = doc.object();
-
-    response = parseConversionResponse(json);
+    response.message = "所有文件转换失败";
+    response.error = operation.lastError.isEmpty() ? QString("批量转换失败")
+                                                   : operation.lastError;
+  }
+  if (skippedCount > 0) {
+    response.message +=
+        QString("（其中%1个文件已是最新，未重新转换）").arg(skippedCount);
+  }
+  if (cancelledCount > 0) {
+    response.message += QString("，%1个文件已取消").arg(cancelledCount);
   }
 
   emit batchConversionFinished(response);
-  reply->deleteLater();
+}
+
+void HttpApi::onBatchStreamReadyRead() {
+  QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+  if (!reply)
+    return;
+
+  processBatchStream(reply);
+}
+
+void HttpApi::processBatchStream(QNetworkReply *reply) {
+  if (!m_batchParts.contains(reply)) {
+    return;
+  }
+  BatchPart &part = m_batchParts[reply];
+  if (!m_batches.contains(part.batchId)) {
+    return;
+  }
+  BatchOperation &operation = m_batches[part.batchId];
+
+  QByteArray &buffer = m_streamBuffers[reply];
+  buffer.append(reply->readAll());
+
+  // 每行是一个JSON事件，不完整的行留在缓冲区等待后续数据
+  int newline;
+  while ((newline = buffer.indexOf('\n')) >= 0) {
+    QByteArray line = buffer.left(newline).trimmed();
+    buffer.remove(0, newline + 1);
+    if (line.isEmpty())
+      continue;
+
+    QJsonObject event = QJsonDocument::fromJson(line).object();
+    QString type = event.value("event").toString();
+
+    if (type == "item") {
+      // 事件中的序号是该部分内的序号，换算成原始请求中的序号
+      int local = event.value("index").toInt();
+      if (local < 0 || local >= part.indices.size()) {
+        continue;
+      }
+      int index = part.indices.at(local);
+      if (operation.finished.at(index)) {
+        continue;
+      }
+      ConversionResult result =
+          parseConversionResult(event.value("result").toObject());
+      operation.results[index] = result;
+      operation.finished[index] = true;
+      emit batchItemFinished(index, operation.results.size(), result);
+    } else if (type == "done") {
+      part.completed = true;
+      part.error = event.value("response").toObject().value("error").toString();
+    }
+  }
 }
 
 void HttpApi::onNetworkError(QNetworkReply::NetworkError error) {
@@ -282,6 +782,17 @@ void HttpApi::onNetworkError(QNetworkReply::NetworkError error) {
   if (!reply)
     return;
 
+  // 主动取消的请求不算错误
+  if (error == QNetworkReply::OperationCanceledError) {
+    return;
+  }
+
+  // 服务器繁忙由完成回调处理重试
+  if (isServerBusy(reply) && m_singleRequests.contains(reply) &&
+      m_singleRequests.value(reply).busyRetries < MAX_BUSY_RETRIES) {
+    return;
+  }
+
   QString errorMsg = QString("网络错误: %1").arg(reply->errorString());
   emit errorOccurred(errorMsg);
 }
@@ -297,19 +808,23 @@ ConversionResponse HttpApi::parseConversionResponse(const QJsonObject &json) {
   if (json.contains("results")) {
     QJsonArray resultsArray = json.value("results").toArray();
     for (const QJsonValue &value : resultsArray) {
-      QJsonObject resultObj = value.toObject();
-      ConversionResult result;
-      result.inputFile = resultObj.value("input_file").toString();
-      result.outputFile = resultObj.value("output_file").toString();
-      result.success = resultObj.value("success").toBool();
-      result.error = resultObj.value("error").toString();
-      response.results.append(result);
+      response.results.append(parseConversionResult(value.toObject()));
     }
   }
 
   return response;
 }
 
+ConversionResult HttpApi::parseConversionResult(const QJsonObject &json) {
+  ConversionResult result;
+  result.inputFile = json.value("input_file").toString();
+  result.outputFile = json.value("output_file").toString();
+  result.success = json.value("success").toBool();
+  result.status = json.value("status").toString();
+  result.error = json.value("error").toString();
+  return result;
+}
+
 ConfigData HttpApi::parseConfigData(const QJsonObject &json) {
   ConfigData config;
   config.pandocPath = json.value("pandoc_path").toString();
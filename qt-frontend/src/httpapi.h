@@ -1,6 +1,7 @@
 #ifndef HTTPAPI_H
 #define HTTPAPI_H
 
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -8,26 +9,37 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QObject>
+#include <QSet>
 #include <QTimer>
 #include <QUrl>
+#include <QVector>
 
 struct ConversionRequest {
   QString inputFile;
   QString outputDir;
   QString outputName;
   QString templateFile;
+  // 截止时间（毫秒）：0或负数表示不限制（大文档转换可能需要数分钟）
+  int timeoutMs = 0;
 };
 
 struct BatchConversionRequest {
   QStringList inputFiles;
   QString outputDir;
   QString templateFile;
+  bool incremental = false; // 跳过输出已是最新的文件
+  // 调度顺序：空表示按输入顺序，longest_first 大文件先开始（缩短总耗时），
+  // shortest_first 小文件先开始（尽快看到结果）
+  QString order;
+  // 整批的截止时间（毫秒）：0或负数表示不限制
+  int timeoutMs = 0;
 };
 
 struct ConversionResult {
   QString inputFile;
   QString outputFile;
-  bool success;
+  bool success = false;
+  QString status;
   QString error;
 };
 
@@ -55,18 +67,32 @@ public:
   // 设置服务器地址
   void setServerUrl(const QString &url);
   QString serverUrl() const { return m_serverUrl; }
+  QStringList serverUrls() const;
 
   // API调用方法
   void checkHealth();
   void getConfig();
   void updateConfig(const ConfigData &config);
   void validateConfig();
-  void convertSingle(const ConversionRequest &request);
-  void convertBatch(const BatchConversionRequest &request);
+  // 转换请求返回请求ID，可用于cancel。
+  // 截止时间通过X-Request-Deadline请求头发给服务器：服务器不再开始已过期的请求，
+  // 到期时结束正在运行的pandoc进程；客户端同时中止请求，未完成的文件以超时失败
+  int convertSingle(const ConversionRequest &request);
+  int convertBatch(const BatchConversionRequest &request);
+
+  // 取消转换请求：中止网络请求，服务器随之结束正在运行的pandoc进程。
+  // 单文件转换以"转换已取消"失败结束；批量转换中尚未完成的文件标记为已取消，
+  // 照常发出batchConversionFinished
+  void cancel(int requestId);
 
   // 状态查询
   bool isServerOnline() const { return m_serverOnline; }
 
+public slots:
+  // 设置多个后端地址：转换请求发给未完成请求最少的后端，
+  // 大批量拆分到各个后端并行处理，配置更新发给所有后端
+  void setServerUrls(const QStringList &urls);
+
 signals:
   void healthCheckFinished(bool isOnline);
   void configReceived(const ConfigData &config);
@@ -74,7 +100,11 @@ signals:
   void configValidated(bool success, const QString &message);
   void singleConversionFinished(const ConversionResponse &response);
   void batchConversionFinished(const ConversionResponse &response);
+  // 批量转换中单个文件完成（流式返回，index为文件在请求中的序号）
+  void batchItemFinished(int index, int total, const ConversionResult &result);
   void errorOccurred(const QString &error);
+  // 某个后端的未完成转换请求数变化（发出请求时增加，结束时减少）
+  void backendLoadChanged(const QString &url, int outstanding);
 
 private slots:
   void onHealthCheckFinished();
@@ -83,23 +113,99 @@ private slots:
   void onValidateConfigFinished();
   void onSingleConversionFinished();
   void onBatchConversionFinished();
+  void onBatchStreamReadyRead();
   void onNetworkError(QNetworkReply::NetworkError error);
 
 private:
-  QNetworkRequest createRequest(const QString &endpoint);
+  // 单个后端及其未完成的转换请求数
+  struct Backend {
+    QString url;
+    int outstanding = 0;
+  };
+
+  // 拆分到多个后端的批量转换
+  struct BatchOperation {
+    BatchConversionRequest request;
+    QVector<ConversionResult> results;
+    QVector<bool> finished;
+    int pendingParts = 0;
+    QString lastError;
+    bool cancelled = false;
+    qint64 deadline = 0; // Unix毫秒时间戳，0表示不限制
+  };
+
+  // 发给某个后端的一部分文件
+  struct BatchPart {
+    int batchId = 0;
+    QList<int> indices; // 文件在原始请求中的序号
+    QString backendUrl;
+    int attempt = 0;
+    int busyRetries = 0;    // 服务器繁忙（429）后重试的次数
+    bool completed = false; // 收到了done事件
+    QString error;          // done事件中的错误信息
+  };
+
+  QNetworkRequest createRequest(const QString &endpoint,
+                                const QString &baseUrl = QString());
+  QString acquireBackend(const QStringList &exclude = QStringList());
+  void releaseBackend(const QString &url);
+  void sendSingle(const ConversionRequest &request, int requestId,
+                  int busyRetries, qint64 deadline);
+  void sendBatchPart(int batchId, const QList<int> &indices,
+                     const QStringList &excludeUrls, int attempt,
+                     int busyRetries = 0);
+  void finishBatchPart(int batchId, const QList<int> &indices,
+                       const QString &status, const QString &error);
+  void finishBatch(int batchId);
+  static bool isBackendFailure(QNetworkReply::NetworkError error);
+  static bool isServerBusy(QNetworkReply *reply);
+  static qint64 deadlineAfter(int timeoutMs);
+  static bool isPastDeadline(qint64 deadline);
+  void applyDeadline(QNetworkRequest &request, qint64 deadline);
+  void watchDeadline(QNetworkReply *reply, qint64 deadline);
+  static bool isDeadlineExceeded(QNetworkReply *reply);
+  static int busyRetryDelay(QNetworkReply *reply, int busyRetries);
   void handleNetworkReply(QNetworkReply *reply, const QString &operation);
   ConversionResponse parseConversionResponse(const QJsonObject &json);
+  ConversionResult parseConversionResult(const QJsonObject &json);
+  void processBatchStream(QNetworkReply *reply);
   ConfigData parseConfigData(const QJsonObject &json);
   void loadServerPortFromConfig();
   QString getConfigFilePath();
 
   QNetworkAccessManager *m_networkManager;
-  QString m_serverUrl;
+  QString m_serverUrl; // 第一个后端，用于配置和健康检查等轻量请求
+  QList<Backend> m_backends;
   bool m_serverOnline;
 
-  // 请求超时定时器
-  QTimer *m_timeoutTimer;
-  static const int REQUEST_TIMEOUT = 30000; // 30秒
+  // 转换请求所在的后端
+  QHash<QNetworkReply *, QString> m_replyBackends;
+
+  // 单文件转换请求及其繁忙重试次数，服务器返回429时按原请求重发
+  struct SingleOperation {
+    ConversionRequest request;
+    int requestId = 0;
+    int busyRetries = 0;
+    qint64 deadline = 0; // Unix毫秒时间戳，繁忙重试时保持不变
+  };
+  QHash<QNetworkReply *, SingleOperation> m_singleRequests;
+  QSet<int> m_activeSingles; // 尚未结束的单文件转换（包括等待重试的）
+
+  // 流式批量转换：未处理完的数据、各部分和整体进度
+  QHash<QNetworkReply *, QByteArray> m_streamBuffers;
+  QHash<QNetworkReply *, BatchPart> m_batchParts;
+  QHash<int, BatchOperation> m_batches;
+  int m_nextRequestId; // 单文件和批量转换共用的请求ID
+
+  // 发给所有后端的配置更新
+  int m_pendingConfigUpdates;
+  QString m_configUpdateError;
+
+  static const int MIN_FILES_PER_PART = 4; // 文件太少时不拆分
+  static const int MAX_BATCH_RETRIES = 2;  // 后端崩溃时换后端重试的次数
+  static const int MAX_BUSY_RETRIES = 5;   // 服务器繁忙时重试的次数
+  static const int BUSY_RETRY_BASE = 500;  // 未给出Retry-After时的初始等待（毫秒）
+  static const int MAX_BUSY_RETRY_DELAY = 30000; // 单次等待上限
 };
 
 #endif // HTTPAPI_H
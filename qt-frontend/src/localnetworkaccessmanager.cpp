@@ -0,0 +1,442 @@
+#include "localnetworkaccessmanager.h"
+
+#include <QMetaObject>
+#include <QUrl>
+
+#include <cstring>
+
+namespace {
+
+const char *const SOCKET_SUFFIX = ".sock";
+
+// 与QNetworkAccessManager对HTTP错误状态码的映射保持一致
+QNetworkReply::NetworkError errorForStatus(int status) {
+  switch (status) {
+  case 400:
+    return QNetworkReply::ProtocolInvalidOperationError;
+  case 401:
+    return QNetworkReply::AuthenticationRequiredError;
+  case 403:
+    return QNetworkReply::ContentAccessDenied;
+  case 404:
+    return QNetworkReply::ContentNotFoundError;
+  case 405:
+    return QNetworkReply::ContentOperationNotPermittedError;
+  case 409:
+    return QNetworkReply::ContentConflictError;
+  case 410:
+    return QNetworkReply::ContentGoneError;
+  case 500:
+    return QNetworkReply::InternalServerError;
+  case 501:
+    return QNetworkReply::OperationNotImplementedError;
+  case 503:
+    return QNetworkReply::ServiceUnavailableError;
+  default:
+    if (status >= 500) {
+      return QNetworkReply::UnknownServerError;
+    }
+    if (status >= 400) {
+      return QNetworkReply::UnknownContentError;
+    }
+    return QNetworkReply::NoError;
+  }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// LocalNetworkAccessManager
+// ---------------------------------------------------------------------------
+
+LocalNetworkAccessManager::LocalNetworkAccessManager(QObject *parent)
+    : QNetworkAccessManager(parent) {}
+
+QString LocalNetworkAccessManager::serverUrlForSocket(const QString &socketPath) {
+  return "unix:" + socketPath;
+}
+
+QNetworkReply *
+LocalNetworkAccessManager::createRequest(Operation op,
+                                         const QNetworkRequest &request,
+                                         QIODevice *outgoingData) {
+  QUrl url = request.url();
+  if (url.scheme() != "unix") {
+    return QNetworkAccessManager::createRequest(op, request, outgoingData);
+  }
+
+  // 拆分套接字路径和HTTP请求路径
+  QByteArray fullPath = url.path(QUrl::FullyEncoded).toUtf8();
+  int split = fullPath.indexOf(QByteArray(SOCKET_SUFFIX) + "/");
+  if (split < 0 && fullPath.endsWith(SOCKET_SUFFIX)) {
+    split = fullPath.size() - int(qstrlen(SOCKET_SUFFIX));
+  }
+  split = split < 0 ? fullPath.size() : split + int(qstrlen(SOCKET_SUFFIX));
+
+  QString socketPath = QUrl::fromPercentEncoding(fullPath.left(split));
+  QByteArray requestPath = fullPath.mid(split);
+  if (requestPath.isEmpty()) {
+    requestPath = "/";
+  }
+  if (url.hasQuery()) {
+    requestPath += "?" + url.query(QUrl::FullyEncoded).toUtf8();
+  }
+
+  QByteArray verb;
+  switch (op) {
+  case HeadOperation:
+    verb = "HEAD";
+    break;
+  case GetOperation:
+    verb = "GET";
+    break;
+  case PutOperation:
+    verb = "PUT";
+    break;
+  case PostOperation:
+    verb = "POST";
+    break;
+  case DeleteOperation:
+    verb = "DELETE";
+    break;
+  default:
+    verb = request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+    break;
+  }
+
+  QByteArray body = outgoingData ? outgoingData->readAll() : QByteArray();
+  return new LocalSocketReply(socketPath, requestPath, verb, op, request, body,
+                              this);
+}
+
+// ---------------------------------------------------------------------------
+// LocalSocketReply
+// ---------------------------------------------------------------------------
+
+LocalSocketReply::LocalSocketReply(const QString &socketPath,
+                                   const QByteArray &requestPath,
+                                   const QByteArray &verb,
+                                   QNetworkAccessManager::Operation operation,
+                                   const QNetworkRequest &request,
+                                   const QByteArray &body, QObject *parent)
+    : QNetworkReply(parent), m_socket(new QLocalSocket(this)),
+      m_socketPath(socketPath), m_state(ReadingHeaders), m_statusCode(0),
+      m_contentLength(-1), m_received(0), m_chunkRemaining(0) {
+  setRequest(request);
+  setUrl(request.url());
+  setOperation(operation);
+  open(QIODevice::ReadOnly);
+
+  // 组装HTTP/1.1请求
+  m_requestData = verb + " " + requestPath + " HTTP/1.1\r\n";
+  m_requestData += "Host: localhost\r\n";
+  m_requestData += "Connection: close\r\n";
+  if (!body.isEmpty() || operation == QNetworkAccessManager::PostOperation ||
+      operation == QNetworkAccessManager::PutOperation) {
+    m_requestData += "Content-Length: " + QByteArray::number(body.size()) +
+                     "\r\n";
+  }
+  for (const QByteArray &name : request.rawHeaderList()) {
+    QByteArray lower = name.toLower();
+    if (lower == "host" || lower == "connection" || lower == "content-length") {
+      continue;
+    }
+    m_requestData += name + ": " + request.rawHeader(name) + "\r\n";
+  }
+  m_requestData += "\r\n";
+  m_requestData += body;
+
+  connect(m_socket, &QLocalSocket::connected, this,
+          &LocalSocketReply::onConnected);
+  connect(m_socket, &QLocalSocket::readyRead, this,
+          &LocalSocketReply::onReadyRead);
+  connect(m_socket, &QLocalSocket::disconnected, this,
+          &LocalSocketReply::onDisconnected);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+  connect(m_socket, &QLocalSocket::errorOccurred, this,
+          &LocalSocketReply::onSocketError);
+#else
+  connect(m_socket,
+          QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error),
+          this, &LocalSocketReply::onSocketError);
+#endif
+
+  // 延迟到事件循环中连接，保证调用方先连接好finished等信号
+  QMetaObject::invokeMethod(
+      this, [this]() { m_socket->connectToServer(m_socketPath); },
+      Qt::QueuedConnection);
+}
+
+void LocalSocketReply::abort() {
+  if (isFinished()) {
+    return;
+  }
+  // 先断开套接字的信号再结束应答：abort()会同步发出disconnected()，
+  // 否则应答会被onDisconnected以RemoteHostClosedError或成功结束
+  disconnect(m_socket, nullptr, this, nullptr);
+  finishWithError(OperationCanceledError, "Operation canceled");
+}
+
+qint64 LocalSocketReply::bytesAvailable() const {
+  return m_body.size() + QNetworkReply::bytesAvailable();
+}
+
+qint64 LocalSocketReply::readData(char *data, qint64 maxSize) {
+  if (m_body.isEmpty()) {
+    return isFinished() ? -1 : 0;
+  }
+  qint64 count = qMin<qint64>(maxSize, m_body.size());
+  memcpy(data, m_body.constData(), size_t(count));
+  m_body.remove(0, int(count));
+  return count;
+}
+
+void LocalSocketReply::onConnected() { m_socket->write(m_requestData); }
+
+void LocalSocketReply::onReadyRead() {
+  m_incoming += m_socket->readAll();
+  processIncoming();
+}
+
+void LocalSocketReply::onDisconnected() {
+  if (m_socket->bytesAvailable() > 0) {
+    onReadyRead();
+  }
+  if (isFinished()) {
+    return;
+  }
+  if (m_state == ReadingBody && m_contentLength < 0) {
+    // 没有长度信息的响应以连接关闭作为结束
+    finish();
+    return;
+  }
+  finishWithError(RemoteHostClosedError, "服务器在响应完成前关闭了连接");
+}
+
+void LocalSocketReply::onSocketError(QLocalSocket::LocalSocketError socketError) {
+  if (isFinished() || socketError == QLocalSocket::PeerClosedError) {
+    // 对端关闭由onDisconnected处理
+    return;
+  }
+
+  NetworkError code = UnknownNetworkError;
+  switch (socketError) {
+  case QLocalSocket::ServerNotFoundError:
+  case QLocalSocket::ConnectionRefusedError:
+    code = ConnectionRefusedError;
+    break;
+  case QLocalSocket::SocketTimeoutError:
+    code = TimeoutError;
+    break;
+  case QLocalSocket::SocketAccessError:
+    code = ContentAccessDenied;
+    break;
+  default:
+    break;
+  }
+  finishWithError(code, m_socket->errorString());
+}
+
+void LocalSocketReply::processIncoming() {
+  while (!isFinished()) {
+    switch (m_state) {
+    case ReadingHeaders: {
+      int end = m_incoming.indexOf("\r\n\r\n");
+      if (end < 0) {
+        return;
+      }
+      QByteArray head = m_incoming.left(end);
+      m_incoming.remove(0, end + 4);
+      if (!parseHeaders(head)) {
+        finishWithError(ProtocolFailure, "无效的HTTP响应");
+        return;
+      }
+      break;
+    }
+
+    case ReadingBody: {
+      if (m_contentLength < 0) {
+        appendBody(m_incoming);
+        m_incoming.clear();
+        return;
+      }
+      qint64 take = qMin<qint64>(m_incoming.size(),
+                                 m_contentLength - m_received);
+      appendBody(m_incoming.left(int(take)));
+      m_incoming.remove(0, int(take));
+      m_received += take;
+      if (m_received >= m_contentLength) {
+        finish();
+      }
+      return;
+    }
+
+    case ReadingChunkSize: {
+      int eol = m_incoming.indexOf("\r\n");
+      if (eol < 0) {
+        return;
+      }
+      QByteArray line = m_incoming.left(eol);
+      m_incoming.remove(0, eol + 2);
+      int extension = line.indexOf(';');
+      if (extension >= 0) {
+        line.truncate(extension);
+      }
+      bool ok = false;
+      m_chunkRemaining = line.trimmed().toLongLong(&ok, 16);
+      if (!ok) {
+        finishWithError(ProtocolFailure, "无效的分块编码");
+        return;
+      }
+      m_state = m_chunkRemaining == 0 ? ReadingTrailer : ReadingChunkData;
+      break;
+    }
+
+    case ReadingChunkData: {
+      if (m_incoming.isEmpty()) {
+        return;
+      }
+      qint64 take = qMin<qint64>(m_incoming.size(), m_chunkRemaining);
+      appendBody(m_incoming.left(int(take)));
+      m_incoming.remove(0, int(take));
+      m_chunkRemaining -= take;
+      if (m_chunkRemaining == 0) {
+        m_state = ReadingChunkEnd;
+      }
+      break;
+    }
+
+    case ReadingChunkEnd:
+      if (m_incoming.size() < 2) {
+        return;
+      }
+      m_incoming.remove(0, 2);
+      m_state = ReadingChunkSize;
+      break;
+
+    case ReadingTrailer: {
+      int eol = m_incoming.indexOf("\r\n");
+      if (eol < 0) {
+        return;
+      }
+      bool last = eol == 0;
+      m_incoming.remove(0, eol + 2);
+      if (last) {
+        finish();
+      }
+      break;
+    }
+
+    case Done:
+      return;
+    }
+  }
+}
+
+bool LocalSocketReply::parseHeaders(const QByteArray &head) {
+  QList<QByteArray> lines = head.split('\n');
+  if (lines.isEmpty()) {
+    return false;
+  }
+
+  // 状态行: HTTP/1.1 200 OK
+  QByteArray statusLine = lines.takeFirst().trimmed();
+  if (!statusLine.startsWith("HTTP/1.")) {
+    return false;
+  }
+  int firstSpace = statusLine.indexOf(' ');
+  int secondSpace = statusLine.indexOf(' ', firstSpace + 1);
+  bool ok = false;
+  m_statusCode = statusLine
+                     .mid(firstSpace + 1, secondSpace < 0
+                                              ? -1
+                                              : secondSpace - firstSpace - 1)
+                     .toInt(&ok);
+  if (firstSpace < 0 || !ok) {
+    return false;
+  }
+  setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_statusCode);
+  setAttribute(QNetworkRequest::HttpReasonPhraseAttribute,
+               secondSpace < 0 ? QByteArray() : statusLine.mid(secondSpace + 1));
+
+  bool chunked = false;
+  for (const QByteArray &rawLine : lines) {
+    QByteArray line = rawLine.trimmed();
+    int colon = line.indexOf(':');
+    if (colon <= 0) {
+      continue;
+    }
+    QByteArray name = line.left(colon).trimmed();
+    QByteArray value = line.mid(colon + 1).trimmed();
+    setRawHeader(name, value);
+
+    QByteArray lower = name.toLower();
+    if (lower == "content-length") {
+      m_contentLength = value.toLongLong();
+    } else if (lower == "transfer-encoding" &&
+               value.toLower().contains("chunked")) {
+      chunked = true;
+    }
+  }
+
+  bool noBody = operation() == QNetworkAccessManager::HeadOperation ||
+                m_statusCode == 204 || m_statusCode == 304 ||
+                (m_statusCode >= 100 && m_statusCode < 200);
+  if (noBody || (!chunked && m_contentLength == 0)) {
+    finish();
+  } else if (chunked) {
+    m_state = ReadingChunkSize;
+  } else {
+    m_state = ReadingBody;
+  }
+  return true;
+}
+
+void LocalSocketReply::appendBody(const QByteArray &data) {
+  if (data.isEmpty()) {
+    return;
+  }
+  m_body += data;
+  emit readyRead();
+}
+
+void LocalSocketReply::finish() {
+  if (isFinished()) {
+    return;
+  }
+  m_state = Done;
+
+  NetworkError code = errorForStatus(m_statusCode);
+  if (code != NoError) {
+    setError(code, QString("Error transferring %1 - server replied: %2")
+                       .arg(url().toString(),
+                            attribute(QNetworkRequest::HttpReasonPhraseAttribute)
+                                .toString()));
+    emitError(code);
+  }
+
+  setFinished(true);
+  emit finished();
+  m_socket->disconnectFromServer();
+}
+
+void LocalSocketReply::finishWithError(NetworkError code,
+                                       const QString &message) {
+  if (isFinished()) {
+    return;
+  }
+  m_state = Done;
+  setError(code, message);
+  emitError(code);
+  setFinished(true);
+  emit finished();
+  m_socket->abort();
+}
+
+void LocalSocketReply::emitError(NetworkError code) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+  emit errorOccurred(code);
+#else
+  emit error(code);
+#endif
+}
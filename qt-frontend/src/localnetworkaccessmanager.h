@@ -0,0 +1,91 @@
+#ifndef LOCALNETWORKACCESSMANAGER_H
+#define LOCALNETWORKACCESSMANAGER_H
+
+#include <QLocalSocket>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+/**
+ * 支持Unix域套接字的网络访问管理器
+ *
+ * 普通http地址仍交给QNetworkAccessManager处理；"unix:"开头的地址通过
+ * QLocalSocket发送HTTP/1.1请求，地址格式为 unix:<套接字路径><请求路径>，
+ * 套接字路径以 .sock 结尾，例如 unix:/tmp/md2docx-123.sock/api/health。
+ * 调用方仍然拿到QNetworkReply，现有的回复处理代码不需要区分传输方式。
+ */
+class LocalNetworkAccessManager : public QNetworkAccessManager {
+  Q_OBJECT
+
+public:
+  explicit LocalNetworkAccessManager(QObject *parent = nullptr);
+
+  // 由套接字路径生成服务器地址
+  static QString serverUrlForSocket(const QString &socketPath);
+
+protected:
+  QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                               QIODevice *outgoingData = nullptr) override;
+};
+
+/**
+ * 通过QLocalSocket完成的单个HTTP请求
+ * 每个请求使用独立连接并发送 Connection: close，
+ * 响应体支持Content-Length、chunked和读到连接关闭三种形式
+ */
+class LocalSocketReply : public QNetworkReply {
+  Q_OBJECT
+
+public:
+  LocalSocketReply(const QString &socketPath, const QByteArray &requestPath,
+                   const QByteArray &verb,
+                   QNetworkAccessManager::Operation operation,
+                   const QNetworkRequest &request, const QByteArray &body,
+                   QObject *parent = nullptr);
+
+  void abort() override;
+  qint64 bytesAvailable() const override;
+  bool isSequential() const override { return true; }
+
+protected:
+  qint64 readData(char *data, qint64 maxSize) override;
+  qint64 writeData(const char *, qint64) override { return -1; }
+
+private slots:
+  void onConnected();
+  void onReadyRead();
+  void onDisconnected();
+  void onSocketError(QLocalSocket::LocalSocketError socketError);
+
+private:
+  enum State {
+    ReadingHeaders,
+    ReadingBody,
+    ReadingChunkSize,
+    ReadingChunkData,
+    ReadingChunkEnd,
+    ReadingTrailer,
+    Done
+  };
+
+  void processIncoming();
+  bool parseHeaders(const QByteArray &head);
+  void appendBody(const QByteArray &data);
+  void finish();
+  void finishWithError(NetworkError code, const QString &message);
+  void emitError(NetworkError code);
+
+  QLocalSocket *m_socket;
+  QString m_socketPath;
+  QByteArray m_requestData;
+
+  State m_state;
+  QByteArray m_incoming;  // 尚未解析的原始数据
+  QByteArray m_body;      // 已解码、等待读取的响应体
+  int m_statusCode;
+  qint64 m_contentLength; // -1表示读到连接关闭为止
+  qint64 m_received;
+  qint64 m_chunkRemaining;
+};
+
+#endif // LOCALNETWORKACCESSMANAGER_H
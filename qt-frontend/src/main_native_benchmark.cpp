@@ -0,0 +1,164 @@
+#include "nativedocxengine.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+
+/**
+ * 本地docx引擎与pandoc的性能对比
+ *
+ * 用法: native_benchmark [Markdown目录] [--runs N] [--pandoc 路径]
+ *                        [--template 模板.docx]
+ * 默认读取 tests/testdata 下的所有 .md 文件，每个文件分别用本地引擎和
+ * pandoc 转换 N 次，输出耗时中位数；本地引擎不支持的文件会注明原因。
+ */
+
+namespace {
+
+double median(QList<double> values) {
+  if (values.isEmpty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values.at(values.size() / 2);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QTextStream out(stdout);
+
+  QString inputDir = QDir(QCoreApplication::applicationDirPath())
+                         .absoluteFilePath("../../tests/testdata");
+  QString pandoc = "pandoc";
+  QString templateFile;
+  int runs = 10;
+
+  const QStringList args = app.arguments().mid(1);
+  for (int i = 0; i < args.size(); ++i) {
+    if (args.at(i) == "--runs" && i + 1 < args.size()) {
+      runs = qMax(1, args.at(++i).toInt());
+    } else if (args.at(i) == "--pandoc" && i + 1 < args.size()) {
+      pandoc = args.at(++i);
+    } else if (args.at(i) == "--template" && i + 1 < args.size()) {
+      templateFile = args.at(++i);
+    } else {
+      inputDir = args.at(i);
+    }
+  }
+
+  QDir dir(inputDir);
+  const QStringList files =
+      dir.entryList(QStringList() << "*.md", QDir::Files, QDir::Name);
+  if (files.isEmpty()) {
+    out << "目录中没有Markdown文件: " << inputDir << "\n";
+    return 1;
+  }
+
+  QTemporaryDir outputDir;
+  if (!outputDir.isValid()) {
+    out << "无法创建临时目录\n";
+    return 1;
+  }
+
+  out << QString("%1  %2  %3  %4  %5\n")
+             .arg("文件", -24)
+             .arg("本地引擎(ms)", 12)
+             .arg("pandoc(ms)", 12)
+             .arg("加速比", 8)
+             .arg("说明");
+
+  int supported = 0;
+  double nativeTotal = 0;
+  double pandocTotal = 0;
+
+  for (const QString &name : files) {
+    QString input = dir.absoluteFilePath(name);
+    QString nativeOutput =
+        QDir(outputDir.path()).absoluteFilePath(name + ".native.docx");
+    QString pandocOutput =
+        QDir(outputDir.path()).absoluteFilePath(name + ".pandoc.docx");
+
+    // 本地引擎
+    NativeDocxEngine engine(templateFile);
+    QList<double> nativeTimes;
+    QString note;
+    for (int i = 0; i < runs; ++i) {
+      QElapsedTimer timer;
+      timer.start();
+      NativeDocxEngine::Status status = engine.convert(input, nativeOutput);
+      double elapsed = timer.nsecsElapsed() / 1e6;
+      if (status != NativeDocxEngine::Converted) {
+        note = QString("回退到pandoc: %1").arg(engine.errorString());
+        nativeTimes.clear();
+        break;
+      }
+      nativeTimes.append(elapsed);
+    }
+
+    // pandoc
+    QStringList pandocArgs;
+    pandocArgs << input << "-o" << pandocOutput;
+    if (!templateFile.isEmpty()) {
+      pandocArgs << "--reference-doc" << templateFile;
+    }
+    QList<double> pandocTimes;
+    for (int i = 0; i < runs; ++i) {
+      QElapsedTimer timer;
+      timer.start();
+      QProcess process;
+      process.setWorkingDirectory(dir.absolutePath());
+      process.start(pandoc, pandocArgs);
+      if (!process.waitForFinished(60000) || process.exitCode() != 0) {
+        note += note.isEmpty() ? "pandoc转换失败" : "；pandoc转换失败";
+        pandocTimes.clear();
+        break;
+      }
+      pandocTimes.append(timer.nsecsElapsed() / 1e6);
+    }
+
+    double nativeMs = median(nativeTimes);
+    double pandocMs = median(pandocTimes);
+    QString speedup = "-";
+    if (!nativeTimes.isEmpty()) {
+      ++supported;
+      nativeTotal += nativeMs;
+      if (!pandocTimes.isEmpty()) {
+        pandocTotal += pandocMs;
+        speedup = QString("%1x").arg(pandocMs / qMax(nativeMs, 0.001), 0, 'f',
+                                     1);
+      }
+    }
+
+    out << QString("%1  %2  %3  %4  %5\n")
+               .arg(name, -24)
+               .arg(nativeTimes.isEmpty() ? QString("-")
+                                          : QString::number(nativeMs, 'f', 2),
+                    12)
+               .arg(pandocTimes.isEmpty() ? QString("-")
+                                          : QString::number(pandocMs, 'f', 2),
+                    12)
+               .arg(speedup, 8)
+               .arg(note);
+  }
+
+  out << QString("\n本地引擎处理 %1/%2 个文件，每个文件转换 %3 次取中位数\n")
+             .arg(supported)
+             .arg(files.size())
+             .arg(runs);
+  if (supported > 0 && pandocTotal > 0) {
+    out << QString("这些文件合计: 本地引擎 %1 ms，pandoc %2 ms\n")
+               .arg(nativeTotal, 0, 'f', 2)
+               .arg(pandocTotal, 0, 'f', 2);
+  }
+
+  return 0;
+}
@@ -1,6 +1,6 @@
 #include "aboutwidget.h"
 #include "appsettings.h"
-#include "embeddedserver.h"
+#include "embeddedserverpool.h"
 #include "httpapi.h"
 #include "multifileconverter.h"
 #include "settingswidget.h"
@@ -61,7 +61,7 @@ private slots:
 
     // 更新HTTP API的服务器地址
     if (m_httpApi && m_embeddedServer) {
-      m_httpApi->setServerUrl(m_embeddedServer->serverUrl());
+      m_httpApi->setServerUrls(m_embeddedServer->serverUrls());
     }
 
     // 隐藏进度条
@@ -88,6 +88,12 @@ private slots:
     updateServerStatus();
   }
 
+  void onServerStateChanged(const QString &state, const QString &detail) {
+    Q_UNUSED(state)
+    Q_UNUSED(detail)
+    updateServerStatus();
+  }
+
 private:
   void setupUI() {
     // 创建中央部件
@@ -134,17 +140,26 @@ private:
 
   void startEmbeddedServer() {
     if (!m_embeddedServer) {
-      m_embeddedServer = new EmbeddedServer(this);
+      m_embeddedServer = new EmbeddedServerPool(
+          AppSettings::instance()->getServerPoolSize(), this);
 
       // 连接信号
-      connect(m_embeddedServer, &EmbeddedServer::serverStarted, this,
+      connect(m_embeddedServer, &EmbeddedServerPool::serverStarted, this,
               &SimpleIntegratedMainWindow::onServerStarted);
-      connect(m_embeddedServer, &EmbeddedServer::serverStopped, this,
+      connect(m_embeddedServer, &EmbeddedServerPool::serverStopped, this,
               &SimpleIntegratedMainWindow::onServerStopped);
-      connect(m_embeddedServer, &EmbeddedServer::serverError, this,
+      connect(m_embeddedServer, &EmbeddedServerPool::serverError, this,
               &SimpleIntegratedMainWindow::onServerError);
-      connect(m_embeddedServer, &EmbeddedServer::healthCheckResult, this,
+      connect(m_embeddedServer, &EmbeddedServerPool::healthCheckResult, this,
               &SimpleIntegratedMainWindow::onServerHealthChanged);
+      // 后端进程重启或退出时更新HTTP API可用的服务器地址
+      connect(m_embeddedServer, &EmbeddedServerPool::serverStateChanged,
+              this, &SimpleIntegratedMainWindow::onServerStateChanged);
+      connect(m_embeddedServer, &EmbeddedServerPool::serverUrlsChanged,
+              m_httpApi, &HttpApi::setServerUrls);
+      // 有转换请求时才检查后端心跳
+      connect(m_httpApi, &HttpApi::backendLoadChanged, m_embeddedServer,
+              &EmbeddedServerPool::onBackendLoadChanged);
     }
 
     if (!m_embeddedServer->startServer()) {
@@ -164,7 +179,21 @@ private:
     if (!m_serverStatusLabel)
       return;
 
-    if (m_serverRunning) {
+    QString state =
+        m_embeddedServer ? m_embeddedServer->serverState() : QString();
+    if (m_serverRunning && state == "pandoc_missing") {
+      m_serverStatusLabel->setText("未找到Pandoc");
+      m_serverStatusLabel->setStyleSheet("color: red;");
+      m_statusLabel->setText(m_embeddedServer->serverStateDetail());
+    } else if (m_serverRunning && state == "draining") {
+      m_serverStatusLabel->setText("服务器正在停止");
+      m_serverStatusLabel->setStyleSheet("color: orange;");
+      m_statusLabel->setText("暂不接受新的转换");
+    } else if (m_serverRunning && state == "overloaded") {
+      m_serverStatusLabel->setText("服务器繁忙");
+      m_serverStatusLabel->setStyleSheet("color: orange;");
+      m_statusLabel->setText("准备就绪");
+    } else if (m_serverRunning) {
       m_serverStatusLabel->setText("服务器运行正常");
       m_serverStatusLabel->setStyleSheet("color: green;");
       m_statusLabel->setText("准备就绪");
@@ -176,7 +205,7 @@ private:
   }
 
 private:
-  EmbeddedServer *m_embeddedServer;
+  EmbeddedServerPool *m_embeddedServer;
   HttpApi *m_httpApi;
   QTabWidget *m_tabWidget;
   QLabel *m_statusLabel;
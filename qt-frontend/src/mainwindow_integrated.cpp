@@ -3,8 +3,10 @@
 #include "multifileconverter.h"
 #include "settingswidget.h"
 #include "aboutwidget.h"
+#include "serverlogviewer.h"
 #include "httpapi.h"
-#include "embeddedserver.h"
+#include "appsettings.h"
+#include "embeddedserverpool.h"
 
 #include <QApplication>
 #include <QTabWidget>
@@ -30,6 +32,7 @@ MainWindowIntegrated::MainWindowIntegrated(QWidget *parent)
     , m_multiConverter(nullptr)
     , m_settingsWidget(nullptr)
     , m_aboutWidget(nullptr)
+    , m_logViewer(nullptr)
     , m_statusLabel(nullptr)
     , m_serverStatusLabel(nullptr)
     , m_progressBar(nullptr)
@@ -92,11 +95,13 @@ void MainWindowIntegrated::setupUI()
     m_multiConverter = new MultiFileConverter(m_httpApi, this);
     m_settingsWidget = new SettingsWidget(m_httpApi, this);
     m_aboutWidget = new AboutWidget(this);
+    m_logViewer = new ServerLogViewer(this);
     
     // 添加标签页
     m_tabWidget->addTab(m_singleConverter, "单文件转换");
     m_tabWidget->addTab(m_multiConverter, "多文件转换");
     m_tabWidget->addTab(m_settingsWidget, "设置");
+    m_tabWidget->addTab(m_logViewer, "服务器日志");
     m_tabWidget->addTab(m_aboutWidget, "关于");
 }
 
@@ -119,6 +124,12 @@ void MainWindowIntegrated::setupMenuBar()
     });
     toolsMenu->addAction(settingsAction);
     
+    QAction *logAction = new QAction("服务器日志(&L)", this);
+    connect(logAction, &QAction::triggered, [this]() {
+        m_tabWidget->setCurrentWidget(m_logViewer);
+    });
+    toolsMenu->addAction(logAction);
+    
     // 帮助菜单
     QMenu *helpMenu = menuBar()->addMenu("帮助(&H)");
     
@@ -182,21 +193,33 @@ void MainWindowIntegrated::setupConnections()
 {
     // 连接嵌入式服务器信号
     if (m_embeddedServer) {
-        connect(m_embeddedServer, &EmbeddedServer::serverStarted, 
+        connect(m_embeddedServer, &EmbeddedServerPool::serverStarted, 
                 this, &MainWindowIntegrated::onServerStarted);
-        connect(m_embeddedServer, &EmbeddedServer::serverStopped, 
+        connect(m_embeddedServer, &EmbeddedServerPool::serverStopped, 
                 this, &MainWindowIntegrated::onServerStopped);
-        connect(m_embeddedServer, &EmbeddedServer::serverError, 
+        connect(m_embeddedServer, &EmbeddedServerPool::serverError, 
                 this, &MainWindowIntegrated::onServerError);
-        connect(m_embeddedServer, &EmbeddedServer::healthCheckResult, 
+        connect(m_embeddedServer, &EmbeddedServerPool::healthCheckResult, 
                 this, &MainWindowIntegrated::onServerHealthChanged);
+        connect(m_embeddedServer, &EmbeddedServerPool::serverStateChanged,
+                this, &MainWindowIntegrated::onServerStateChanged);
+        // 后端进程重启或退出时更新HTTP API可用的服务器地址
+        if (m_httpApi) {
+            connect(m_embeddedServer, &EmbeddedServerPool::serverUrlsChanged,
+                    m_httpApi, &HttpApi::setServerUrls);
+            // 有转换请求时才检查后端心跳
+            connect(m_httpApi, &HttpApi::backendLoadChanged,
+                    m_embeddedServer, &EmbeddedServerPool::onBackendLoadChanged);
+        }
     }
 }
 
 void MainWindowIntegrated::startEmbeddedServer()
 {
     if (!m_embeddedServer) {
-        m_embeddedServer = new EmbeddedServer(this);
+        m_embeddedServer = new EmbeddedServerPool(
+            AppSettings::instance()->getServerPoolSize(), this);
+        m_logViewer->setLogBuffer(m_embeddedServer->logBuffer());
         setupConnections();
     }
     
@@ -220,7 +243,7 @@ void MainWindowIntegrated::onServerStarted()
     
     // 更新HTTP API的服务器地址
     if (m_httpApi && m_embeddedServer) {
-        m_httpApi->setServerUrl(m_embeddedServer->serverUrl());
+        m_httpApi->setServerUrls(m_embeddedServer->serverUrls());
     }
     
     updateServerStatus();
@@ -252,6 +275,13 @@ void MainWindowIntegrated::onServerHealthChanged(bool isHealthy)
     updateServerStatus();
 }
 
+void MainWindowIntegrated::onServerStateChanged(const QString &state, const QString &detail)
+{
+    m_serverState = state;
+    m_serverStateDetail = detail;
+    updateServerStatus();
+}
+
 void MainWindowIntegrated::showMainWindow()
 {
     show();
@@ -274,9 +304,20 @@ void MainWindowIntegrated::updateServerStatus()
 {
     if (!m_serverStatusLabel) return;
     
+    m_serverStatusLabel->setToolTip(QString());
     if (m_startupInProgress) {
         m_serverStatusLabel->setText("服务器启动中...");
         m_serverStatusLabel->setStyleSheet("color: orange;");
+    } else if (m_serverRunning && m_serverState == "pandoc_missing") {
+        m_serverStatusLabel->setText("未找到Pandoc");
+        m_serverStatusLabel->setStyleSheet("color: red;");
+        m_serverStatusLabel->setToolTip(m_serverStateDetail);
+    } else if (m_serverRunning && m_serverState == "draining") {
+        m_serverStatusLabel->setText("服务器正在停止");
+        m_serverStatusLabel->setStyleSheet("color: orange;");
+    } else if (m_serverRunning && m_serverHealthy && m_serverState == "overloaded") {
+        m_serverStatusLabel->setText("服务器繁忙");
+        m_serverStatusLabel->setStyleSheet("color: orange;");
     } else if (m_serverRunning && m_serverHealthy) {
         m_serverStatusLabel->setText("服务器运行正常");
         m_serverStatusLabel->setStyleSheet("color: green;");
@@ -17,8 +17,9 @@ class SingleFileConverter;
 class MultiFileConverter;
 class SettingsWidget;
 class AboutWidget;
+class ServerLogViewer;
 class HttpApi;
-class EmbeddedServer;
+class EmbeddedServerPool;
 
 /**
  * 整合版主窗口
@@ -41,6 +42,7 @@ private slots:
   void onServerStopped();
   void onServerError(const QString &error);
   void onServerHealthChanged(bool isHealthy);
+  void onServerStateChanged(const QString &state, const QString &detail);
 
   // 应用控制
   void showMainWindow();
@@ -70,6 +72,7 @@ private:
   MultiFileConverter *m_multiConverter;
   SettingsWidget *m_settingsWidget;
   AboutWidget *m_aboutWidget;
+  ServerLogViewer *m_logViewer;
 
   // 状态栏
   QLabel *m_statusLabel;
@@ -83,12 +86,14 @@ private:
   QAction *m_quitAction;
 
   // 服务器和API
-  EmbeddedServer *m_embeddedServer;
+  EmbeddedServerPool *m_embeddedServer;
   HttpApi *m_httpApi;
 
   // 状态
   bool m_serverRunning;
   bool m_serverHealthy;
+  QString m_serverState;       // 后端推送的状态: ok、pandoc_missing、overloaded、draining
+  QString m_serverStateDetail;
   bool m_startupInProgress;
 
   // 定时器
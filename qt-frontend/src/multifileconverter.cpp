@@ -29,9 +29,10 @@ MultiFileConverter::MultiFileConverter(HttpApi *api, QWidget *parent)
       m_clearFilesButton(nullptr), m_fileCountLabel(nullptr),
       m_outputGroup(nullptr), m_outputDirEdit(nullptr),
       m_selectOutputButton(nullptr), m_actionGroup(nullptr),
-      m_convertButton(nullptr), m_resetButton(nullptr), m_statusGroup(nullptr),
-      m_statusText(nullptr), m_progressBar(nullptr), m_httpApi(api),
-      m_conversionInProgress(false) {
+      m_convertButton(nullptr), m_cancelButton(nullptr),
+      m_resetButton(nullptr), m_statusGroup(nullptr), m_statusText(nullptr),
+      m_progressBar(nullptr), m_httpApi(api), m_conversionInProgress(false),
+      m_requestId(0), m_finishedCount(0) {
   setupUI();
   setupConnections();
   updateUI();
@@ -90,6 +91,10 @@ void MultiFileConverter::setupUI() {
   m_convertButton->setEnabled(false);
   actionLayout->addWidget(m_convertButton);
 
+  m_cancelButton = new QPushButton("取消转换", this);
+  m_cancelButton->setEnabled(false);
+  actionLayout->addWidget(m_cancelButton);
+
   m_resetButton = new QPushButton("重置", this);
   actionLayout->addWidget(m_resetButton);
 
@@ -132,6 +137,8 @@ void MultiFileConverter::setupConnections() {
           &MultiFileConverter::selectOutputDir);
   connect(m_convertButton, &QPushButton::clicked, this,
           &MultiFileConverter::startBatchConversion);
+  connect(m_cancelButton, &QPushButton::clicked, this,
+          &MultiFileConverter::cancelBatchConversion);
   connect(m_resetButton, &QPushButton::clicked, this,
           &MultiFileConverter::resetForm);
 
@@ -141,6 +148,8 @@ void MultiFileConverter::setupConnections() {
 
   // HTTP API连接
   if (m_httpApi) {
+    connect(m_httpApi, &HttpApi::batchItemFinished, this,
+            &MultiFileConverter::onBatchItemFinished);
     connect(m_httpApi, &HttpApi::batchConversionFinished, this,
             &MultiFileConverter::onBatchConversionFinished);
   }
@@ -193,11 +202,13 @@ void MultiFileConverter::startBatchConversion() {
   }
 
   m_conversionInProgress = true;
+  m_finishedCount = 0;
   m_progressBar->setVisible(true);
   m_progressBar->setRange(0, m_inputFiles.size());
   m_progressBar->setValue(0);
   m_convertButton->setEnabled(false);
   m_convertButton->setText("转换中...");
+  m_cancelButton->setEnabled(true);
 
   // 清空之前的状态信息
   clearStatus();
@@ -225,16 +236,60 @@ void MultiFileConverter::startBatchConversion() {
     request.inputFiles = m_inputFiles;
     request.outputDir = m_outputDirEdit->text();
     request.templateFile = ""; // 暂时不使用模板
-    m_httpApi->convertBatch(request);
+    // 大文件先开始，避免排在最后拖长整批的完成时间
+    request.order = "longest_first";
+    m_requestId = m_httpApi->convertBatch(request);
+  }
+}
+
+void MultiFileConverter::cancelBatchConversion() {
+  if (!m_conversionInProgress || !m_httpApi || m_requestId == 0) {
+    return;
+  }
+
+  // 中止请求后服务器立即结束正在运行的pandoc进程，
+  // 未完成的文件随batchConversionFinished标记为已取消
+  m_cancelButton->setEnabled(false);
+  showStatus("正在取消转换...");
+  m_httpApi->cancel(m_requestId);
+}
+
+void MultiFileConverter::onBatchItemFinished(int index, int total,
+                                             const ConversionResult &result) {
+  Q_UNUSED(index);
+  if (!m_conversionInProgress) {
+    return;
+  }
+
+  m_finishedCount++;
+  m_progressBar->setRange(0, total);
+  m_progressBar->setValue(m_finishedCount);
+
+  if (result.status == "skipped") {
+    showStatus(QString("已是最新，跳过: %1")
+                   .arg(QFileInfo(result.inputFile).fileName()));
+  } else if (result.success) {
+    showStatus(QString("成功转换: %1 → %2")
+                   .arg(QFileInfo(result.inputFile).fileName(),
+                        QFileInfo(result.outputFile).fileName()));
+  } else {
+    showStatus(QString("转换失败: %1 - 错误: %2")
+                   .arg(QFileInfo(result.inputFile).fileName(), result.error),
+               true);
   }
 }
 
 void MultiFileConverter::onBatchConversionFinished(
     const ConversionResponse &response) {
+  // 逐个文件的结果已经在流式返回时显示过
+  bool itemsReported = m_finishedCount > 0;
+
   m_conversionInProgress = false;
+  m_requestId = 0;
   m_progressBar->setVisible(false);
   m_convertButton->setEnabled(true);
   m_convertButton->setText("开始批量转换");
+  m_cancelButton->setEnabled(false);
 
   if (response.success) {
     int successCount = 0;
@@ -243,11 +298,17 @@ void MultiFileConverter::onBatchConversionFinished(
     for (const auto &result : response.results) {
       if (result.success) {
         successCount++;
+      } else {
+        failCount++;
+      }
+      if (itemsReported) {
+        continue;
+      }
+      if (result.success) {
         showStatus(QString("成功转换: %1 → %2")
                        .arg(QFileInfo(result.inputFile).fileName(),
                             QFileInfo(result.outputFile).fileName()));
       } else {
-        failCount++;
         showStatus(
             QString("转换失败: %1 - 错误: %2")
                 .arg(QFileInfo(result.inputFile).fileName(), result.error),
@@ -295,7 +356,11 @@ void MultiFileConverter::onBatchConversionFinished(
 void MultiFileConverter::setEnabled(bool enabled) {
   QWidget::setEnabled(enabled);
   if (!enabled) {
+    if (m_conversionInProgress && m_httpApi && m_requestId != 0) {
+      m_httpApi->cancel(m_requestId);
+    }
     m_conversionInProgress = false;
+    m_requestId = 0;
     m_progressBar->setVisible(false);
     m_convertButton->setText("开始批量转换");
   }
@@ -303,6 +368,8 @@ void MultiFileConverter::setEnabled(bool enabled) {
 }
 
 void MultiFileConverter::resetForm() {
+  // 重置时不再需要进行中的转换结果
+  cancelBatchConversion();
   clearAllFiles();
   m_outputDirEdit->clear();
   clearStatus();
@@ -324,6 +391,7 @@ void MultiFileConverter::updateUI() {
                                  isEnabled());
   m_selectOutputButton->setEnabled(!m_conversionInProgress && isEnabled());
   m_resetButton->setEnabled(!m_conversionInProgress && isEnabled());
+  m_cancelButton->setEnabled(m_conversionInProgress && m_requestId != 0);
 
   // 更新文件计数标签
   m_fileCountLabel->setText(
@@ -18,6 +18,7 @@ QT_END_NAMESPACE
 
 class HttpApi;
 struct ConversionResponse;
+struct ConversionResult;
 
 /**
  * @brief 多文件转换器组件
@@ -27,6 +28,7 @@ struct ConversionResponse;
  * - 设置统一输出路径
  * - 批量执行转换操作
  * - 显示转换进度和状态
+ * - 取消进行中的转换
  */
 class MultiFileConverter : public QWidget {
   Q_OBJECT
@@ -49,8 +51,11 @@ private slots:
   void clearAllFiles();
   void selectOutputDir();
   void startBatchConversion();
+  void cancelBatchConversion();
   void onFileListChanged();
   void onOutputDirChanged();
+  void onBatchItemFinished(int index, int total,
+                           const ConversionResult &result);
   void onBatchConversionFinished(const ConversionResponse &response);
 
 private:
@@ -77,6 +82,7 @@ private:
 
   QGroupBox *m_actionGroup;
   QPushButton *m_convertButton;
+  QPushButton *m_cancelButton;
   QPushButton *m_resetButton;
 
   QGroupBox *m_statusGroup;
@@ -88,6 +94,8 @@ private:
 
   // 状态变量
   bool m_conversionInProgress;
+  int m_requestId; // 进行中的批量转换请求ID，用于取消
+  int m_finishedCount; // 本次批量转换中已返回结果的文件数
   QStringList m_inputFiles;
   QString m_lastOutputDir;
 };
@@ -0,0 +1,1347 @@
+#include "nativedocxengine.h"
+#include "ziparchive.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QImageReader>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QUrl>
+
+namespace {
+
+// 以下常量和样式名称与pandoc的docx输出保持一致
+const char *const NS_W =
+    "http://schemas.openxmlformats.org/wordprocessingml/2006/main";
+const char *const NS_R =
+    "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+const char *const REL_TYPE_BASE =
+    "http://schemas.openxmlformats.org/officeDocument/2006/relationships/";
+
+const int EMU_PER_INCH = 914400;
+const int EMU_PER_TWIP = 635;
+const int PANDOC_COLUMNS = 72; // 管道表格行超过该宽度时pandoc会计算相对列宽
+
+// 没有指定模板时使用的默认页面设置（Letter，四边1英寸，与pandoc默认模板一致）
+const char *const DEFAULT_SECT_PR =
+    "<w:sectPr><w:pgSz w:w=\"12240\" w:h=\"15840\"/>"
+    "<w:pgMar w:top=\"1440\" w:right=\"1440\" w:bottom=\"1440\" "
+    "w:left=\"1440\" w:header=\"720\" w:footer=\"720\" w:gutter=\"0\"/>"
+    "</w:sectPr>";
+
+// 没有指定模板时使用的默认样式，样式ID与pandoc参考模板相同，
+// 之后切换到自定义模板时同一文档的外观可以直接对应
+const char *const DEFAULT_STYLES = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<w:styles xmlns:w="http://schemas.openxmlformats.org/wordprocessingml/2006/main">
+<w:docDefaults>
+<w:rPrDefault><w:rPr><w:rFonts w:ascii="Cambria" w:hAnsi="Cambria" w:cs="Times New Roman"/><w:sz w:val="24"/><w:szCs w:val="24"/><w:lang w:val="en-US" w:eastAsia="zh-CN"/></w:rPr></w:rPrDefault>
+<w:pPrDefault><w:pPr><w:spacing w:after="200"/></w:pPr></w:pPrDefault>
+</w:docDefaults>
+<w:style w:type="paragraph" w:default="1" w:styleId="Normal"><w:name w:val="Normal"/><w:qFormat/></w:style>
+<w:style w:type="paragraph" w:styleId="BodyText"><w:name w:val="Body Text"/><w:basedOn w:val="Normal"/><w:qFormat/><w:pPr><w:spacing w:before="180" w:after="180"/></w:pPr></w:style>
+<w:style w:type="paragraph" w:customStyle="1" w:styleId="FirstParagraph"><w:name w:val="First Paragraph"/><w:basedOn w:val="BodyText"/><w:next w:val="BodyText"/><w:qFormat/></w:style>
+<w:style w:type="paragraph" w:customStyle="1" w:styleId="Compact"><w:name w:val="Compact"/><w:basedOn w:val="BodyText"/><w:qFormat/><w:pPr><w:spacing w:before="36" w:after="36"/></w:pPr></w:style>
+<w:style w:type="paragraph" w:styleId="Title"><w:name w:val="Title"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="480" w:after="240"/><w:jc w:val="center"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:b/><w:bCs/><w:color w:val="345A8A"/><w:sz w:val="36"/><w:szCs w:val="36"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading1"><w:name w:val="heading 1"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="480" w:after="0"/><w:outlineLvl w:val="0"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:b/><w:bCs/><w:color w:val="4F81BD"/><w:sz w:val="32"/><w:szCs w:val="32"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading2"><w:name w:val="heading 2"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:unhideWhenUsed/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="200" w:after="0"/><w:outlineLvl w:val="1"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:b/><w:bCs/><w:color w:val="4F81BD"/><w:sz w:val="28"/><w:szCs w:val="28"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading3"><w:name w:val="heading 3"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:unhideWhenUsed/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="200" w:after="0"/><w:outlineLvl w:val="2"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:b/><w:bCs/><w:color w:val="4F81BD"/><w:sz w:val="24"/><w:szCs w:val="24"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading4"><w:name w:val="heading 4"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:unhideWhenUsed/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="200" w:after="0"/><w:outlineLvl w:val="3"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:bCs/><w:i/><w:color w:val="4F81BD"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading5"><w:name w:val="heading 5"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:unhideWhenUsed/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="200" w:after="0"/><w:outlineLvl w:val="4"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:iCs/><w:color w:val="4F81BD"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:styleId="Heading6"><w:name w:val="heading 6"/><w:basedOn w:val="Normal"/><w:next w:val="BodyText"/><w:uiPriority w:val="9"/><w:unhideWhenUsed/><w:qFormat/><w:pPr><w:keepNext/><w:keepLines/><w:spacing w:before="200" w:after="0"/><w:outlineLvl w:val="5"/></w:pPr><w:rPr><w:rFonts w:ascii="Calibri" w:hAnsi="Calibri"/><w:color w:val="4F81BD"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:customStyle="1" w:styleId="SourceCode"><w:name w:val="Source Code"/><w:basedOn w:val="Normal"/><w:link w:val="VerbatimChar"/><w:pPr><w:wordWrap w:val="off"/></w:pPr><w:rPr><w:rFonts w:ascii="Consolas" w:hAnsi="Consolas"/><w:sz w:val="22"/></w:rPr></w:style>
+<w:style w:type="paragraph" w:customStyle="1" w:styleId="CaptionedFigure"><w:name w:val="Captioned Figure"/><w:basedOn w:val="Normal"/><w:pPr><w:keepNext/></w:pPr></w:style>
+<w:style w:type="paragraph" w:customStyle="1" w:styleId="ImageCaption"><w:name w:val="Image Caption"/><w:basedOn w:val="Normal"/><w:pPr><w:spacing w:before="0" w:after="120"/></w:pPr><w:rPr><w:i/></w:rPr></w:style>
+<w:style w:type="character" w:default="1" w:styleId="DefaultParagraphFont"><w:name w:val="Default Paragraph Font"/><w:uiPriority w:val="1"/><w:semiHidden/><w:unhideWhenUsed/></w:style>
+<w:style w:type="character" w:customStyle="1" w:styleId="VerbatimChar"><w:name w:val="Verbatim Char"/><w:basedOn w:val="DefaultParagraphFont"/><w:link w:val="SourceCode"/><w:rPr><w:rFonts w:ascii="Consolas" w:hAnsi="Consolas"/><w:sz w:val="22"/></w:rPr></w:style>
+<w:style w:type="table" w:default="1" w:styleId="Table"><w:name w:val="Table"/><w:semiHidden/><w:unhideWhenUsed/><w:qFormat/><w:tblPr><w:tblInd w:w="0" w:type="dxa"/><w:tblCellMar><w:top w:w="0" w:type="dxa"/><w:left w:w="108" w:type="dxa"/><w:bottom w:w="0" w:type="dxa"/><w:right w:w="108" w:type="dxa"/></w:tblCellMar></w:tblPr></w:style>
+</w:styles>
+)";
+
+// 可以从模板中原样复制的部件及其内容类型
+struct TemplatePart {
+  const char *name;
+  const char *contentType;
+  const char *relType;
+};
+
+const TemplatePart TEMPLATE_PARTS[] = {
+    {"word/styles.xml",
+     "application/vnd.openxmlformats-officedocument.wordprocessingml.styles+xml",
+     "styles"},
+    {"word/theme/theme1.xml",
+     "application/vnd.openxmlformats-officedocument.theme+xml", "theme"},
+    {"word/fontTable.xml",
+     "application/"
+     "vnd.openxmlformats-officedocument.wordprocessingml.fontTable+xml",
+     "fontTable"},
+    {"word/settings.xml",
+     "application/"
+     "vnd.openxmlformats-officedocument.wordprocessingml.settings+xml",
+     "settings"},
+    {"word/webSettings.xml",
+     "application/"
+     "vnd.openxmlformats-officedocument.wordprocessingml.webSettings+xml",
+     "webSettings"},
+};
+
+// 块级元素
+struct Block {
+  enum Type { Heading, Paragraph, BulletList, OrderedList, CodeBlock, Table };
+
+  Type type = Paragraph;
+  int level = 0;             // 标题级别
+  int start = 1;             // 有序列表起始编号
+  QChar marker;              // 列表标记（'-'、'*'、'+'，或有序列表的'.'、')'）
+  QStringList lines;         // 段落和代码块的行；列表时为每个条目的文本
+  QList<QStringList> rows;   // 表格各行单元格，第一行为表头
+  QStringList alignments;    // 表格各列对齐方式
+};
+
+// 引用的本地图片
+struct Media {
+  QString path;
+  QString partName; // word/目录下的部件名
+  QString relId;
+  QString extension;
+  qint64 cx = 0; // 显示尺寸（EMU）
+  qint64 cy = 0;
+};
+
+// ---------------------------------------------------------------------------
+// 块级解析
+// ---------------------------------------------------------------------------
+
+const QRegularExpression &headingPattern() {
+  static const QRegularExpression pattern("^(#{1,6})(?:[ \\t]+(.*))?$");
+  return pattern;
+}
+
+const QRegularExpression &bulletPattern() {
+  static const QRegularExpression pattern("^([-*+])[ \\t]+(.*)$");
+  return pattern;
+}
+
+const QRegularExpression &orderedPattern() {
+  static const QRegularExpression pattern("^(\\d{1,9})([.)])[ \\t]+(.*)$");
+  return pattern;
+}
+
+const QRegularExpression &fencePattern() {
+  static const QRegularExpression pattern("^(`{3,}|~{3,})(.*)$");
+  return pattern;
+}
+
+const QRegularExpression &rulePattern() {
+  static const QRegularExpression pattern("^([-*_])[ \\t]*(?:\\1[ \\t]*){2,}$");
+  return pattern;
+}
+
+const QRegularExpression &setextPattern() {
+  static const QRegularExpression pattern("^(?:=+|-+)[ \\t]*$");
+  return pattern;
+}
+
+const QRegularExpression &tableSeparatorPattern() {
+  static const QRegularExpression pattern(
+      "^\\|?[ \\t]*:?-+:?[ \\t]*(?:\\|[ \\t]*:?-+:?[ \\t]*)*\\|?[ \\t]*$");
+  return pattern;
+}
+
+// pandoc的fancy_lists/example_lists会把这些开头识别为列表
+const QRegularExpression &fancyListPattern() {
+  static const QRegularExpression pattern(
+      "^(?:\\(?(?:[A-Za-z]|[ivxlcdm]+|[IVXLCDM]+)[.)]|\\(\\d+\\)|\\(?#[.)])"
+      "[ \\t]");
+  return pattern;
+}
+
+const QRegularExpression &gridTablePattern() {
+  static const QRegularExpression pattern("^\\+[-=+:]+[ \\t]*$");
+  return pattern;
+}
+
+int leadingIndent(const QString &line) {
+  int indent = 0;
+  for (QChar c : line) {
+    if (c == ' ') {
+      indent += 1;
+    } else if (c == '\t') {
+      indent += 4 - indent % 4;
+    } else {
+      break;
+    }
+  }
+  return indent;
+}
+
+QString stripIndent(const QString &line) {
+  int i = 0;
+  while (i < line.size() && (line.at(i) == ' ' || line.at(i) == '\t')) {
+    ++i;
+  }
+  return line.mid(i);
+}
+
+bool startsBlock(const QString &content) {
+  return content.startsWith('#') || content.startsWith('>') ||
+         content.startsWith('|') || content.startsWith('<') ||
+         content.startsWith("```") || content.startsWith("~~~") ||
+         bulletPattern().match(content).hasMatch() ||
+         orderedPattern().match(content).hasMatch() ||
+         rulePattern().match(content).hasMatch();
+}
+
+QStringList splitTableRow(const QString &line) {
+  QString row = line.trimmed();
+  if (row.startsWith('|')) {
+    row.remove(0, 1);
+  }
+  if (row.endsWith('|')) {
+    row.chop(1);
+  }
+  QStringList cells = row.split('|');
+  for (QString &cell : cells) {
+    cell = cell.trimmed();
+  }
+  return cells;
+}
+
+bool fail(QString *reason, const QString &message) {
+  if (reason) {
+    *reason = message;
+  }
+  return false;
+}
+
+/**
+ * 把Markdown解析为块级元素
+ * 只接受能够与pandoc输出保持一致的写法，其余情况返回false和原因
+ */
+bool parseBlocks(const QString &markdown, QList<Block> *blocks,
+                 QString *reason) {
+  QString text = markdown;
+  if (text.startsWith(QChar(0xfeff))) {
+    text.remove(0, 1);
+  }
+  text.replace("\r\n", "\n");
+  text.replace('\r', '\n');
+
+  for (QChar c : text) {
+    if (c.unicode() < 0x20 && c != '\n' && c != '\t') {
+      return fail(reason, "包含控制字符");
+    }
+  }
+
+  const QStringList lines = text.split('\n');
+  if (!lines.isEmpty() &&
+      (lines.first().startsWith("---") || lines.first().startsWith('%'))) {
+    return fail(reason, "文档元数据块");
+  }
+
+  enum State { None, InParagraph, InList };
+  State state = None;
+  bool blankInList = false;
+
+  for (int i = 0; i < lines.size(); ++i) {
+    const QString &line = lines.at(i);
+
+    if (line.trimmed().isEmpty()) {
+      if (state == InList) {
+        blankInList = true;
+      } else {
+        state = None;
+      }
+      continue;
+    }
+
+    int indent = leadingIndent(line);
+    QString content = stripIndent(line);
+
+    if (state == InList) {
+      Block &list = blocks->last();
+      QRegularExpressionMatch bullet = bulletPattern().match(content);
+      QRegularExpressionMatch ordered = orderedPattern().match(content);
+      bool sameKind =
+          (list.type == Block::BulletList && bullet.hasMatch() &&
+           bullet.captured(1).at(0) == list.marker) ||
+          (list.type == Block::OrderedList && ordered.hasMatch() &&
+           ordered.captured(2).at(0) == list.marker);
+
+      if (blankInList) {
+        if (indent > 0 || sameKind) {
+          return fail(reason, "松散列表或列表项包含多个段落");
+        }
+        state = None;
+      } else {
+        if (indent > 0) {
+          return fail(reason, "嵌套列表");
+        }
+        if (sameKind) {
+          list.lines.append(list.type == Block::BulletList
+                                ? bullet.captured(2)
+                                : ordered.captured(3));
+          continue;
+        }
+        if (startsBlock(content) || fancyListPattern().match(content).hasMatch()) {
+          return fail(reason, "列表后紧跟其他块级元素");
+        }
+        // 懒惰续行，属于上一个列表项
+        list.lines.last().append('\n').append(content);
+        continue;
+      }
+    }
+
+    if (state == InParagraph) {
+      if (setextPattern().match(content).hasMatch()) {
+        return fail(reason, "Setext风格标题");
+      }
+      if (startsBlock(content) || fancyListPattern().match(content).hasMatch()) {
+        return fail(reason, "段落后紧跟块级元素而没有空行");
+      }
+      blocks->last().lines.append(line);
+      continue;
+    }
+
+    // 新的块级元素
+    if (indent >= 4) {
+      return fail(reason, "缩进代码块");
+    }
+
+    QRegularExpressionMatch match = fencePattern().match(content);
+    if (match.hasMatch()) {
+      if (indent > 0) {
+        return fail(reason, "缩进的代码块围栏");
+      }
+      if (!match.captured(2).trimmed().isEmpty()) {
+        return fail(reason, "带语言标记的代码块（需要语法高亮）");
+      }
+      QString fence = match.captured(1);
+      Block code;
+      code.type = Block::CodeBlock;
+      bool closed = false;
+      for (++i; i < lines.size(); ++i) {
+        QString closing = lines.at(i).trimmed();
+        if (leadingIndent(lines.at(i)) < 4 && closing.size() >= fence.size() &&
+            closing == QString(closing.size(), fence.at(0))) {
+          closed = true;
+          break;
+        }
+        code.lines.append(lines.at(i));
+      }
+      if (!closed) {
+        return fail(reason, "代码块未闭合");
+      }
+      blocks->append(code);
+      state = None;
+      continue;
+    }
+
+    match = headingPattern().match(content);
+    if (match.hasMatch()) {
+      QString title = match.captured(2).trimmed();
+      // 去掉结尾的闭合井号
+      static const QRegularExpression closingHashes("(?:^|[ \\t]+)#+$");
+      title.remove(closingHashes);
+      if (title.endsWith('}')) {
+        return fail(reason, "标题属性");
+      }
+      Block heading;
+      heading.type = Block::Heading;
+      heading.level = match.captured(1).size();
+      heading.lines.append(title);
+      blocks->append(heading);
+      state = None;
+      continue;
+    }
+
+    if (content.startsWith('>')) {
+      return fail(reason, "引用块");
+    }
+    if (content.startsWith('<')) {
+      return fail(reason, "HTML块");
+    }
+    if (content.startsWith(':') || content.startsWith('~') ||
+        content.startsWith("Table:")) {
+      return fail(reason, "定义列表或表格标题");
+    }
+    if (rulePattern().match(content).hasMatch()) {
+      return fail(reason, "分隔线或简单表格");
+    }
+    if (gridTablePattern().match(content).hasMatch()) {
+      return fail(reason, "网格表格");
+    }
+    if (fancyListPattern().match(content).hasMatch()) {
+      return fail(reason, "字母或罗马数字列表");
+    }
+
+    if (content.startsWith('|')) {
+      if (i + 1 >= lines.size() ||
+          !tableSeparatorPattern().match(lines.at(i + 1).trimmed()).hasMatch()) {
+        return fail(reason, "行块");
+      }
+
+      Block table;
+      table.type = Block::Table;
+      QStringList header = splitTableRow(content);
+      QStringList separators = splitTableRow(lines.at(i + 1));
+      if (header.size() != separators.size()) {
+        return fail(reason, "表头与分隔行列数不一致");
+      }
+      for (const QString &separator : separators) {
+        bool left = separator.startsWith(':');
+        bool right = separator.endsWith(':');
+        table.alignments.append(left && right ? "center"
+                                : right       ? "right"
+                                : left        ? "left"
+                                              : "");
+      }
+      table.rows.append(header);
+
+      int columns = header.size();
+      int widest = qMax(line.size(), lines.at(i + 1).size());
+      for (i += 2; i < lines.size() && lines.at(i).trimmed().startsWith('|');
+           ++i) {
+        QStringList cells = splitTableRow(lines.at(i));
+        while (cells.size() < columns) {
+          cells.append(QString());
+        }
+        while (cells.size() > columns) {
+          cells.removeLast();
+        }
+        table.rows.append(cells);
+        widest = qMax(widest, lines.at(i).size());
+      }
+      --i;
+
+      if (widest > PANDOC_COLUMNS) {
+        return fail(reason, "表格行过长（需要pandoc计算列宽）");
+      }
+      blocks->append(table);
+      state = None;
+      continue;
+    }
+
+    QRegularExpressionMatch bullet = bulletPattern().match(content);
+    QRegularExpressionMatch ordered = orderedPattern().match(content);
+    if (bullet.hasMatch() || ordered.hasMatch()) {
+      if (indent > 0) {
+        return fail(reason, "缩进的列表");
+      }
+      Block list;
+      if (bullet.hasMatch()) {
+        list.type = Block::BulletList;
+        list.marker = bullet.captured(1).at(0);
+        list.lines.append(bullet.captured(2));
+      } else {
+        list.type = Block::OrderedList;
+        list.start = ordered.captured(1).toInt();
+        list.marker = ordered.captured(2).at(0);
+        list.lines.append(ordered.captured(3));
+      }
+      blocks->append(list);
+      state = InList;
+      blankInList = false;
+      continue;
+    }
+
+    Block paragraph;
+    paragraph.type = Block::Paragraph;
+    paragraph.lines.append(line);
+    blocks->append(paragraph);
+    state = InParagraph;
+  }
+
+  return true;
+}
+
+/**
+ * 把段落的多行文本合并为行内解析的输入
+ * 软换行记为'\n'（输出为空格），行尾两个以上空格的硬换行记为'\r'
+ */
+QString joinLines(const QStringList &lines) {
+  QString joined;
+  for (int i = 0; i < lines.size(); ++i) {
+    QString line = stripIndent(lines.at(i));
+    bool hardBreak = line.endsWith("  ");
+    while (line.endsWith(' ') || line.endsWith('\t')) {
+      line.chop(1);
+    }
+    joined.append(line);
+    if (i + 1 < lines.size()) {
+      joined.append(hardBreak ? '\r' : '\n');
+    }
+  }
+  return joined;
+}
+
+int runLength(const QString &text, int pos, QChar c) {
+  int end = pos;
+  while (end < text.size() && text.at(end) == c) {
+    ++end;
+  }
+  return end - pos;
+}
+
+// ---------------------------------------------------------------------------
+// document.xml生成
+// ---------------------------------------------------------------------------
+
+class DocxBuilder {
+public:
+  DocxBuilder(const QString &inputDir, qint64 maxWidth, qint64 maxHeight)
+      : m_inputDir(inputDir), m_maxWidth(maxWidth), m_maxHeight(maxHeight),
+        m_docPrId(0) {}
+
+  bool render(const QList<Block> &blocks, QString *reason);
+
+  QString documentXml(const QString &sectPr) const;
+  QString numberingXml() const;
+  const QList<Media> &media() const { return m_media; }
+
+private:
+  bool renderInlines(const QString &text, bool bold, bool italic,
+                     QString *out, QString *reason);
+  bool renderImage(const QString &alt, const QString &target, QString *out,
+                   QString *reason);
+  int findClosingDelimiter(const QString &text, int from, QChar c,
+                           int length) const;
+  int addNumbering(const Block &list);
+
+  static QString paragraph(const QString &style, const QString &runs,
+                           const QString &extraProperties = QString());
+  static QString textRun(const QString &text, bool bold, bool italic);
+  static QString codeRun(const QString &text, bool bold, bool italic);
+
+  QString m_inputDir;
+  qint64 m_maxWidth;
+  qint64 m_maxHeight;
+  QString m_body;
+  QString m_abstractNums;
+  QString m_nums;
+  int m_numCount = 0;
+  QList<Media> m_media;
+  QHash<QString, int> m_mediaIndex; // 图片绝对路径 -> m_media中的序号
+  int m_docPrId;
+};
+
+bool DocxBuilder::render(const QList<Block> &blocks, QString *reason) {
+  static const QRegularExpression figurePattern(
+      "^!\\[([^\\[\\]]+)\\]\\(([^()\\s]+)\\)$");
+
+  bool afterHeading = false;
+  for (const Block &block : blocks) {
+    QString runs;
+    switch (block.type) {
+    case Block::Heading:
+      if (!renderInlines(block.lines.first(), false, false, &runs, reason)) {
+        return false;
+      }
+      m_body += paragraph(QString("Heading%1").arg(block.level), runs);
+      break;
+
+    case Block::Paragraph: {
+      QString text = joinLines(block.lines);
+      QRegularExpressionMatch figure = figurePattern.match(text);
+      if (figure.hasMatch()) {
+        // 单独成段且有替代文本的图片按pandoc的implicit_figures输出为带题注的图
+        QString caption;
+        if (!renderImage(figure.captured(1), figure.captured(2), &runs,
+                         reason) ||
+            !renderInlines(figure.captured(1), false, false, &caption,
+                           reason)) {
+          return false;
+        }
+        m_body += paragraph("CaptionedFigure", runs);
+        m_body += paragraph("ImageCaption", caption);
+        break;
+      }
+      if (!renderInlines(text, false, false, &runs, reason)) {
+        return false;
+      }
+      m_body += paragraph(afterHeading ? "FirstParagraph" : "BodyText", runs);
+      break;
+    }
+
+    case Block::BulletList:
+    case Block::OrderedList: {
+      QString numPr = QString("<w:numPr><w:ilvl w:val=\"0\"/>"
+                              "<w:numId w:val=\"%1\"/></w:numPr>")
+                          .arg(addNumbering(block));
+      for (const QString &item : block.lines) {
+        runs.clear();
+        if (!renderInlines(joinLines(item.split('\n')), false, false, &runs,
+                           reason)) {
+          return false;
+        }
+        m_body += paragraph("Compact", runs, numPr);
+      }
+      break;
+    }
+
+    case Block::CodeBlock:
+      for (int i = 0; i < block.lines.size(); ++i) {
+        if (i > 0) {
+          runs += "<w:r><w:br/></w:r>";
+        }
+        const QStringList pieces = block.lines.at(i).split('\t');
+        for (int j = 0; j < pieces.size(); ++j) {
+          if (j > 0) {
+            runs += "<w:r><w:rPr><w:rStyle w:val=\"VerbatimChar\"/></w:rPr>"
+                    "<w:tab/></w:r>";
+          }
+          if (!pieces.at(j).isEmpty()) {
+            runs += codeRun(pieces.at(j), false, false);
+          }
+        }
+      }
+      m_body += paragraph("SourceCode", runs);
+      break;
+
+    case Block::Table: {
+      int columns = block.alignments.size();
+      m_body += "<w:tbl><w:tblPr><w:tblStyle w:val=\"Table\"/>"
+                "<w:tblW w:type=\"auto\" w:w=\"0\"/>"
+                "<w:tblLook w:firstRow=\"1\" w:lastRow=\"0\" "
+                "w:firstColumn=\"0\" w:lastColumn=\"0\" w:noHBand=\"0\" "
+                "w:noVBand=\"0\" w:val=\"0020\"/></w:tblPr><w:tblGrid>";
+      for (int c = 0; c < columns; ++c) {
+        m_body += "<w:gridCol/>";
+      }
+      m_body += "</w:tblGrid>";
+
+      for (int r = 0; r < block.rows.size(); ++r) {
+        bool header = r == 0;
+        m_body += header ? "<w:tr><w:trPr><w:tblHeader/></w:trPr>" : "<w:tr>";
+        for (int c = 0; c < columns; ++c) {
+          runs.clear();
+          if (!renderInlines(block.rows.at(r).at(c), false, false, &runs,
+                             reason)) {
+            return false;
+          }
+          QString jc = block.alignments.at(c).isEmpty()
+                           ? QString()
+                           : QString("<w:jc w:val=\"%1\"/>")
+                                 .arg(block.alignments.at(c));
+          m_body += "<w:tc>";
+          if (header) {
+            m_body += "<w:tcPr><w:tcBorders><w:bottom w:val=\"single\"/>"
+                      "</w:tcBorders><w:vAlign w:val=\"bottom\"/></w:tcPr>";
+          }
+          m_body += paragraph("Compact", runs, jc);
+          m_body += "</w:tc>";
+        }
+        m_body += "</w:tr>";
+      }
+      m_body += "</w:tbl>";
+      break;
+    }
+    }
+
+    afterHeading = block.type == Block::Heading;
+  }
+
+  return true;
+}
+
+bool DocxBuilder::renderInlines(const QString &text, bool bold, bool italic,
+                                QString *out, QString *reason) {
+  QString buffer;
+  auto flush = [&]() {
+    if (!buffer.isEmpty()) {
+      out->append(textRun(buffer, bold, italic));
+      buffer.clear();
+    }
+  };
+
+  static const QRegularExpression entityPattern(
+      "^&(?:#\\d+|#[xX][0-9a-fA-F]+|[A-Za-z][A-Za-z0-9]*);");
+
+  const int n = text.size();
+  for (int i = 0; i < n; ++i) {
+    QChar c = text.at(i);
+    QChar prev = i > 0 ? text.at(i - 1) : QChar(' ');
+    QChar next = i + 1 < n ? text.at(i + 1) : QChar(' ');
+
+    switch (c.unicode()) {
+    case '\n':
+    case '\t':
+      buffer.append(' ');
+      break;
+
+    case '\r':
+      flush();
+      out->append("<w:r><w:br/></w:r>");
+      break;
+
+    case '`': {
+      int ticks = runLength(text, i, c);
+      int close = i + ticks;
+      while ((close = text.indexOf(QString(ticks, '`'), close)) >= 0 &&
+             runLength(text, close, c) != ticks) {
+        close += runLength(text, close, c);
+      }
+      if (close < 0) {
+        buffer.append(QString(ticks, '`'));
+        i += ticks - 1;
+        break;
+      }
+      QString code = text.mid(i + ticks, close - i - ticks);
+      code.replace('\n', ' ').replace('\r', ' ');
+      flush();
+      out->append(codeRun(code.trimmed(), bold, italic));
+      i = close + ticks - 1;
+      break;
+    }
+
+    case '!': {
+      if (next != '[') {
+        buffer.append(c);
+        break;
+      }
+      int altEnd = text.indexOf(']', i + 2);
+      if (altEnd < 0 || text.mid(i + 2, altEnd - i - 2).contains('[')) {
+        return fail(reason, "图片替代文本包含方括号");
+      }
+      if (altEnd + 1 >= n || text.at(altEnd + 1) != '(') {
+        return fail(reason, "引用式图片");
+      }
+      int close = text.indexOf(')', altEnd + 2);
+      if (close < 0) {
+        return fail(reason, "图片语法不完整");
+      }
+      if (close + 1 < n && text.at(close + 1) == '{') {
+        return fail(reason, "图片属性");
+      }
+      flush();
+      if (!renderImage(text.mid(i + 2, altEnd - i - 2),
+                       text.mid(altEnd + 2, close - altEnd - 2), out,
+                       reason)) {
+        return false;
+      }
+      i = close;
+      break;
+    }
+
+    case '*':
+    case '_': {
+      int length = runLength(text, i, c);
+      if (length >= 3) {
+        return fail(reason, "三重强调");
+      }
+      QChar after = i + length < n ? text.at(i + length) : QChar(' ');
+      // 下划线在单词内部不表示强调
+      bool canOpen =
+          !after.isSpace() && (c == '*' || !prev.isLetterOrNumber());
+      int close = canOpen ? findClosingDelimiter(text, i + length, c, length)
+                          : -1;
+      if (close < 0) {
+        buffer.append(QString(length, c));
+        i += length - 1;
+        break;
+      }
+      flush();
+      if (!renderInlines(text.mid(i + length, close - i - length),
+                         bold || length == 2, italic || length == 1, out,
+                         reason)) {
+        return false;
+      }
+      i = close + length - 1;
+      break;
+    }
+
+    // pandoc默认启用smart扩展，这里做同样的排版替换
+    case '-':
+      if (text.mid(i, 3) == "---") {
+        buffer.append(QChar(0x2014));
+        i += 2;
+      } else if (next == '-') {
+        buffer.append(QChar(0x2013));
+        i += 1;
+      } else {
+        buffer.append(c);
+      }
+      break;
+
+    case '.':
+      if (text.mid(i, 3) == "...") {
+        buffer.append(QChar(0x2026));
+        i += 2;
+      } else {
+        buffer.append(c);
+      }
+      break;
+
+    case '"':
+      buffer.append(
+          (prev.isSpace() || prev == '(' || prev == '[') && !next.isSpace()
+              ? QChar(0x201c)
+              : QChar(0x201d));
+      break;
+
+    case '\'':
+      buffer.append(!prev.isLetterOrNumber() &&
+                            (!prev.isPunct() || prev == '(' || prev == '[') &&
+                            !next.isSpace()
+                        ? QChar(0x2018)
+                        : QChar(0x2019));
+      break;
+
+    case '[':
+      return fail(reason, "链接、脚注或引用");
+    case '<':
+      return fail(reason, "HTML标签或自动链接");
+    case '\\':
+      return fail(reason, "转义字符或行尾反斜杠换行");
+    case '$':
+      return fail(reason, "数学公式");
+    case '~':
+      return fail(reason, "删除线或下标");
+    case '^':
+      return fail(reason, "上标");
+
+    case '@':
+      if (!prev.isLetterOrNumber() && next.isLetterOrNumber()) {
+        return fail(reason, "文献引用");
+      }
+      buffer.append(c);
+      break;
+
+    case '&':
+      if (entityPattern.match(text.mid(i, 12)).hasMatch()) {
+        return fail(reason, "HTML实体");
+      }
+      buffer.append(c);
+      break;
+
+    default:
+      buffer.append(c);
+      break;
+    }
+  }
+
+  flush();
+  return true;
+}
+
+int DocxBuilder::findClosingDelimiter(const QString &text, int from, QChar c,
+                                      int length) const {
+  int j = from;
+  while (j < text.size()) {
+    QChar current = text.at(j);
+    if (current == '`') {
+      // 跳过行内代码，代码中的星号不参与匹配
+      int ticks = runLength(text, j, current);
+      int close = text.indexOf(QString(ticks, '`'), j + ticks);
+      j = close < 0 ? j + ticks : close + ticks;
+      continue;
+    }
+    if (current != c) {
+      ++j;
+      continue;
+    }
+    int run = runLength(text, j, c);
+    bool afterWord =
+        j + run < text.size() && text.at(j + run).isLetterOrNumber();
+    if (run == length && j > from && !text.at(j - 1).isSpace() &&
+        (c == '*' || !afterWord)) {
+      return j;
+    }
+    j += run;
+  }
+  return -1;
+}
+
+bool DocxBuilder::renderImage(const QString &alt, const QString &target,
+                              QString *out, QString *reason) {
+  QString ref = target.trimmed();
+  if (ref.startsWith('<') && ref.endsWith('>')) {
+    ref = ref.mid(1, ref.size() - 2);
+  }
+  if (ref.contains(' ') || ref.contains('"')) {
+    return fail(reason, "图片标题");
+  }
+  QString lower = ref.toLower();
+  if (lower.startsWith("http://") || lower.startsWith("https://") ||
+      lower.startsWith("data:")) {
+    return fail(reason, "远程或内联图片");
+  }
+
+  QString path = QDir(m_inputDir).absoluteFilePath(
+      QUrl::fromPercentEncoding(ref.toUtf8()));
+  QFileInfo info(path);
+  if (!info.isFile()) {
+    return fail(reason, QString("图片不存在: %1").arg(ref));
+  }
+
+  QString extension = info.suffix().toLower();
+  if (extension == "jpg") {
+    extension = "jpeg";
+  }
+  if (extension != "png" && extension != "jpeg" && extension != "gif") {
+    return fail(reason, QString("不支持的图片格式: %1").arg(ref));
+  }
+
+  QString key = info.absoluteFilePath();
+  if (!m_mediaIndex.contains(key)) {
+    QImageReader reader(key);
+    QImage image = reader.read();
+    if (image.isNull()) {
+      return fail(reason, QString("无法读取图片: %1").arg(ref));
+    }
+
+    // 按图片自身的DPI计算显示尺寸（缺省96），超出版心时等比缩小
+    double dpiX = image.dotsPerMeterX() > 0 ? image.dotsPerMeterX() * 0.0254
+                                            : 96.0;
+    double dpiY = image.dotsPerMeterY() > 0 ? image.dotsPerMeterY() * 0.0254
+                                            : 96.0;
+    double cx = image.width() / dpiX * EMU_PER_INCH;
+    double cy = image.height() / dpiY * EMU_PER_INCH;
+    if (cx > m_maxWidth) {
+      cy = cy * m_maxWidth / cx;
+      cx = m_maxWidth;
+    }
+    if (cy > m_maxHeight) {
+      cx = cx * m_maxHeight / cy;
+      cy = m_maxHeight;
+    }
+
+    Media media;
+    media.path = key;
+    media.extension = extension;
+    media.partName = QString("media/image%1.%2")
+                         .arg(m_media.size() + 1)
+                         .arg(info.suffix().toLower());
+    media.relId = QString("rIdImage%1").arg(m_media.size() + 1);
+    media.cx = qint64(cx);
+    media.cy = qint64(cy);
+    m_mediaIndex.insert(key, m_media.size());
+    m_media.append(media);
+  }
+
+  const Media &media = m_media.at(m_mediaIndex.value(key));
+  int id = ++m_docPrId;
+  QString name = QFileInfo(media.partName).fileName();
+  out->append(
+      QString(
+          "<w:r><w:drawing><wp:inline distT=\"0\" distB=\"0\" distL=\"0\" "
+          "distR=\"0\"><wp:extent cx=\"%1\" cy=\"%2\"/>"
+          "<wp:effectExtent b=\"0\" l=\"0\" r=\"0\" t=\"0\"/>"
+          "<wp:docPr id=\"%3\" name=\"Picture\" descr=\"%4\"/>"
+          "<wp:cNvGraphicFramePr><a:graphicFrameLocks noChangeAspect=\"1\"/>"
+          "</wp:cNvGraphicFramePr>"
+          "<a:graphic><a:graphicData "
+          "uri=\"http://schemas.openxmlformats.org/drawingml/2006/picture\">"
+          "<pic:pic><pic:nvPicPr><pic:cNvPr id=\"0\" name=\"%5\"/>"
+          "<pic:cNvPicPr><a:picLocks noChangeArrowheads=\"1\" "
+          "noChangeAspect=\"1\"/></pic:cNvPicPr></pic:nvPicPr>"
+          "<pic:blipFill><a:blip r:embed=\"%6\"/><a:stretch><a:fillRect/>"
+          "</a:stretch></pic:blipFill>"
+          "<pic:spPr bwMode=\"auto\"><a:xfrm><a:off x=\"0\" y=\"0\"/>"
+          "<a:ext cx=\"%1\" cy=\"%2\"/></a:xfrm><a:prstGeom prst=\"rect\">"
+          "<a:avLst/></a:prstGeom><a:noFill/><a:ln w=\"9525\"><a:noFill/>"
+          "<a:headEnd/><a:tailEnd/></a:ln></pic:spPr></pic:pic>"
+          "</a:graphicData></a:graphic></wp:inline></w:drawing></w:r>")
+          .arg(QString::number(media.cx), QString::number(media.cy),
+               QString::number(id), alt.toHtmlEscaped(), name,
+               media.relId));
+  return true;
+}
+
+int DocxBuilder::addNumbering(const Block &list) {
+  // 每个列表使用独立的编号定义，有序列表各自从起始编号开始
+  int id = ++m_numCount;
+  bool ordered = list.type == Block::OrderedList;
+  QString lvlText = ordered ? QString("%1") + list.marker
+                            : QString(QChar(0x2022));
+  m_abstractNums +=
+      QString("<w:abstractNum w:abstractNumId=\"%1\">"
+              "<w:multiLevelType w:val=\"singleLevel\"/>"
+              "<w:lvl w:ilvl=\"0\"><w:start w:val=\"%2\"/>"
+              "<w:numFmt w:val=\"%3\"/><w:lvlText w:val=\"%4\"/>"
+              "<w:lvlJc w:val=\"left\"/><w:pPr><w:tabs>"
+              "<w:tab w:val=\"num\" w:pos=\"0\"/></w:tabs>"
+              "<w:ind w:left=\"480\" w:hanging=\"480\"/></w:pPr></w:lvl>"
+              "</w:abstractNum>")
+          .arg(id)
+          .arg(ordered ? list.start : 1)
+          .arg(ordered ? "decimal" : "bullet")
+          .arg(lvlText);
+  m_nums += QString("<w:num w:numId=\"%1\"><w:abstractNumId w:val=\"%1\"/>"
+                    "</w:num>")
+                .arg(id);
+  return id;
+}
+
+QString DocxBuilder::paragraph(const QString &style, const QString &runs,
+                               const QString &extraProperties) {
+  return QString("<w:p><w:pPr><w:pStyle w:val=\"%1\"/>%2</w:pPr>%3</w:p>")
+      .arg(style, extraProperties, runs);
+}
+
+QString DocxBuilder::textRun(const QString &text, bool bold, bool italic) {
+  QString run = "<w:r>";
+  if (bold || italic) {
+    run += "<w:rPr>";
+    if (bold) {
+      run += "<w:b/><w:bCs/>";
+    }
+    if (italic) {
+      run += "<w:i/><w:iCs/>";
+    }
+    run += "</w:rPr>";
+  }
+  run += "<w:t xml:space=\"preserve\">" + text.toHtmlEscaped() + "</w:t></w:r>";
+  return run;
+}
+
+QString DocxBuilder::codeRun(const QString &text, bool bold, bool italic) {
+  QString run = "<w:r><w:rPr><w:rStyle w:val=\"VerbatimChar\"/>";
+  if (bold) {
+    run += "<w:b/><w:bCs/>";
+  }
+  if (italic) {
+    run += "<w:i/><w:iCs/>";
+  }
+  run += "</w:rPr><w:t xml:space=\"preserve\">" + text.toHtmlEscaped() +
+         "</w:t></w:r>";
+  return run;
+}
+
+QString DocxBuilder::documentXml(const QString &sectPr) const {
+  return QString("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+                 "<w:document xmlns:w=\"%1\" xmlns:r=\"%2\" "
+                 "xmlns:wp=\"http://schemas.openxmlformats.org/drawingml/2006/"
+                 "wordprocessingDrawing\" "
+                 "xmlns:a=\"http://schemas.openxmlformats.org/drawingml/2006/"
+                 "main\" "
+                 "xmlns:pic=\"http://schemas.openxmlformats.org/drawingml/"
+                 "2006/picture\"><w:body>")
+             .arg(NS_W, NS_R) +
+         m_body + sectPr + "</w:body></w:document>";
+}
+
+QString DocxBuilder::numberingXml() const {
+  return QString("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+                 "<w:numbering xmlns:w=\"%1\">")
+             .arg(NS_W) +
+         m_abstractNums + m_nums + "</w:numbering>";
+}
+
+// ---------------------------------------------------------------------------
+// 参考模板
+// ---------------------------------------------------------------------------
+
+int attributeValue(const QString &xml, const QString &element,
+                   const QString &attribute, int fallback) {
+  QRegularExpression pattern(
+      QString("<%1\\b[^>]*\\s%2=\"(\\d+)\"")
+          .arg(QRegularExpression::escape(element),
+               QRegularExpression::escape(attribute)));
+  QRegularExpressionMatch match = pattern.match(xml);
+  return match.hasMatch() ? match.captured(1).toInt() : fallback;
+}
+
+/**
+ * 检查模板并确定要原样复制的部件
+ * 模板使用了本引擎无法正确接续的特性（页眉页脚、样式内编号等）时返回false
+ */
+bool inspectTemplate(const ZipReader &reference, QStringList *parts,
+                     QString *sectPr, QString *reason) {
+  QByteArray styles = reference.fileData("word/styles.xml");
+  if (styles.isEmpty()) {
+    return fail(reason, "模板缺少样式定义");
+  }
+  if (styles.contains("<w:numId")) {
+    return fail(reason, "模板样式引用了编号定义");
+  }
+
+  for (const TemplatePart &part : TEMPLATE_PARTS) {
+    QString name = QString::fromLatin1(part.name);
+    if (!reference.contains(name)) {
+      continue;
+    }
+    if (name != "word/styles.xml" && name != "word/theme/theme1.xml") {
+      // 引用了其他部件的设置（附加模板、嵌入字体、脚注分隔符等）不复制
+      QByteArray data = reference.fileData(name);
+      if (data.contains("r:id") || data.contains("w:footnotePr") ||
+          data.contains("w:endnotePr")) {
+        continue;
+      }
+    }
+    parts->append(name);
+  }
+
+  QString document = QString::fromUtf8(reference.fileData("word/document.xml"));
+  int start = document.lastIndexOf("<w:sectPr");
+  int end = document.indexOf("</w:sectPr>", start);
+  if (start >= 0 && end > start) {
+    QString section = document.mid(start, end + 11 - start);
+    if (section.contains("r:id")) {
+      return fail(reason, "模板包含页眉页脚");
+    }
+    static const QRegularExpression prefixPattern("[<\\s/]([A-Za-z0-9]+):");
+    QRegularExpressionMatchIterator it = prefixPattern.globalMatch(section);
+    while (it.hasNext()) {
+      QString prefix = it.next().captured(1);
+      if (prefix != "w" && prefix != "r" && prefix != "xml") {
+        return fail(reason, "模板页面设置使用了扩展命名空间");
+      }
+    }
+    *sectPr = section;
+  }
+
+  return true;
+}
+
+QString relationshipsXml(const QStringList &parts, const QList<Media> &media) {
+  QString xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+                "<Relationships xmlns=\"http://schemas.openxmlformats.org/"
+                "package/2006/relationships\">";
+  auto add = [&](const QString &id, const QString &type,
+                 const QString &target) {
+    xml += QString("<Relationship Id=\"%1\" Type=\"%2%3\" Target=\"%4\"/>")
+               .arg(id, REL_TYPE_BASE, type, target);
+  };
+
+  add("rIdNumbering", "numbering", "numbering.xml");
+  int index = 0;
+  for (const TemplatePart &part : TEMPLATE_PARTS) {
+    QString name = QString::fromLatin1(part.name);
+    ++index;
+    if (parts.contains(name)) {
+      add(QString("rId%1").arg(index), part.relType, name.mid(5));
+    }
+  }
+  for (const Media &item : media) {
+    add(item.relId, "image", item.partName);
+  }
+
+  return xml + "</Relationships>";
+}
+
+QString contentTypesXml(const QStringList &parts, const QList<Media> &media) {
+  QString xml =
+      "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+      "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/"
+      "content-types\">"
+      "<Default Extension=\"rels\" "
+      "ContentType=\"application/vnd.openxmlformats-package.relationships+"
+      "xml\"/>"
+      "<Default Extension=\"xml\" ContentType=\"application/xml\"/>";
+
+  QStringList extensions;
+  for (const Media &item : media) {
+    QString suffix = QFileInfo(item.partName).suffix();
+    if (!extensions.contains(suffix)) {
+      extensions.append(suffix);
+      xml += QString("<Default Extension=\"%1\" ContentType=\"image/%2\"/>")
+                 .arg(suffix, item.extension);
+    }
+  }
+
+  xml += "<Override PartName=\"/word/document.xml\" "
+         "ContentType=\"application/"
+         "vnd.openxmlformats-officedocument.wordprocessingml.document.main+"
+         "xml\"/>"
+         "<Override PartName=\"/word/numbering.xml\" "
+         "ContentType=\"application/"
+         "vnd.openxmlformats-officedocument.wordprocessingml.numbering+xml\"/>";
+  for (const TemplatePart &part : TEMPLATE_PARTS) {
+    if (parts.contains(QString::fromLatin1(part.name))) {
+      xml += QString("<Override PartName=\"/%1\" ContentType=\"%2\"/>")
+                 .arg(part.name, part.contentType);
+    }
+  }
+
+  return xml + "</Types>";
+}
+
+const char *const PACKAGE_RELATIONSHIPS =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/"
+    "relationships\"><Relationship Id=\"rId1\" "
+    "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/"
+    "relationships/officeDocument\" Target=\"word/document.xml\"/>"
+    "</Relationships>";
+
+/**
+ * 检查过的参考模板：要复制的部件（原始压缩数据）和页面设置
+ * 模板不适用时保存原因，同一模板不再重复检查
+ */
+struct PreparedTemplate {
+  QDateTime modified;
+  qint64 size = 0;
+  bool usable = false;
+  QString error;
+  QStringList parts;
+  QList<ZipEntry> entries; // 与parts一一对应
+  QList<QByteArray> rawData;
+  QString sectPr;
+};
+
+/**
+ * 返回检查过的模板，按路径缓存，修改时间或大小变化时重新读取
+ * 转换在线程池中执行（没有事件循环，无法使用QFileSystemWatcher），
+ * 每次使用前只做一次stat
+ */
+QSharedPointer<const PreparedTemplate> prepareTemplate(const QString &fileName) {
+  static QMutex mutex;
+  static QHash<QString, QSharedPointer<const PreparedTemplate>> cache;
+
+  QFileInfo info(fileName);
+  QString key = info.absoluteFilePath();
+  QDateTime modified = info.lastModified();
+  qint64 size = info.size();
+  {
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(key);
+    if (it != cache.constEnd() && it.value()->modified == modified &&
+        it.value()->size == size) {
+      return it.value();
+    }
+  }
+
+  QSharedPointer<PreparedTemplate> prepared(new PreparedTemplate);
+  prepared->modified = modified;
+  prepared->size = size;
+  prepared->sectPr = DEFAULT_SECT_PR;
+
+  ZipReader reference;
+  if (!reference.open(fileName)) {
+    // 读取失败（文件不存在等）不缓存，修复后立即生效
+    prepared->error = QString("无法读取模板: %1").arg(reference.errorString());
+    return prepared;
+  }
+  if (inspectTemplate(reference, &prepared->parts, &prepared->sectPr,
+                      &prepared->error)) {
+    prepared->usable = true;
+    for (const QString &part : prepared->parts) {
+      ZipEntry entry;
+      prepared->rawData.append(reference.rawData(part, &entry));
+      entry.name = part;
+      prepared->entries.append(entry);
+    }
+  }
+
+  QMutexLocker locker(&mutex);
+  cache.insert(key, prepared);
+  return prepared;
+}
+
+} // namespace
+
+NativeDocxEngine::NativeDocxEngine(const QString &templateFile)
+    : m_templateFile(templateFile) {}
+
+NativeDocxEngine::Status NativeDocxEngine::convert(const QString &inputFile,
+                                                   const QString &outputFile) {
+  m_error.clear();
+
+  QFile input(inputFile);
+  if (!input.open(QIODevice::ReadOnly)) {
+    m_error = QString("无法读取输入文件: %1").arg(input.errorString());
+    return Failed;
+  }
+  QString markdown = QString::fromUtf8(input.readAll());
+  input.close();
+
+  QList<Block> blocks;
+  if (!parseBlocks(markdown, &blocks, &m_error)) {
+    return Unsupported;
+  }
+
+  // 使用模板时原样复制模板的样式等部件，页面设置也沿用模板
+  QSharedPointer<const PreparedTemplate> reference;
+  QStringList templateParts;
+  QString sectPr = DEFAULT_SECT_PR;
+  if (!m_templateFile.isEmpty()) {
+    reference = prepareTemplate(m_templateFile);
+    if (!reference->usable) {
+      m_error = reference->error;
+      return Unsupported;
+    }
+    templateParts = reference->parts;
+    sectPr = reference->sectPr;
+  }
+
+  int pageWidth = attributeValue(sectPr, "w:pgSz", "w:w", 12240);
+  int pageHeight = attributeValue(sectPr, "w:pgSz", "w:h", 15840);
+  int textWidth = pageWidth - attributeValue(sectPr, "w:pgMar", "w:left", 1440) -
+                  attributeValue(sectPr, "w:pgMar", "w:right", 1440);
+  int textHeight = pageHeight -
+                   attributeValue(sectPr, "w:pgMar", "w:top", 1440) -
+                   attributeValue(sectPr, "w:pgMar", "w:bottom", 1440);
+
+  DocxBuilder builder(QFileInfo(inputFile).absolutePath(),
+                      qint64(qMax(textWidth, 1440)) * EMU_PER_TWIP,
+                      qint64(qMax(textHeight, 1440)) * EMU_PER_TWIP);
+  if (!builder.render(blocks, &m_error)) {
+    return Unsupported;
+  }
+
+  // 先写入临时文件，全部成功后再替换目标文件
+  QSaveFile output(outputFile);
+  if (!output.open(QIODevice::WriteOnly)) {
+    m_error = QString("无法创建输出文件: %1").arg(output.errorString());
+    return Failed;
+  }
+
+  // 没有模板时使用内置样式
+  QStringList packageParts = templateParts;
+  if (packageParts.isEmpty()) {
+    packageParts.append("word/styles.xml");
+  }
+
+  ZipWriter zip(&output);
+  bool ok =
+      zip.addFile("[Content_Types].xml",
+                  contentTypesXml(packageParts, builder.media()).toUtf8()) &&
+      zip.addFile("_rels/.rels", QByteArray(PACKAGE_RELATIONSHIPS)) &&
+      zip.addFile("word/document.xml", builder.documentXml(sectPr).toUtf8()) &&
+      zip.addFile("word/_rels/document.xml.rels",
+                  relationshipsXml(packageParts, builder.media()).toUtf8()) &&
+      zip.addFile("word/numbering.xml", builder.numberingXml().toUtf8());
+
+  if (templateParts.isEmpty()) {
+    ok = ok && zip.addFile("word/styles.xml", QByteArray(DEFAULT_STYLES));
+  }
+  for (int i = 0; ok && i < templateParts.size(); ++i) {
+    ok = zip.addRawFile(reference->entries.at(i), reference->rawData.at(i));
+  }
+
+  for (const Media &media : builder.media()) {
+    if (!ok) {
+      break;
+    }
+    QFile image(media.path);
+    if (!image.open(QIODevice::ReadOnly)) {
+      m_error = QString("无法读取图片: %1").arg(image.errorString());
+      output.cancelWriting();
+      return Failed;
+    }
+    // 图片本身已经压缩过，直接存储
+    ok = zip.addFile("word/" + media.partName, image.readAll(), false);
+  }
+
+  ok = ok && zip.close();
+  if (!ok) {
+    m_error = zip.errorString();
+    output.cancelWriting();
+    return Failed;
+  }
+  if (!output.commit()) {
+    m_error = QString("写入输出文件失败: %1").arg(output.errorString());
+    return Failed;
+  }
+
+  return Converted;
+}
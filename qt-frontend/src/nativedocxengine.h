@@ -0,0 +1,37 @@
+#ifndef NATIVEDOCXENGINE_H
+#define NATIVEDOCXENGINE_H
+
+#include <QString>
+
+/**
+ * 本地Markdown转DOCX引擎（快速路径）
+ *
+ * 只处理最常见的Markdown子集：标题、段落、强调、行内代码、
+ * 单层列表、管道表格、无语言标记的代码块和本地图片。
+ * 样式名称与pandoc的参考模板一致，指定模板时直接沿用模板中的
+ * 样式、主题、字体表和页面设置。
+ *
+ * 遇到子集之外的语法（链接、引用、脚注、公式、嵌套列表等）时返回
+ * Unsupported，由调用方回退到pandoc转换，保证输出结果不打折扣。
+ */
+class NativeDocxEngine {
+public:
+  enum Status {
+    Converted,   // 转换成功
+    Unsupported, // 文档包含不支持的语法，需要回退到pandoc
+    Failed       // 读写文件失败
+  };
+
+  explicit NativeDocxEngine(const QString &templateFile = QString());
+
+  Status convert(const QString &inputFile, const QString &outputFile);
+
+  // 最近一次转换不成功的原因
+  QString errorString() const { return m_error; }
+
+private:
+  QString m_templateFile;
+  QString m_error;
+};
+
+#endif // NATIVEDOCXENGINE_H
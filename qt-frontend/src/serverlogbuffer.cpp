@@ -0,0 +1,162 @@
+#include "serverlogbuffer.h"
+
+#include <QRegularExpression>
+
+QString ServerLogEntry::levelName(Level level) {
+  switch (level) {
+  case Debug:
+    return "DEBUG";
+  case Warning:
+    return "WARN";
+  case Error:
+    return "ERROR";
+  default:
+    return "INFO";
+  }
+}
+
+ServerLogBuffer::ServerLogBuffer(int capacity, QObject *parent)
+    : QObject(parent), m_head(0), m_count(0), m_nextSequence(1),
+      m_dropped(0) {
+  m_entries.resize(qMax(1, capacity));
+}
+
+void ServerLogBuffer::append(int backend, ServerLogEntry::Stream stream,
+                             const QByteArray &line) {
+  ServerLogEntry entry = parseLine(line);
+  if (entry.message.isEmpty()) {
+    return;
+  }
+  entry.sequence = m_nextSequence++;
+  entry.backend = backend;
+  entry.stream = stream;
+
+  if (m_count == m_entries.size()) {
+    ++m_dropped;
+  } else {
+    ++m_count;
+  }
+  // 覆盖旧条目时复用其位置，不重新分配数组
+  m_entries[m_head] = entry;
+  m_head = (m_head + 1) % m_entries.size();
+
+  emit entryAdded(entry.sequence);
+}
+
+QVector<ServerLogEntry> ServerLogBuffer::entriesSince(quint64 after) const {
+  QVector<ServerLogEntry> result;
+  int start = (m_head - m_count + m_entries.size()) % m_entries.size();
+  for (int i = 0; i < m_count; ++i) {
+    const ServerLogEntry &entry = m_entries.at((start + i) % m_entries.size());
+    if (entry.sequence > after) {
+      result.append(entry);
+    }
+  }
+  return result;
+}
+
+void ServerLogBuffer::clear() {
+  // 释放消息占用的内存，数组本身保持容量不变
+  for (ServerLogEntry &entry : m_entries) {
+    entry = ServerLogEntry();
+  }
+  m_head = 0;
+  m_count = 0;
+  emit cleared();
+}
+
+ServerLogEntry ServerLogBuffer::parseLine(const QByteArray &line) {
+  // Go标准log的时间前缀，微秒部分只保留毫秒
+  static const QRegularExpression goLogPattern(
+      "^(\\d{4}/\\d{2}/\\d{2} \\d{2}:\\d{2}:\\d{2})(\\.(\\d{3})\\d*)? (.*)$");
+  // logfmt字段：key=value 或 key="带空格的值"
+  static const QRegularExpression logfmtPattern(
+      "(\\w+)=(\"((?:[^\"\\\\]|\\\\.)*)\"|\\S*)");
+
+  ServerLogEntry entry;
+  QString text = QString::fromUtf8(line).trimmed();
+  if (text.size() > MAX_MESSAGE_LENGTH) {
+    text.truncate(MAX_MESSAGE_LENGTH);
+    text += "…";
+  }
+
+  QRegularExpressionMatch goLog = goLogPattern.match(text);
+  if (goLog.hasMatch()) {
+    QString stamp = goLog.captured(1);
+    if (goLog.capturedLength(3) > 0) {
+      entry.timestamp = QDateTime::fromString(
+          stamp + "." + goLog.captured(3), "yyyy/MM/dd HH:mm:ss.zzz");
+    } else {
+      entry.timestamp = QDateTime::fromString(stamp, "yyyy/MM/dd HH:mm:ss");
+    }
+    text = goLog.captured(4);
+  }
+
+  if (text.startsWith("time=") || text.startsWith("level=")) {
+    QString message;
+    QStringList extra;
+    QRegularExpressionMatchIterator it = logfmtPattern.globalMatch(text);
+    while (it.hasNext()) {
+      QRegularExpressionMatch field = it.next();
+      QString key = field.captured(1);
+      QString value = field.captured(2);
+      if (value.startsWith('"')) {
+        value = field.captured(3).replace("\\\"", "\"");
+      }
+      if (key == "time") {
+        QDateTime time = QDateTime::fromString(value, Qt::ISODateWithMs);
+        if (time.isValid()) {
+          entry.timestamp = time.toLocalTime();
+        }
+      } else if (key == "level") {
+        entry.level = parseLevel(value);
+      } else if (key == "msg") {
+        message = value;
+      } else {
+        extra.append(field.captured(0));
+      }
+    }
+    if (!message.isEmpty()) {
+      entry.message =
+          extra.isEmpty() ? message : message + " " + extra.join(' ');
+      if (!entry.timestamp.isValid()) {
+        entry.timestamp = QDateTime::currentDateTime();
+      }
+      return entry;
+    }
+  }
+
+  entry.message = text;
+  entry.level = guessLevel(text);
+  if (!entry.timestamp.isValid()) {
+    entry.timestamp = QDateTime::currentDateTime();
+  }
+  return entry;
+}
+
+ServerLogEntry::Level ServerLogBuffer::parseLevel(const QString &level) {
+  QString upper = level.toUpper();
+  if (upper.startsWith("DEBUG")) {
+    return ServerLogEntry::Debug;
+  }
+  if (upper.startsWith("WARN")) {
+    return ServerLogEntry::Warning;
+  }
+  if (upper.startsWith("ERR") || upper.startsWith("FATAL")) {
+    return ServerLogEntry::Error;
+  }
+  return ServerLogEntry::Info;
+}
+
+ServerLogEntry::Level ServerLogBuffer::guessLevel(const QString &message) {
+  // 服务器的日志以中文描述为主，按常用措辞推断级别
+  if (message.startsWith("panic:") || message.startsWith("fatal error:") ||
+      message.contains("失败") || message.contains("错误")) {
+    return ServerLogEntry::Error;
+  }
+  if (message.startsWith("警告") || message.contains("超时") ||
+      message.contains("不可用")) {
+    return ServerLogEntry::Warning;
+  }
+  return ServerLogEntry::Info;
+}
@@ -0,0 +1,77 @@
+#ifndef SERVERLOGBUFFER_H
+#define SERVERLOGBUFFER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+/**
+ * 后端日志条目
+ */
+struct ServerLogEntry {
+  enum Stream { Stdout, Stderr };
+  enum Level { Debug, Info, Warning, Error };
+
+  quint64 sequence = 0; // 从1开始递增的序号，用于增量读取
+  QDateTime timestamp;  // 日志行自带的时间，没有时为收到的时间
+  int backend = 0;      // 后端进程序号
+  Stream stream = Stdout;
+  Level level = Info;
+  QString message;
+
+  static QString levelName(Level level);
+};
+
+/**
+ * 后端日志环形缓冲区
+ * 容量固定，写满后覆盖最旧的条目，单行长度也有上限，
+ * 程序长时间运行时占用的内存不会随后端输出增长。
+ *
+ * 能识别Go标准log的时间前缀（2025/01/02 15:04:05[.000000]）和
+ * logfmt格式（time=... level=... msg=...），其余行按关键字推断级别。
+ */
+class ServerLogBuffer : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ServerLogBuffer(int capacity = DEFAULT_CAPACITY,
+                           QObject *parent = nullptr);
+
+  // 解析并追加一行输出，超出MAX_MESSAGE_LENGTH的部分被截断
+  void append(int backend, ServerLogEntry::Stream stream,
+              const QByteArray &line);
+
+  // 读取序号大于after的条目（按时间顺序），已被覆盖的条目不再返回
+  QVector<ServerLogEntry> entriesSince(quint64 after) const;
+  QVector<ServerLogEntry> entries() const { return entriesSince(0); }
+
+  void clear();
+
+  int capacity() const { return m_entries.size(); }
+  int size() const { return m_count; }
+  quint64 lastSequence() const { return m_nextSequence - 1; }
+  quint64 droppedCount() const { return m_dropped; } // 被覆盖的条目数
+
+  static ServerLogEntry parseLine(const QByteArray &line);
+
+  static const int DEFAULT_CAPACITY = 2000;
+  static const int MAX_MESSAGE_LENGTH = 4096;
+
+signals:
+  // 追加条目后发出；输出密集时仍逐条发出，接收方应自行合并刷新
+  void entryAdded(quint64 sequence);
+  void cleared();
+
+private:
+  static ServerLogEntry::Level guessLevel(const QString &message);
+  static ServerLogEntry::Level parseLevel(const QString &level);
+
+  QVector<ServerLogEntry> m_entries; // 预先分配capacity个条目
+  int m_head;                        // 下一个写入位置
+  int m_count;
+  quint64 m_nextSequence;
+  quint64 m_dropped;
+};
+
+#endif // SERVERLOGBUFFER_H
@@ -0,0 +1,155 @@
+#include "serverlogviewer.h"
+#include "serverlogbuffer.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QComboBox>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QTimer>
+#include <QVBoxLayout>
+
+ServerLogViewer::ServerLogViewer(QWidget *parent)
+    : QWidget(parent), m_buffer(nullptr), m_logView(nullptr),
+      m_levelFilter(nullptr), m_clearButton(nullptr), m_copyButton(nullptr),
+      m_summaryLabel(nullptr), m_refreshTimer(new QTimer(this)),
+      m_lastSequence(0) {
+  setupUI();
+
+  m_refreshTimer->setSingleShot(true);
+  m_refreshTimer->setInterval(REFRESH_INTERVAL);
+  connect(m_refreshTimer, &QTimer::timeout, this, &ServerLogViewer::refresh);
+}
+
+void ServerLogViewer::setupUI() {
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+  QHBoxLayout *toolLayout = new QHBoxLayout();
+  toolLayout->addWidget(new QLabel("级别:", this));
+  m_levelFilter = new QComboBox(this);
+  m_levelFilter->addItem("全部", ServerLogEntry::Debug);
+  m_levelFilter->addItem("信息及以上", ServerLogEntry::Info);
+  m_levelFilter->addItem("警告及以上", ServerLogEntry::Warning);
+  m_levelFilter->addItem("仅错误", ServerLogEntry::Error);
+  toolLayout->addWidget(m_levelFilter);
+  toolLayout->addStretch();
+
+  m_summaryLabel = new QLabel(this);
+  toolLayout->addWidget(m_summaryLabel);
+
+  m_copyButton = new QPushButton("复制", this);
+  m_clearButton = new QPushButton("清空", this);
+  toolLayout->addWidget(m_copyButton);
+  toolLayout->addWidget(m_clearButton);
+  mainLayout->addLayout(toolLayout);
+
+  m_logView = new QPlainTextEdit(this);
+  m_logView->setReadOnly(true);
+  m_logView->setLineWrapMode(QPlainTextEdit::NoWrap);
+  m_logView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  m_logView->setMaximumBlockCount(ServerLogBuffer::DEFAULT_CAPACITY);
+  mainLayout->addWidget(m_logView);
+
+  connect(m_levelFilter, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, &ServerLogViewer::rebuild);
+  connect(m_clearButton, &QPushButton::clicked, this,
+          &ServerLogViewer::clearLog);
+  connect(m_copyButton, &QPushButton::clicked, this, &ServerLogViewer::copyLog);
+}
+
+void ServerLogViewer::setLogBuffer(ServerLogBuffer *buffer) {
+  if (m_buffer) {
+    disconnect(m_buffer, nullptr, this, nullptr);
+  }
+  m_buffer = buffer;
+  if (m_buffer) {
+    m_logView->setMaximumBlockCount(m_buffer->capacity());
+    connect(m_buffer, &ServerLogBuffer::entryAdded, this,
+            &ServerLogViewer::scheduleRefresh);
+    connect(m_buffer, &ServerLogBuffer::cleared, this,
+            &ServerLogViewer::rebuild);
+    connect(m_buffer, &QObject::destroyed, this,
+            [this]() { m_buffer = nullptr; });
+  }
+  rebuild();
+}
+
+void ServerLogViewer::showEvent(QShowEvent *event) {
+  QWidget::showEvent(event);
+  refresh();
+}
+
+void ServerLogViewer::scheduleRefresh() {
+  // 页面不可见时只累积在缓冲区中，显示时再补齐
+  if (isVisible() && !m_refreshTimer->isActive()) {
+    m_refreshTimer->start();
+  }
+}
+
+void ServerLogViewer::refresh() {
+  if (!m_buffer) {
+    return;
+  }
+
+  const QVector<ServerLogEntry> entries = m_buffer->entriesSince(m_lastSequence);
+  if (!entries.isEmpty()) {
+    QScrollBar *scrollBar = m_logView->verticalScrollBar();
+    bool atBottom = scrollBar->value() == scrollBar->maximum();
+
+    for (const ServerLogEntry &entry : entries) {
+      if (accepts(entry)) {
+        m_logView->appendPlainText(formatEntry(entry));
+      }
+    }
+    m_lastSequence = entries.last().sequence;
+
+    // 用户向上翻看时不自动滚动到底部
+    if (atBottom) {
+      scrollBar->setValue(scrollBar->maximum());
+    }
+  }
+
+  m_summaryLabel->setText(
+      QString("共%1条，已覆盖%2条")
+          .arg(m_buffer->size())
+          .arg(m_buffer->droppedCount()));
+}
+
+void ServerLogViewer::rebuild() {
+  m_logView->clear();
+  m_lastSequence = 0;
+  if (m_buffer) {
+    refresh();
+  } else {
+    m_summaryLabel->clear();
+  }
+}
+
+void ServerLogViewer::clearLog() {
+  if (m_buffer) {
+    m_buffer->clear();
+  } else {
+    m_logView->clear();
+  }
+}
+
+void ServerLogViewer::copyLog() {
+  QApplication::clipboard()->setText(m_logView->toPlainText());
+}
+
+bool ServerLogViewer::accepts(const ServerLogEntry &entry) const {
+  return entry.level >= m_levelFilter->currentData().toInt();
+}
+
+QString ServerLogViewer::formatEntry(const ServerLogEntry &entry) {
+  return QString("%1 [%2] #%3 %4%5")
+      .arg(entry.timestamp.toString("MM-dd HH:mm:ss.zzz"))
+      .arg(ServerLogEntry::levelName(entry.level), -5)
+      .arg(entry.backend)
+      .arg(entry.stream == ServerLogEntry::Stderr ? "" : "(stdout) ")
+      .arg(entry.message);
+}
@@ -0,0 +1,60 @@
+#ifndef SERVERLOGVIEWER_H
+#define SERVERLOGVIEWER_H
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+class QTimer;
+QT_END_NAMESPACE
+
+class ServerLogBuffer;
+struct ServerLogEntry;
+
+/**
+ * @brief 后端日志查看页面
+ *
+ * 从ServerLogBuffer增量读取日志，输出密集时合并刷新；
+ * 页面不可见时不刷新，重新显示时一次补齐。
+ * 文本框的行数上限与缓冲区容量相同，界面占用的内存同样固定。
+ */
+class ServerLogViewer : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit ServerLogViewer(QWidget *parent = nullptr);
+
+  // 缓冲区在服务器进程池创建后设置
+  void setLogBuffer(ServerLogBuffer *buffer);
+
+protected:
+  void showEvent(QShowEvent *event) override;
+
+private slots:
+  void scheduleRefresh();
+  void refresh();
+  void rebuild();
+  void clearLog();
+  void copyLog();
+
+private:
+  void setupUI();
+  bool accepts(const ServerLogEntry &entry) const;
+  static QString formatEntry(const ServerLogEntry &entry);
+
+  ServerLogBuffer *m_buffer;
+  QPlainTextEdit *m_logView;
+  QComboBox *m_levelFilter;
+  QPushButton *m_clearButton;
+  QPushButton *m_copyButton;
+  QLabel *m_summaryLabel;
+  QTimer *m_refreshTimer;
+  quint64 m_lastSequence; // 已显示的最后一条日志
+
+  static const int REFRESH_INTERVAL = 250; // 合并刷新的间隔（毫秒）
+};
+
+#endif // SERVERLOGVIEWER_H
@@ -1,4 +1,5 @@
 #include "settingswidget.h"
+#include "appsettings.h"
 #include "httpapi.h"
 
 #include <QCheckBox>
@@ -364,6 +365,10 @@ void SettingsWidget::onConfigReceived(const ConfigData &config) {
   m_currentPandocPath = pandocPath;
   m_currentTemplateFile = config.templateFile;
 
+  // 本地转换引擎从AppSettings读取模板，与服务端配置保持一致
+  AppSettings::instance()->setTemplateFile(config.templateFile);
+  AppSettings::instance()->setUseTemplate(!config.templateFile.isEmpty());
+
   showStatus("配置加载完成");
   updateUI();
 
@@ -382,6 +387,8 @@ void SettingsWidget::onConfigUpdated(bool success, const QString &message) {
     m_currentPandocPath = m_pandocPathEdit->text();
     m_currentTemplateFile =
         m_useTemplateCheckBox->isChecked() ? m_templateFileEdit->text() : "";
+    AppSettings::instance()->setTemplateFile(m_currentTemplateFile);
+    AppSettings::instance()->setUseTemplate(!m_currentTemplateFile.isEmpty());
     emit configChanged();
   } else {
     showStatus(QString("配置保存失败: %1").arg(message), true);
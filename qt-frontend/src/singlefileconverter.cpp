@@ -1,10 +1,12 @@
 #include "singlefileconverter.h"
 #include "appsettings.h"
 #include "httpapi.h"
+#include "nativedocxengine.h"
 
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QGridLayout>
@@ -21,6 +23,7 @@
 #include <QUrl>
 #include <QVBoxLayout>
 #include <QWidget>
+#include <QtConcurrent>
 
 SingleFileConverter::SingleFileConverter(HttpApi *api, QWidget *parent)
     : QWidget(parent), m_inputGroup(nullptr), m_inputFileEdit(nullptr),
@@ -29,13 +32,17 @@ SingleFileConverter::SingleFileConverter(HttpApi *api, QWidget *parent)
       m_outputNameEdit(nullptr), m_actionGroup(nullptr),
       m_convertButton(nullptr), m_clearButton(nullptr), m_statusGroup(nullptr),
       m_statusText(nullptr), m_progressBar(nullptr), m_httpApi(api),
+      m_nativeWatcher(new QFutureWatcher<NativeResult>(this)),
       m_conversionInProgress(false) {
   setupUI();
   setupConnections();
   updateUI();
 }
 
-SingleFileConverter::~SingleFileConverter() {}
+SingleFileConverter::~SingleFileConverter() {
+  // 工作线程写出的文件可能正被使用，等待其完成后再销毁
+  m_nativeWatcher->waitForFinished();
+}
 
 void SingleFileConverter::setupUI() {
   QVBoxLayout *mainLayout = new QVBoxLayout(this);
@@ -127,6 +134,9 @@ void SingleFileConverter::setupConnections() {
   connect(m_outputNameEdit, &QLineEdit::textChanged, this,
           &SingleFileConverter::onOutputNameChanged);
 
+  connect(m_nativeWatcher, &QFutureWatcher<NativeResult>::finished, this,
+          &SingleFileConverter::onNativeConversionFinished);
+
   // HTTP API连接
   if (m_httpApi) {
     connect(m_httpApi, &HttpApi::singleConversionFinished, this,
@@ -197,12 +207,55 @@ void SingleFileConverter::startConversion() {
   showStatus("开始转换...");
   emit conversionStarted();
 
+  m_pendingInputFile = inputFile;
+  m_pendingOutputPath = outputPath;
+
+  // 常见Markdown语法直接由本地引擎生成，遇到不支持的语法时再交给Pandoc
+  // 本地引擎在线程池中执行，大文档和图片压缩不会卡住界面
+  AppSettings *settings = AppSettings::instance();
+  if (settings->getUseNativeEngine()) {
+    QString templateFile =
+        settings->getUseTemplate() ? settings->getTemplateFile() : QString();
+    m_nativeWatcher->setFuture(
+        QtConcurrent::run([templateFile, inputFile, outputPath]() {
+          NativeDocxEngine engine(templateFile);
+          QElapsedTimer timer;
+          timer.start();
+          NativeResult result;
+          result.status = engine.convert(inputFile, outputPath);
+          result.error = engine.errorString();
+          result.elapsed = timer.elapsed();
+          return result;
+        }));
+    return;
+  }
+
+  startPandocConversion();
+}
+
+void SingleFileConverter::onNativeConversionFinished() {
+  NativeResult result = m_nativeWatcher->result();
+  if (result.status == NativeDocxEngine::Converted) {
+    showStatus(QString("本地引擎转换完成，耗时 %1 ms").arg(result.elapsed));
+    ConversionResponse response;
+    response.success = true;
+    response.message = "转换成功";
+    response.outputFile = m_pendingOutputPath;
+    onConversionFinished(response);
+    return;
+  }
+  showStatus(QString("本地引擎无法处理该文档（%1），改用Pandoc转换")
+                 .arg(result.error));
+  startPandocConversion();
+}
+
+void SingleFileConverter::startPandocConversion() {
   // 调用HTTP API进行转换
   if (m_httpApi) {
     ConversionRequest request;
-    request.inputFile = inputFile;
-    request.outputDir = QFileInfo(outputPath).absolutePath();
-    request.outputName = QFileInfo(outputPath).fileName();
+    request.inputFile = m_pendingInputFile;
+    request.outputDir = QFileInfo(m_pendingOutputPath).absolutePath();
+    request.outputName = QFileInfo(m_pendingOutputPath).fileName();
     request.templateFile = ""; // 暂时不使用模板
     m_httpApi->convertSingle(request);
   }
@@ -1,6 +1,7 @@
 #ifndef SINGLEFILECONVERTER_H
 #define SINGLEFILECONVERTER_H
 
+#include <QFutureWatcher>
 #include <QWidget>
 
 QT_BEGIN_NAMESPACE
@@ -51,6 +52,7 @@ private slots:
   void onOutputDirChanged();
   void onOutputNameChanged();
   void onConversionFinished(const ConversionResponse &response);
+  void onNativeConversionFinished();
 
 private:
   void setupUI();
@@ -61,6 +63,14 @@ private:
   void clearStatus();
   QString getDefaultOutputName() const;
   QString getOutputFilePath() const;
+  void startPandocConversion();
+
+  // 本地引擎在工作线程中的转换结果
+  struct NativeResult {
+    int status;
+    QString error;
+    qint64 elapsed;
+  };
 
   // UI组件
   QGroupBox *m_inputGroup;
@@ -83,6 +93,11 @@ private:
   // 后端API
   HttpApi *m_httpApi;
 
+  // 本地引擎转换在线程池中执行，不阻塞界面
+  QFutureWatcher<NativeResult> *m_nativeWatcher;
+  QString m_pendingInputFile;
+  QString m_pendingOutputPath;
+
   // 状态变量
   bool m_conversionInProgress;
   QString m_lastInputFile;
@@ -0,0 +1,363 @@
+#include "ziparchive.h"
+
+#include <QDateTime>
+#include <QFile>
+
+#ifdef MD2DOCX_QT_ZLIB
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+namespace {
+
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+const int LOCAL_HEADER_SIZE = 30;
+const int CENTRAL_HEADER_SIZE = 46;
+const int END_OF_CENTRAL_DIR_SIZE = 22;
+
+// 解压后的条目大小上限，docx部件远小于这个值；deflate的压缩比最大约为1032:1
+const qint64 MAX_UNCOMPRESSED_SIZE = 256 * 1024 * 1024;
+const qint64 MAX_DEFLATE_RATIO = 1032;
+
+quint16 readU16(const QByteArray &data, int pos) {
+  const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + pos;
+  return quint16(p[0] | (p[1] << 8));
+}
+
+quint32 readU32(const QByteArray &data, int pos) {
+  const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + pos;
+  return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) |
+         (quint32(p[3]) << 24);
+}
+
+void appendU16(QByteArray &out, quint16 value) {
+  out.append(char(value & 0xff));
+  out.append(char((value >> 8) & 0xff));
+}
+
+void appendU32(QByteArray &out, quint32 value) {
+  appendU16(out, quint16(value & 0xffff));
+  appendU16(out, quint16((value >> 16) & 0xffff));
+}
+
+// 使用zlib生成不带头尾的原始deflate数据（ZIP要求的格式）
+bool rawDeflate(const QByteArray &input, QByteArray *output) {
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+
+  output->resize(int(deflateBound(&stream, uLong(input.size()))));
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<char *>(input.constData()));
+  stream.avail_in = uInt(input.size());
+  stream.next_out = reinterpret_cast<Bytef *>(output->data());
+  stream.avail_out = uInt(output->size());
+
+  int result = deflate(&stream, Z_FINISH);
+  output->resize(int(stream.total_out));
+  deflateEnd(&stream);
+  return result == Z_STREAM_END;
+}
+
+bool rawInflate(const char *input, int inputSize, int expectedSize,
+                QByteArray *output) {
+  z_stream stream = {};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    return false;
+  }
+
+  output->resize(expectedSize);
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+  stream.avail_in = uInt(inputSize);
+  stream.next_out = reinterpret_cast<Bytef *>(output->data());
+  stream.avail_out = uInt(output->size());
+
+  int result = inflate(&stream, Z_FINISH);
+  bool ok = result == Z_STREAM_END && int(stream.total_out) == expectedSize;
+  inflateEnd(&stream);
+  return ok;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ZipReader
+// ---------------------------------------------------------------------------
+
+bool ZipReader::open(const QString &fileName) {
+  m_entries.clear();
+  m_index.clear();
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_error = QString("无法打开文件: %1").arg(file.errorString());
+    return false;
+  }
+  m_data = file.readAll();
+  file.close();
+
+  // 从文件末尾向前查找中央目录结束记录（注释最长65535字节）
+  int eocd = -1;
+  int lowest = qMax(0, m_data.size() - END_OF_CENTRAL_DIR_SIZE - 0xffff);
+  for (int pos = m_data.size() - END_OF_CENTRAL_DIR_SIZE; pos >= lowest;
+       --pos) {
+    if (readU32(m_data, pos) == END_OF_CENTRAL_DIR_SIGNATURE) {
+      eocd = pos;
+      break;
+    }
+  }
+  if (eocd < 0) {
+    m_error = "不是有效的ZIP文件";
+    return false;
+  }
+
+  int count = readU16(m_data, eocd + 10);
+  quint32 dirOffset = readU32(m_data, eocd + 16);
+  if (count == 0xffff || dirOffset == 0xffffffff) {
+    m_error = "不支持ZIP64格式";
+    return false;
+  }
+
+  // 所有偏移和长度都来自文件内容，使用64位计算并在读取前检查边界
+  qint64 pos = dirOffset;
+  for (int i = 0; i < count; ++i) {
+    if (pos + CENTRAL_HEADER_SIZE > m_data.size() ||
+        readU32(m_data, int(pos)) != CENTRAL_HEADER_SIGNATURE) {
+      m_error = "ZIP中央目录损坏";
+      m_entries.clear();
+      m_index.clear();
+      return false;
+    }
+
+    int header = int(pos);
+    int nameLength = readU16(m_data, header + 28);
+    int extraLength = readU16(m_data, header + 30);
+    int commentLength = readU16(m_data, header + 32);
+    if (pos + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength >
+        m_data.size()) {
+      m_error = "ZIP中央目录损坏";
+      m_entries.clear();
+      m_index.clear();
+      return false;
+    }
+
+    ZipEntry entry;
+    entry.method = readU16(m_data, header + 10);
+    entry.crc = readU32(m_data, header + 16);
+    entry.compressedSize = readU32(m_data, header + 20);
+    entry.uncompressedSize = readU32(m_data, header + 24);
+    entry.localHeaderOffset = readU32(m_data, header + 42);
+    entry.name = QString::fromUtf8(
+        m_data.constData() + header + CENTRAL_HEADER_SIZE, nameLength);
+
+    m_index.insert(entry.name, m_entries.size());
+    m_entries.append(entry);
+    pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+  }
+
+  return true;
+}
+
+bool ZipReader::contains(const QString &name) const {
+  return m_index.contains(name);
+}
+
+QStringList ZipReader::entryNames() const {
+  QStringList names;
+  for (const ZipEntry &entry : m_entries) {
+    names.append(entry.name);
+  }
+  return names;
+}
+
+QByteArray ZipReader::rawData(const QString &name, ZipEntry *entry) const {
+  auto it = m_index.constFind(name);
+  if (it == m_index.constEnd()) {
+    return QByteArray();
+  }
+  const ZipEntry &found = m_entries.at(it.value());
+
+  qint64 pos = found.localHeaderOffset;
+  if (pos + LOCAL_HEADER_SIZE > m_data.size() ||
+      readU32(m_data, int(pos)) != LOCAL_HEADER_SIGNATURE) {
+    return QByteArray();
+  }
+  qint64 start = pos + LOCAL_HEADER_SIZE + readU16(m_data, int(pos) + 26) +
+                 readU16(m_data, int(pos) + 28);
+  if (start + qint64(found.compressedSize) > m_data.size()) {
+    return QByteArray();
+  }
+
+  if (entry) {
+    *entry = found;
+  }
+  return m_data.mid(int(start), int(found.compressedSize));
+}
+
+QByteArray ZipReader::fileData(const QString &name) const {
+  ZipEntry entry;
+  QByteArray raw = rawData(name, &entry);
+  if (raw.isNull()) {
+    return QByteArray();
+  }
+
+  if (entry.method == 0) {
+    return raw.size() == qint64(entry.uncompressedSize) ? raw : QByteArray();
+  }
+  if (entry.method != 8) {
+    return QByteArray();
+  }
+
+  // 解压前按声明的大小分配缓冲区，先拒绝不可能或过大的声明值
+  qint64 expected = entry.uncompressedSize;
+  if (expected > MAX_UNCOMPRESSED_SIZE ||
+      expected > qint64(raw.size()) * MAX_DEFLATE_RATIO + 1) {
+    return QByteArray();
+  }
+
+  QByteArray data;
+  if (!rawInflate(raw.constData(), raw.size(), int(entry.uncompressedSize),
+                  &data)) {
+    return QByteArray();
+  }
+  return data;
+}
+
+// ---------------------------------------------------------------------------
+// ZipWriter
+// ---------------------------------------------------------------------------
+
+ZipWriter::ZipWriter(QIODevice *device)
+    : m_device(device), m_offset(0), m_dosTime(0), m_dosDate(0),
+      m_closed(false) {
+  // 所有条目使用同一个时间戳（DOS格式）
+  QDateTime now = QDateTime::currentDateTime();
+  QDate date = now.date();
+  QTime time = now.time();
+  m_dosTime = quint16((time.hour() << 11) | (time.minute() << 5) |
+                      (time.second() / 2));
+  m_dosDate = quint16(((qMax(date.year(), 1980) - 1980) << 9) |
+                      (date.month() << 5) | date.day());
+}
+
+bool ZipWriter::addFile(const QString &name, const QByteArray &data,
+                        bool compress) {
+  ZipEntry entry;
+  entry.name = name;
+  entry.crc = quint32(crc32(0L, reinterpret_cast<const Bytef *>(data.constData()),
+                            uInt(data.size())));
+  entry.uncompressedSize = quint32(data.size());
+
+  if (compress) {
+    QByteArray compressed;
+    if (!rawDeflate(data, &compressed)) {
+      m_error = QString("压缩失败: %1").arg(name);
+      return false;
+    }
+    // 压缩后没有变小时改为存储
+    if (compressed.size() < data.size()) {
+      entry.method = 8;
+      entry.compressedSize = quint32(compressed.size());
+      return writeEntry(entry, compressed);
+    }
+  }
+
+  entry.method = 0;
+  entry.compressedSize = entry.uncompressedSize;
+  return writeEntry(entry, data);
+}
+
+bool ZipWriter::addRawFile(const ZipEntry &entry, const QByteArray &rawData) {
+  if (rawData.size() != int(entry.compressedSize)) {
+    m_error = QString("条目数据长度不一致: %1").arg(entry.name);
+    return false;
+  }
+  return writeEntry(entry, rawData);
+}
+
+bool ZipWriter::writeEntry(ZipEntry entry, const QByteArray &payload) {
+  if (m_closed) {
+    m_error = "ZIP文件已关闭";
+    return false;
+  }
+
+  QByteArray name = entry.name.toUtf8();
+  entry.localHeaderOffset = m_offset;
+
+  QByteArray header;
+  appendU32(header, LOCAL_HEADER_SIGNATURE);
+  appendU16(header, 20);     // 解压所需版本
+  appendU16(header, 1 << 11); // 文件名使用UTF-8
+  appendU16(header, entry.method);
+  appendU16(header, m_dosTime);
+  appendU16(header, m_dosDate);
+  appendU32(header, entry.crc);
+  appendU32(header, entry.compressedSize);
+  appendU32(header, entry.uncompressedSize);
+  appendU16(header, quint16(name.size()));
+  appendU16(header, 0); // 扩展字段长度
+  header.append(name);
+
+  if (!write(header) || !write(payload)) {
+    return false;
+  }
+  m_entries.append(entry);
+  return true;
+}
+
+bool ZipWriter::close() {
+  if (m_closed) {
+    return true;
+  }
+
+  quint32 dirOffset = m_offset;
+  QByteArray directory;
+  for (const ZipEntry &entry : m_entries) {
+    QByteArray name = entry.name.toUtf8();
+    appendU32(directory, CENTRAL_HEADER_SIGNATURE);
+    appendU16(directory, 20); // 创建版本
+    appendU16(directory, 20); // 解压所需版本
+    appendU16(directory, 1 << 11);
+    appendU16(directory, entry.method);
+    appendU16(directory, m_dosTime);
+    appendU16(directory, m_dosDate);
+    appendU32(directory, entry.crc);
+    appendU32(directory, entry.compressedSize);
+    appendU32(directory, entry.uncompressedSize);
+    appendU16(directory, quint16(name.size()));
+    appendU16(directory, 0); // 扩展字段长度
+    appendU16(directory, 0); // 注释长度
+    appendU16(directory, 0); // 磁盘号
+    appendU16(directory, 0); // 内部属性
+    appendU32(directory, 0); // 外部属性
+    appendU32(directory, entry.localHeaderOffset);
+    directory.append(name);
+  }
+
+  QByteArray end;
+  appendU32(end, END_OF_CENTRAL_DIR_SIGNATURE);
+  appendU16(end, 0);
+  appendU16(end, 0);
+  appendU16(end, quint16(m_entries.size()));
+  appendU16(end, quint16(m_entries.size()));
+  appendU32(end, quint32(directory.size()));
+  appendU32(end, dirOffset);
+  appendU16(end, 0); // 注释长度
+
+  m_closed = true;
+  return write(directory) && write(end);
+}
+
+bool ZipWriter::write(const QByteArray &data) {
+  if (m_device->write(data) != data.size()) {
+    m_error = QString("写入失败: %1").arg(m_device->errorString());
+    return false;
+  }
+  m_offset += quint32(data.size());
+  return true;
+}
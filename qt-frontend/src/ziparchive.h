@@ -0,0 +1,86 @@
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * ZIP条目信息（来自中央目录）
+ */
+struct ZipEntry {
+  QString name;
+  quint16 method = 0; // 0=存储 8=deflate
+  quint32 crc = 0;
+  quint32 compressedSize = 0;
+  quint32 uncompressedSize = 0;
+  quint32 localHeaderOffset = 0;
+};
+
+/**
+ * 只读ZIP读取器
+ * 用于读取参考模板docx中的部件，既可以解压内容，
+ * 也可以取出原始压缩数据原样写入新的docx，避免重复解压再压缩
+ */
+class ZipReader {
+public:
+  ZipReader() = default;
+
+  // 打开ZIP文件并读取中央目录，不支持ZIP64
+  bool open(const QString &fileName);
+  QString errorString() const { return m_error; }
+
+  bool contains(const QString &name) const;
+  QStringList entryNames() const;
+
+  // 解压后的条目内容，失败时返回空
+  QByteArray fileData(const QString &name) const;
+
+  // 条目的原始（压缩）数据，配合ZipWriter::addRawFile使用
+  QByteArray rawData(const QString &name, ZipEntry *entry) const;
+
+private:
+  QByteArray m_data; // 模板docx通常只有几十KB，整体读入内存
+  QList<ZipEntry> m_entries;
+  QHash<QString, int> m_index;
+  QString m_error;
+};
+
+/**
+ * 流式ZIP写入器
+ * 每个条目添加时立即写入设备，只在内存中保留中央目录，
+ * 输出文件不需要整体缓存在内存中
+ */
+class ZipWriter {
+public:
+  explicit ZipWriter(QIODevice *device);
+
+  // 添加条目，compress为false时使用存储方式（适合已压缩的图片）
+  bool addFile(const QString &name, const QByteArray &data,
+               bool compress = true);
+
+  // 原样写入从ZipReader取出的压缩数据
+  bool addRawFile(const ZipEntry &entry, const QByteArray &rawData);
+
+  // 写入中央目录，之后不能再添加条目
+  bool close();
+
+  QString errorString() const { return m_error; }
+
+private:
+  bool writeEntry(ZipEntry entry, const QByteArray &payload);
+  bool write(const QByteArray &data);
+
+  QIODevice *m_device;
+  QList<ZipEntry> m_entries;
+  quint32 m_offset;
+  quint16 m_dosTime;
+  quint16 m_dosDate;
+  bool m_closed;
+  QString m_error;
+};
+
+#endif // ZIPARCHIVE_H
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# 本地docx引擎与pandoc的性能对比
+# 用法: tests/native_engine_benchmark.sh [每个文件的转换次数]
+
+set -e
+
+# 颜色定义
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+log() {
+    echo -e "${BLUE}[$(date '+%H:%M:%S')]${NC} $1"
+}
+
+success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# 项目根目录
+PROJECT_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+cd "$PROJECT_ROOT"
+
+RUNS="${1:-10}"
+
+if ! command -v qmake &> /dev/null; then
+    error "qmake未安装，无法构建基准测试程序"
+    exit 1
+fi
+if ! command -v pandoc &> /dev/null; then
+    error "pandoc未安装，无法进行对比"
+    exit 1
+fi
+
+log "构建基准测试程序..."
+BUILD_DIR="build/intermediate/qt/native_benchmark"
+mkdir -p "$BUILD_DIR"
+(cd "$BUILD_DIR" && qmake "$PROJECT_ROOT/qt-frontend/native_benchmark.pro" CONFIG+=release && make -j4 > /dev/null)
+success "构建完成"
+
+log "对比本地引擎与pandoc（tests/testdata，每个文件 ${RUNS} 次）..."
+./build/bin/native_benchmark "$PROJECT_ROOT/tests/testdata" --runs "$RUNS"
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# 本地docx引擎测试：解析与回退、docx合法性，以及与pandoc的逐段对比
+# 用法: tests/native_engine_test.sh
+# 没有pandoc时对比测试会被跳过，其余测试照常运行
+
+set -e
+
+# 颜色定义
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+log() {
+    echo -e "${BLUE}[$(date '+%H:%M:%S')]${NC} $1"
+}
+
+success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# 项目根目录
+PROJECT_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+cd "$PROJECT_ROOT"
+
+if ! command -v qmake &> /dev/null; then
+    error "qmake未安装，无法构建本地引擎测试程序"
+    exit 1
+fi
+
+log "构建本地引擎测试程序..."
+BUILD_DIR="build/intermediate/qt/native_engine_test"
+mkdir -p "$BUILD_DIR"
+(cd "$BUILD_DIR" && qmake "$PROJECT_ROOT/qt-frontend/native_engine_test.pro" CONFIG+=debug && make -j4 > /dev/null)
+success "构建完成"
+
+log "运行本地引擎测试..."
+./build/bin/native_engine_test
+success "本地引擎测试通过"
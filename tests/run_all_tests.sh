@@ -62,6 +62,16 @@ echo "📦 运行包测试..."
 echo "-------------------"
 go test ./pkg/... -v -timeout=30s | tee tests/results/pkg_test_$(date +%Y%m%d_%H%M%S).log
 
+# 运行本地docx引擎测试（需要Qt环境）
+if command -v qmake &> /dev/null; then
+    echo ""
+    echo "📝 运行本地docx引擎测试..."
+    echo "-------------------"
+    bash tests/native_engine_test.sh | tee tests/results/native_engine_test_$(date +%Y%m%d_%H%M%S).log
+else
+    echo "⚠️  qmake未安装，跳过本地docx引擎测试"
+fi
+
 echo ""
 echo "📊 运行内部包测试..."
 echo "-------------------"
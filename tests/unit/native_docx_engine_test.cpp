@@ -0,0 +1,462 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+
+// 包含被测试的类
+#include "../../qt-frontend/src/nativedocxengine.h"
+#include "../../qt-frontend/src/ziparchive.h"
+
+/**
+ * @brief 本地docx引擎测试类
+ *
+ * 测试内容：
+ * 1. 子集内的语法能够直接转换（标题、强调、智能引号、列表、表格、图片）
+ * 2. 子集外的语法返回Unsupported，由调用方回退到pandoc
+ * 3. 输出是合法的docx（必需部件齐全、XML格式正确、关系目标存在）
+ * 4. 与pandoc的输出逐段对比（段落样式和文本），本机没有pandoc时跳过
+ * 5. 损坏的ZIP不会导致越界读取或超大内存分配
+ */
+class NativeDocxEngineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 解析与回退测试
+    void testConverted_data();
+    void testConverted();
+    void testUnsupported_data();
+    void testUnsupported();
+    void testMissingInput();
+
+    // 输出内容测试
+    void testInlineFormatting();
+    void testListsAndTables();
+    void testFigure();
+
+    // 与pandoc对比测试
+    void testMatchesPandoc_data();
+    void testMatchesPandoc();
+    void testTestdataMatchesPandoc_data();
+    void testTestdataMatchesPandoc();
+
+    // ZIP读取器测试
+    void testCorruptZip();
+
+private:
+    QString writeMarkdown(const QString &name, const QString &markdown);
+    QString convertNative(const QString &inputFile);
+    QString convertPandoc(const QString &inputFile);
+    void verifyDocx(const QString &docxFile);
+
+    static QByteArray readPart(const QString &docxFile, const QString &part);
+    static QStringList paragraphs(const QByteArray &documentXml);
+
+    QTemporaryDir m_tempDir;
+    QString m_pandoc;
+};
+
+void NativeDocxEngineTest::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    m_pandoc = QStandardPaths::findExecutable("pandoc");
+
+    // 图片测试使用的本地图片
+    QImage image(40, 20, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    QVERIFY(image.save(m_tempDir.filePath("pic.png")));
+}
+
+void NativeDocxEngineTest::testConverted_data()
+{
+    QTest::addColumn<QString>("markdown");
+
+    QTest::newRow("标题和段落") << "# 标题\n\n第一段\n第二行\n\n## 二级标题\n\n正文\n";
+    QTest::newRow("强调和行内代码") << "这是**粗体**、*斜体*和`代码`。\n";
+    QTest::newRow("智能引号") << "\"双引号\" 'single' -- --- ...\n";
+    QTest::newRow("无序列表") << "- 第一项\n- 第二项\n- 第三项\n";
+    QTest::newRow("有序列表") << "3. 第三\n4. 第四\n";
+    QTest::newRow("管道表格") << "| 名称 | 状态 |\n|:-----|-----:|\n| a | b |\n";
+    QTest::newRow("代码块") << "```\nfunc main() {\n\treturn\n}\n```\n";
+    QTest::newRow("图片") << "段落中的图片 ![](pic.png) 结束\n";
+    QTest::newRow("带题注的图") << "![示例图片](pic.png)\n";
+}
+
+void NativeDocxEngineTest::testConverted()
+{
+    QFETCH(QString, markdown);
+
+    QString input = writeMarkdown(QTest::currentDataTag(), markdown);
+    QString output = convertNative(input);
+    QVERIFY(!output.isEmpty());
+    verifyDocx(output);
+}
+
+void NativeDocxEngineTest::testUnsupported_data()
+{
+    QTest::addColumn<QString>("markdown");
+
+    QTest::newRow("链接") << "这是一个[链接](https://example.com)。\n";
+    QTest::newRow("脚注") << "正文[^1]\n\n[^1]: 脚注\n";
+    QTest::newRow("引用块") << "> 引用\n";
+    QTest::newRow("嵌套列表") << "- 外层\n  - 内层\n";
+    QTest::newRow("松散列表") << "- 第一项\n\n- 第二项\n";
+    QTest::newRow("数学公式") << "公式 $x^2$\n";
+    QTest::newRow("带语言的代码块") << "```go\nfunc main() {}\n```\n";
+    QTest::newRow("缩进代码块") << "    code\n";
+    QTest::newRow("元数据块") << "---\ntitle: 标题\n---\n\n正文\n";
+    QTest::newRow("转义字符") << "不是\\*强调\\*\n";
+    QTest::newRow("三重强调") << "***粗斜体***\n";
+    QTest::newRow("图片标题") << "![图](pic.png \"标题\")\n";
+    QTest::newRow("远程图片") << "![图](https://example.com/a.png)\n";
+    QTest::newRow("缺失图片") << "![图](missing.png)\n";
+}
+
+void NativeDocxEngineTest::testUnsupported()
+{
+    QFETCH(QString, markdown);
+
+    QString input = writeMarkdown(QTest::currentDataTag(), markdown);
+    QString output = m_tempDir.filePath(QString("%1.docx").arg(QTest::currentDataTag()));
+    NativeDocxEngine engine;
+    QCOMPARE(engine.convert(input, output), NativeDocxEngine::Unsupported);
+    QVERIFY(!engine.errorString().isEmpty());
+    // 回退时不应留下半成品
+    QVERIFY(!QFile::exists(output));
+}
+
+void NativeDocxEngineTest::testMissingInput()
+{
+    NativeDocxEngine engine;
+    QCOMPARE(engine.convert(m_tempDir.filePath("no-such.md"),
+                            m_tempDir.filePath("no-such.docx")),
+             NativeDocxEngine::Failed);
+    QVERIFY(!engine.errorString().isEmpty());
+}
+
+void NativeDocxEngineTest::testInlineFormatting()
+{
+    QString input = writeMarkdown("inline", "**粗体** *斜体* `代码` \"引号\" a -- b --- c...\n");
+    QString output = convertNative(input);
+    QVERIFY(!output.isEmpty());
+
+    QString document = QString::fromUtf8(readPart(output, "word/document.xml"));
+    QVERIFY(document.contains("<w:b/>"));
+    QVERIFY(document.contains("<w:i/>"));
+    QVERIFY(document.contains("VerbatimChar"));
+
+    QStringList texts = paragraphs(readPart(output, "word/document.xml"));
+    QCOMPARE(texts.size(), 1);
+    QCOMPARE(texts.first(),
+             QString("BodyText\t粗体 斜体 代码 “引号” a – b — c…"));
+}
+
+void NativeDocxEngineTest::testListsAndTables()
+{
+    QString input = writeMarkdown("blocks",
+                                  "- 甲\n- 乙\n\n"
+                                  "1. 一\n2. 二\n\n"
+                                  "| 列1 | 列2 |\n|-----|:---:|\n| x | y |\n");
+    QString output = convertNative(input);
+    QVERIFY(!output.isEmpty());
+
+    QString document = QString::fromUtf8(readPart(output, "word/document.xml"));
+    QCOMPARE(document.count("<w:numPr>"), 4);
+    QCOMPARE(document.count("<w:tbl>"), 1);
+    QCOMPARE(document.count("</w:tr>"), 2);
+    QVERIFY(document.contains("<w:jc w:val=\"center\"/>"));
+
+    // 两个列表各自使用独立的编号定义
+    QString numbering = QString::fromUtf8(readPart(output, "word/numbering.xml"));
+    QCOMPARE(numbering.count("<w:num "), 2);
+
+    QStringList expected;
+    expected << "Compact\t甲" << "Compact\t乙" << "Compact\t一" << "Compact\t二"
+             << "Compact\t列1" << "Compact\t列2" << "Compact\tx" << "Compact\ty";
+    QCOMPARE(paragraphs(readPart(output, "word/document.xml")), expected);
+}
+
+void NativeDocxEngineTest::testFigure()
+{
+    QString input = writeMarkdown("figure", "![示例图片](pic.png)\n\n再次引用 ![](pic.png)\n");
+    QString output = convertNative(input);
+    QVERIFY(!output.isEmpty());
+
+    // 同一张图片只打包一次
+    ZipReader zip;
+    QVERIFY2(zip.open(output), qPrintable(zip.errorString()));
+    QStringList media = zip.entryNames().filter("word/media/");
+    QCOMPARE(media, QStringList() << "word/media/image1.png");
+    QCOMPARE(zip.fileData("word/media/image1.png").size(),
+             int(QFileInfo(m_tempDir.filePath("pic.png")).size()));
+
+    QString contentTypes = QString::fromUtf8(zip.fileData("[Content_Types].xml"));
+    QVERIFY(contentTypes.contains("Extension=\"png\""));
+
+    QStringList texts = paragraphs(zip.fileData("word/document.xml"));
+    QCOMPARE(texts.size(), 3);
+    QCOMPARE(texts.at(0), QString("CaptionedFigure\t"));
+    QCOMPARE(texts.at(1), QString("ImageCaption\t示例图片"));
+}
+
+void NativeDocxEngineTest::testMatchesPandoc_data()
+{
+    QTest::addColumn<QString>("markdown");
+
+    QTest::newRow("标题和段落") << "# 标题\n\n第一段\n第二行\n\n正文\n\n## 二级标题\n\n正文\n";
+    QTest::newRow("强调") << "这是**粗体**、*斜体*、`代码`和**嵌套*斜体*粗体**。\n";
+    QTest::newRow("智能引号") << "\"双引号\" 'single' it's -- --- ...\n";
+    QTest::newRow("硬换行") << "第一行  \n第二行\n";
+    QTest::newRow("列表") << "- 甲\n- 乙\n\n正文\n\n5. 五\n6. 六\n";
+    QTest::newRow("表格") << "| 名称 | 数量 | 说明 |\n|:-----|-----:|:----:|\n| a | 1 | x |\n| b | 2 | y |\n";
+    QTest::newRow("代码块") << "```\nline 1\n\tline 2\n```\n";
+    QTest::newRow("带题注的图") << "![示例图片](pic.png)\n";
+}
+
+void NativeDocxEngineTest::testMatchesPandoc()
+{
+    QFETCH(QString, markdown);
+    if (m_pandoc.isEmpty()) {
+        QSKIP("pandoc未安装，跳过对比测试");
+    }
+
+    QString input = writeMarkdown(QString("golden-%1").arg(QTest::currentDataTag()), markdown);
+    QString native = convertNative(input);
+    QVERIFY(!native.isEmpty());
+    verifyDocx(native);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    QString pandoc = convertPandoc(input);
+    QVERIFY(!pandoc.isEmpty());
+
+    QCOMPARE(paragraphs(readPart(native, "word/document.xml")),
+             paragraphs(readPart(pandoc, "word/document.xml")));
+}
+
+void NativeDocxEngineTest::testTestdataMatchesPandoc_data()
+{
+    QTest::addColumn<QString>("inputFile");
+
+    QDir testdata(MD2DOCX_TESTDATA_DIR);
+    const QStringList files = testdata.entryList(QStringList() << "*.md", QDir::Files, QDir::Name);
+    for (const QString &file : files) {
+        QTest::newRow(qPrintable(file)) << testdata.absoluteFilePath(file);
+    }
+}
+
+void NativeDocxEngineTest::testTestdataMatchesPandoc()
+{
+    QFETCH(QString, inputFile);
+
+    QString output = m_tempDir.filePath(QFileInfo(inputFile).completeBaseName() + ".native.docx");
+    NativeDocxEngine engine;
+    NativeDocxEngine::Status status = engine.convert(inputFile, output);
+    // 测试数据可以包含子集之外的语法，但不能出现读写失败
+    QVERIFY2(status != NativeDocxEngine::Failed, qPrintable(engine.errorString()));
+    if (status == NativeDocxEngine::Unsupported) {
+        QSKIP(qPrintable(QString("回退到pandoc: %1").arg(engine.errorString())));
+    }
+    verifyDocx(output);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    if (m_pandoc.isEmpty()) {
+        QSKIP("pandoc未安装，跳过对比测试");
+    }
+    QString pandoc = convertPandoc(inputFile);
+    QVERIFY(!pandoc.isEmpty());
+    QCOMPARE(paragraphs(readPart(output, "word/document.xml")),
+             paragraphs(readPart(pandoc, "word/document.xml")));
+}
+
+void NativeDocxEngineTest::testCorruptZip()
+{
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    ZipWriter writer(&buffer);
+    QVERIFY(writer.addFile("word/document.xml", QByteArray(1000, 'a')));
+    QVERIFY(writer.close());
+    const QByteArray archive = buffer.data();
+    const int central = archive.indexOf(QByteArray("PK\x01\x02", 4));
+    QVERIFY(central > 0);
+
+    auto openPatched = [&](int offset, const QByteArray &bytes, ZipReader *reader) {
+        QByteArray data = archive;
+        data.replace(central + offset, bytes.size(), bytes);
+        QString path = m_tempDir.filePath("corrupt.zip");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        file.write(data);
+        file.close();
+        return reader->open(path);
+    };
+
+    // 文件名长度超出文件末尾
+    ZipReader longName;
+    QVERIFY(!openPatched(28, QByteArray("\xff\xff", 2), &longName));
+
+    // 注释长度超出文件末尾
+    ZipReader longComment;
+    QVERIFY(!openPatched(32, QByteArray("\xff\xff", 2), &longComment));
+
+    // 声明的解压大小远超deflate的最大压缩比，不应按声明值分配内存
+    ZipReader hugeSize;
+    QVERIFY(openPatched(24, QByteArray("\xff\xff\xff\x7f", 4), &hugeSize));
+    QVERIFY(hugeSize.fileData("word/document.xml").isEmpty());
+
+    // 未损坏的归档可以正常读取
+    ZipReader intact;
+    QVERIFY(openPatched(0, QByteArray("PK", 2), &intact));
+    QCOMPARE(intact.fileData("word/document.xml"), QByteArray(1000, 'a'));
+}
+
+QString NativeDocxEngineTest::writeMarkdown(const QString &name, const QString &markdown)
+{
+    QString path = m_tempDir.filePath(name + ".md");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return QString();
+    }
+    file.write(markdown.toUtf8());
+    return path;
+}
+
+/**
+ * 使用本地引擎转换，失败时记录原因并返回空
+ */
+QString NativeDocxEngineTest::convertNative(const QString &inputFile)
+{
+    QString output = m_tempDir.filePath(QFileInfo(inputFile).completeBaseName() + ".native.docx");
+    NativeDocxEngine engine;
+    NativeDocxEngine::Status status = engine.convert(inputFile, output);
+    if (status != NativeDocxEngine::Converted) {
+        qWarning() << "本地引擎未能转换" << inputFile << engine.errorString();
+        return QString();
+    }
+    return output;
+}
+
+/**
+ * 使用pandoc转换，工作目录设为输入文件所在目录以便解析相对图片路径
+ */
+QString NativeDocxEngineTest::convertPandoc(const QString &inputFile)
+{
+    QFileInfo info(inputFile);
+    QString output = m_tempDir.filePath(info.completeBaseName() + ".pandoc.docx");
+
+    QProcess process;
+    process.setWorkingDirectory(info.absolutePath());
+    process.start(m_pandoc, QStringList() << info.fileName() << "-o" << output);
+    if (!process.waitForFinished(60000) || process.exitCode() != 0) {
+        qWarning() << "pandoc转换失败" << process.readAllStandardError();
+        return QString();
+    }
+    return output;
+}
+
+/**
+ * 检查输出是合法的docx：必需部件齐全，所有XML部件格式正确，
+ * 文档关系指向的内部部件都存在
+ */
+void NativeDocxEngineTest::verifyDocx(const QString &docxFile)
+{
+    ZipReader zip;
+    QVERIFY2(zip.open(docxFile), qPrintable(zip.errorString()));
+
+    const QStringList required = QStringList()
+        << "[Content_Types].xml" << "_rels/.rels" << "word/document.xml"
+        << "word/_rels/document.xml.rels" << "word/styles.xml";
+    for (const QString &part : required) {
+        QVERIFY2(zip.contains(part), qPrintable(QString("缺少部件: %1").arg(part)));
+    }
+
+    const QStringList names = zip.entryNames();
+    for (const QString &name : names) {
+        if (!name.endsWith(".xml") && !name.endsWith(".rels")) {
+            continue;
+        }
+        QByteArray data = zip.fileData(name);
+        QVERIFY2(!data.isEmpty(), qPrintable(QString("部件为空或无法解压: %1").arg(name)));
+        QXmlStreamReader xml(data);
+        while (!xml.atEnd()) {
+            xml.readNext();
+        }
+        QVERIFY2(!xml.hasError(),
+                 qPrintable(QString("%1 XML格式错误: %2").arg(name, xml.errorString())));
+    }
+
+    QXmlStreamReader rels(zip.fileData("word/_rels/document.xml.rels"));
+    while (!rels.atEnd()) {
+        if (rels.readNext() != QXmlStreamReader::StartElement ||
+            rels.name() != QLatin1String("Relationship") ||
+            rels.attributes().value("TargetMode") == QLatin1String("External")) {
+            continue;
+        }
+        QString target = "word/" + rels.attributes().value("Target").toString();
+        QVERIFY2(zip.contains(target), qPrintable(QString("关系目标不存在: %1").arg(target)));
+    }
+}
+
+QByteArray NativeDocxEngineTest::readPart(const QString &docxFile, const QString &part)
+{
+    ZipReader zip;
+    if (!zip.open(docxFile)) {
+        return QByteArray();
+    }
+    return zip.fileData(part);
+}
+
+/**
+ * 提取document.xml中每个段落的样式和文本，格式为"样式\t文本"
+ * 换行记为'\n'，制表符记为'\t'，用于与pandoc的输出逐段比较
+ */
+QStringList NativeDocxEngineTest::paragraphs(const QByteArray &documentXml)
+{
+    QStringList result;
+    QString style;
+    QString text;
+    bool inRun = false;
+
+    QXmlStreamReader xml(documentXml);
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isStartElement()) {
+            if (xml.qualifiedName() == QLatin1String("w:p")) {
+                style.clear();
+                text.clear();
+            } else if (xml.qualifiedName() == QLatin1String("w:r")) {
+                inRun = true;
+            } else if (xml.qualifiedName() == QLatin1String("w:pStyle")) {
+                style = xml.attributes().value("w:val").toString();
+            } else if (xml.qualifiedName() == QLatin1String("w:t")) {
+                text += xml.readElementText();
+            } else if (xml.qualifiedName() == QLatin1String("w:br")) {
+                text += '\n';
+            } else if (xml.qualifiedName() == QLatin1String("w:tab") && inRun) {
+                // 段落属性中的制表位不是文本
+                text += '\t';
+            }
+        } else if (xml.isEndElement()) {
+            if (xml.qualifiedName() == QLatin1String("w:r")) {
+                inRun = false;
+            } else if (xml.qualifiedName() == QLatin1String("w:p")) {
+                result.append(style + '\t' + text);
+            }
+        }
+    }
+    return result;
+}
+
+QTEST_GUILESS_MAIN(NativeDocxEngineTest)
+#include "native_docx_engine_test.moc"